@@ -26,6 +26,7 @@ http://www.cisst.org/cisst/license.txt.
 #include <cisstMultiTask/mtsManagerLocal.h>
 #include <sawRobotIO1394/mtsRobotIO1394.h>
 #include <sawRobotIO1394/mtsRobotIO1394QtWidgetFactory.h>
+#include <sawRobotIO1394/osaTrace1394.h>
 
 // Qt includes
 #include <QApplication>
@@ -46,6 +47,11 @@ int main(int argc, char ** argv)
     std::list<std::string> configFiles;
     std::string robotName = "Robot";
     double periodInSeconds = 1.0 * cmn_ms;
+    std::string cacheDirectory;
+    int cpu = -1;
+    int priority = 0;
+    std::string flightRecorderPrefix;
+    std::string traceFile;
     options.AddOptionMultipleValues("c", "config",
                                     "configuration file",
                                     cmnCommandLineOptions::REQUIRED_OPTION, &configFiles);
@@ -58,6 +64,23 @@ int main(int argc, char ** argv)
     options.AddOptionOneValue("i", "io-period",
                               "IO read/write period interval in seconds (default is 1 ms, 0.001)",
                               cmnCommandLineOptions::OPTIONAL_OPTION, &periodInSeconds);
+    options.AddOptionOneValue("C", "cache",
+                              "directory used to cache parsed configuration files for faster restarts",
+                              cmnCommandLineOptions::OPTIONAL_OPTION, &cacheDirectory);
+    options.AddOptionOneValue("A", "cpu",
+                              "pin IO thread to given CPU",
+                              cmnCommandLineOptions::OPTIONAL_OPTION, &cpu);
+    options.AddOptionOneValue("P", "priority",
+                              "use SCHED_FIFO with given priority for IO thread (Linux only)",
+                              cmnCommandLineOptions::OPTIONAL_OPTION, &priority);
+    options.AddOptionNoValue("L", "lock-memory",
+                             "lock memory to avoid page faults (Linux only)");
+    options.AddOptionOneValue("R", "flight-recorder",
+                              "save last 1000 cycles in files with given prefix when IO cycle overruns",
+                              cmnCommandLineOptions::OPTIONAL_OPTION, &flightRecorderPrefix);
+    options.AddOptionOneValue("T", "trace",
+                              "record timeline of IO threads, last seconds are saved on exit (Chrome trace JSON, open with ui.perfetto.dev)",
+                              cmnCommandLineOptions::OPTIONAL_OPTION, &traceFile);
 
     std::string errorMessage;
     if (!options.Parse(argc, argv, errorMessage)) {
@@ -76,6 +99,17 @@ int main(int argc, char ** argv)
     mtsRobotIO1394 * robotIO = new mtsRobotIO1394("robotIO", periodInSeconds, port);
     mtsRobotIO1394QtWidgetFactory * robotWidgetFactory = new mtsRobotIO1394QtWidgetFactory("robotWidgetFactory");
 
+    robotIO->UseConfigurationCache(cacheDirectory);
+    robotIO->SetRealTimeCPU(cpu);
+    robotIO->SetRealTimePriority(priority);
+    robotIO->SetRealTimeLockMemory(options.IsSet("lock-memory"));
+    if (!flightRecorderPrefix.empty()) {
+        robotIO->UseFlightRecorder(flightRecorderPrefix);
+    }
+    if (!traceFile.empty()) {
+        sawRobotIO1394::osaTrace1394::SetThreadName("main");
+        sawRobotIO1394::osaTrace1394::Enable(true);
+    }
     componentManager->AddComponent(robotIO);
     componentManager->AddComponent(robotWidgetFactory);
 
@@ -103,6 +137,12 @@ int main(int argc, char ** argv)
     componentManager->KillAllAndWait(2.0 * cmn_s);
     componentManager->Cleanup();
 
+    // last seconds of IO timeline
+    if (!traceFile.empty()) {
+        sawRobotIO1394::osaTrace1394::Enable(false);
+        sawRobotIO1394::osaTrace1394::Save(traceFile);
+    }
+
     // delete dvgc robot
     delete robotWidgetFactory;
     delete robotIO;
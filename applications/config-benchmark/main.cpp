@@ -0,0 +1,108 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  Author(s):  Anton Deguet
+  Created on: 2021-06-14
+
+  (C) Copyright 2021 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+// system
+#include <iostream>
+#include <sstream>
+// cisst/saw
+#include <cisstCommon/cmnPath.h>
+#include <cisstCommon/cmnLogger.h>
+#include <cisstCommon/cmnTypeTraits.h>
+#include <cisstCommon/cmnCommandLineOptions.h>
+#include <cisstOSAbstraction/osaGetTime.h>
+#include <sawRobotIO1394/osaXML1394.h>
+
+using namespace sawRobotIO1394;
+
+typedef void (*LoaderType)(const std::string &, osaPort1394Configuration &);
+
+// load the same file multiple times, report timing and keep last result
+static void Benchmark(const std::string & name, LoaderType loader,
+                      const std::string & configFile, const int iterations,
+                      osaPort1394Configuration & result)
+{
+    double minimum = cmnTypeTraits<double>::MaxPositiveValue();
+    double total = 0.0;
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        osaPort1394Configuration config;
+        const double start = osaGetTime();
+        loader(configFile, config);
+        const double elapsed = osaGetTime() - start;
+        total += elapsed;
+        if (elapsed < minimum) {
+            minimum = elapsed;
+        }
+        result = config;
+    }
+    std::cout << name << ": " << iterations << " iteration(s), average "
+              << (total / iterations) * 1000.0 << " ms, minimum "
+              << minimum * 1000.0 << " ms" << std::endl;
+}
+
+int main(int argc, char * argv[])
+{
+    // log configuration, errors only since each file is loaded many times
+    cmnLogger::SetMask(CMN_LOG_ALLOW_ALL);
+    cmnLogger::SetMaskDefaultLog(CMN_LOG_ALLOW_ERRORS);
+    cmnLogger::AddChannel(std::cerr, CMN_LOG_ALLOW_ERRORS);
+
+    cmnCommandLineOptions options;
+    std::string configFile;
+    int iterations = 20;
+    options.AddOptionOneValue("c", "config",
+                              "configuration file",
+                              cmnCommandLineOptions::REQUIRED_OPTION, &configFile);
+    options.AddOptionOneValue("n", "iterations",
+                              "number of times each loader parses the file (default 20)",
+                              cmnCommandLineOptions::OPTIONAL_OPTION, &iterations);
+
+    std::string errorMessage;
+    if (!options.Parse(argc, argv, errorMessage)) {
+        std::cerr << "Error: " << errorMessage << std::endl;
+        options.PrintUsage(std::cerr);
+        return -1;
+    }
+
+    if (!cmnPath::Exists(configFile)) {
+        std::cerr << "Can't find file \"" << configFile << "\"." << std::endl;
+        return -1;
+    }
+    if (iterations < 1) {
+        iterations = 1;
+    }
+    std::cout << "Configuration file: " << configFile << std::endl;
+
+    osaPort1394Configuration configXPath, configDefault;
+    Benchmark("XPath loader  ", osaXML1394ConfigurePortXPath, configFile, iterations, configXPath);
+    Benchmark("Default loader", osaXML1394ConfigurePort, configFile, iterations, configDefault);
+
+    // make sure both loaders agree
+    std::stringstream resultXPath, resultDefault;
+    configXPath.ToStream(resultXPath);
+    configDefault.ToStream(resultDefault);
+    if (resultXPath.str() != resultDefault.str()) {
+        std::cerr << "Error: loaders don't produce the same configuration" << std::endl;
+        return -1;
+    }
+    std::cout << "Both loaders produce the same configuration ("
+              << configDefault.Robots.size() << " robot(s), "
+              << configDefault.DigitalInputs.size() << " digital input(s), "
+              << configDefault.DigitalOutputs.size() << " digital output(s), "
+              << configDefault.DallasChips.size() << " Dallas chip(s))" << std::endl;
+    return 0;
+}
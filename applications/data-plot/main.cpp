@@ -5,7 +5,7 @@
   Author(s):  Anton Deguet
   Created on: 2014-01-09
 
-  (C) Copyright 2014-2018 Johns Hopkins University (JHU), All Rights Reserved.
+  (C) Copyright 2014-2021 Johns Hopkins University (JHU), All Rights Reserved.
 
 --- begin cisst license - do not edit ---
 
@@ -40,6 +40,7 @@ int main(int argc, char * argv[])
     cmnCommandLineOptions options;
     std::string portName = mtsRobotIO1394::DefaultPort();
     int actuatorIndex = 0;
+    double periodInMilliseconds = 0.0;
     std::string configFile;
     options.AddOptionOneValue("c", "config",
                               "configuration file",
@@ -47,6 +48,9 @@ int main(int argc, char * argv[])
     options.AddOptionOneValue("a", "actuator",
                               "actuator index",
                               cmnCommandLineOptions::OPTIONAL_OPTION, &actuatorIndex);
+    options.AddOptionOneValue("r", "period",
+                              "acquisition period in milliseconds, 0 for full bus rate (default)",
+                              cmnCommandLineOptions::OPTIONAL_OPTION, &periodInMilliseconds);
     options.AddOptionOneValue("p", "port",
                               "firewire port number(s)",
                               cmnCommandLineOptions::OPTIONAL_OPTION, &portName);
@@ -90,8 +94,16 @@ int main(int argc, char * argv[])
     // preload encoders
     robot->CalibrateEncoderOffsetsFromPots();
 
+    if ((actuatorIndex < 0)
+        || (static_cast<size_t>(actuatorIndex) >= robot->NumberOfActuators())) {
+        std::cerr << "Error: actuator index must be between 0 and "
+                  << robot->NumberOfActuators() - 1 << std::endl;
+        return -1;
+    }
+
     QApplication application(argc, argv);
-    plotObject * plot = new plotObject(port, robot, actuatorIndex);
+    plotObject * plot = new plotObject(port, robot, actuatorIndex,
+                                       periodInMilliseconds * cmn_ms);
 
     application.exec();
 
@@ -5,7 +5,7 @@
   Author(s):  Anton Deguet
   Created on: 2014-01-09
 
-  (C) Copyright 2014-2020 Johns Hopkins University (JHU), All Rights Reserved.
+  (C) Copyright 2014-2021 Johns Hopkins University (JHU), All Rights Reserved.
 
 --- begin cisst license - do not edit ---
 
@@ -19,15 +19,100 @@ http://www.cisst.org/cisst/license.txt.
 
 #include "plotObject.h"
 #include <cisstNumerical/nmrSavitzkyGolay.h>
+#include <cisstOSAbstraction/osaGetTime.h>
+#include <cisstOSAbstraction/osaSleep.h>
+
+#include <QLabel>
+
+const char * plotSignal::Name(const plotSignal::Type signal)
+{
+    switch (signal) {
+    case ENCODER_VELOCITY:
+        return "encoder-dt";
+    case ENCODER_DX:
+        return "encoder-dx";
+    case ENCODER_DX_FILTERED:
+        return "encoder-dx-filtered";
+    case POT_DX:
+        return "pot-dx";
+    case CURRENT_FEEDBACK:
+        return "current-feedback";
+    case ENCODER_ACCELERATION:
+        return "encoder-acceleration";
+    default:
+        break;
+    }
+    return "undefined";
+}
+
+void plotSample::SetSize(const size_t numberOfActuators)
+{
+    Time.SetSize(numberOfActuators);
+    Time.SetAll(0.0);
+    for (size_t signal = 0; signal < plotSignal::NUMBER_OF_SIGNALS; ++signal) {
+        Values[signal].SetSize(numberOfActuators);
+        Values[signal].SetAll(0.0);
+    }
+}
+
+plotSampleRing::plotSampleRing(const size_t capacity, const size_t numberOfActuators):
+    mSamples(capacity),
+    mHead(0),
+    mTail(0),
+    mOverflows(0)
+{
+    for (auto & sample : mSamples) {
+        sample.SetSize(numberOfActuators);
+    }
+}
+
+plotSample * plotSampleRing::Reserve(void)
+{
+    const size_t head = mHead.load(std::memory_order_relaxed);
+    const size_t next = (head + 1) % mSamples.size();
+    if (next == mTail.load(std::memory_order_acquire)) {
+        mOverflows.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+    return &(mSamples[head]);
+}
+
+void plotSampleRing::Publish(void)
+{
+    const size_t head = mHead.load(std::memory_order_relaxed);
+    mHead.store((head + 1) % mSamples.size(), std::memory_order_release);
+}
+
+const plotSample * plotSampleRing::Front(void) const
+{
+    const size_t tail = mTail.load(std::memory_order_relaxed);
+    if (tail == mHead.load(std::memory_order_acquire)) {
+        return 0;
+    }
+    return &(mSamples[tail]);
+}
+
+void plotSampleRing::Pop(void)
+{
+    const size_t tail = mTail.load(std::memory_order_relaxed);
+    mTail.store((tail + 1) % mSamples.size(), std::memory_order_release);
+}
 
 plotObject::plotObject(mtsRobotIO1394 * port,
                        mtsRobot1394 * robot,
-                       int actuatorIndex):
+                       int actuatorIndex,
+                       double periodInSeconds):
     mPort(port),
     mRobot(robot),
+    mNumberOfActuators(robot->NumberOfActuators()),
     mActuatorIndex(actuatorIndex),
-    mElapsedTime(0.0),
-    mFilterSize(6)
+    mAcquisitionRunning(false),
+    mPeriod(periodInSeconds),
+    mReadErrors(0),
+    // enough room for a couple of seconds at full bus rate
+    mRing(8192, robot->NumberOfActuators()),
+    mFilterSize(6),
+    mFilterIndex(0)
 {
     mSavitzkyGolayCoeff = nmrSavitzkyGolay(2, // 4 degrees polynomial
                                           0, // no derivative
@@ -35,86 +120,187 @@ plotObject::plotObject(mtsRobotIO1394 * port,
                                           0 // nb right samples
                                           );
 
-    mHistory.SetSize(mFilterSize);
+    mHistory.SetSize(mFilterSize, mNumberOfActuators);
     mHistory.SetAll(0.0);
-    mFilterElementwiseProduct.SetSize(mFilterSize);
 
     mFrame = new QFrame();
     mLayout = new QVBoxLayout();
 
-    mPlot = new vctPlot2DOpenGLQtWidget();
-    mLayout->addWidget(mPlot);
+    // actuator and signal selection
+    QHBoxLayout * selectionLayout = new QHBoxLayout();
+    selectionLayout->addWidget(new QLabel("Actuator"));
+    QSBActuatorIndex = new QSpinBox();
+    QSBActuatorIndex->setRange(0, static_cast<int>(mNumberOfActuators) - 1);
+    QSBActuatorIndex->setValue(mActuatorIndex);
+    selectionLayout->addWidget(QSBActuatorIndex);
+    connect(QSBActuatorIndex, SIGNAL(valueChanged(int)),
+            this, SLOT(SlotActuatorIndex(int)));
 
+    mPlot = new vctPlot2DOpenGLQtWidget();
     mVelocityScale = mPlot->AddScale("encoder-velocities");
 
-    mEncoderDtSignal = mVelocityScale->AddSignal("encoder-dt");
-    mEncoderDtSignal->SetColor(vct3(1.0, 0.0, 0.0));
-    std::cout << "red:   encoder-dt" << std::endl;
-
-    mEncoderDxSignal = mVelocityScale->AddSignal("encoder-dx");
-    mEncoderDxSignal->SetColor(vct3(0.0, 1.0, 0.0));
-    std::cout << "green: encoder-dx" << std::endl;
-
-    mEncoderDxFilteredSignal = mVelocityScale->AddSignal("encoder-dx-filtered");
-    mEncoderDxFilteredSignal->SetColor(vct3(7.0, 7.0, 0.0));
-    std::cout << "yellow: encoder-dx-filtered" << std::endl;
-
-    mPotDxSignal = mVelocityScale->AddSignal("pot-dx");
-    mPotDxSignal->SetColor(vct3(1.0, 1.0, 1.0));
-    std::cout << "white: pot-dx" << std::endl;
+    const vct3 colors[plotSignal::NUMBER_OF_SIGNALS] = {vct3(1.0, 0.0, 0.0),  // red
+                                                        vct3(0.0, 1.0, 0.0),  // green
+                                                        vct3(0.7, 0.7, 0.0),  // yellow
+                                                        vct3(1.0, 1.0, 1.0),  // white
+                                                        vct3(0.0, 0.7, 1.0),  // blue
+                                                        vct3(1.0, 0.0, 1.0)}; // magenta
+    for (size_t index = 0; index < plotSignal::NUMBER_OF_SIGNALS; ++index) {
+        const char * name = plotSignal::Name(static_cast<plotSignal::Type>(index));
+        mSignals[index] = mVelocityScale->AddSignal(name);
+        mSignals[index]->SetColor(colors[index]);
+        QCBSignals[index] = new QCheckBox(name);
+        QCBSignals[index]->setStyleSheet(QString("color: rgb(%1, %2, %3)")
+                                         .arg(static_cast<int>(colors[index][0] * 255.0))
+                                         .arg(static_cast<int>(colors[index][1] * 255.0))
+                                         .arg(static_cast<int>(colors[index][2] * 255.0)));
+        selectionLayout->addWidget(QCBSignals[index]);
+        connect(QCBSignals[index], SIGNAL(toggled(bool)),
+                this, SLOT(SlotSignalVisible(bool)));
+    }
+    // by default, same signals as before
+    for (size_t index = 0; index <= plotSignal::POT_DX; ++index) {
+        QCBSignals[index]->setChecked(true);
+    }
+    SlotSignalVisible(true);
 
     mZeroVelocity = mVelocityScale->AddSignal("zero");
     mZeroVelocity->SetColor(vct3(0.2, 0.2, 0.2));
-    std::cout << "gray:  zero" << std::endl;
+
+    selectionLayout->addStretch();
+    mLayout->addLayout(selectionLayout);
+    mLayout->addWidget(mPlot);
 
     mFrame->setLayout(mLayout);
     mFrame->resize(1200, 600);
     mFrame->show();
 
+    mDroppedSample.SetSize(mNumberOfActuators);
+    mElapsedTime.SetSize(mNumberOfActuators);
+    mElapsedTime.SetAll(0.0);
     mPreviousEncoderPosition.ForceAssign(mRobot->ActuatorJointState().Position());
     mPreviousPotPosition.ForceAssign(mRobot->PotPosition());
 
-    startTimer(0); // in ms, 0 is as fast as possible
+    // acquisition runs in its own thread, GUI only drains the ring
+    mAcquisitionRunning = true;
+    mAcquisitionThread.Create<plotObject, int>(this, &plotObject::AcquisitionLoop, 0, "plot-acquisition");
+
+    startTimer(20); // in ms, redraw rate independent of acquisition rate
 }
 
-void plotObject::timerEvent(QTimerEvent * CMN_UNUSED(event))
+plotObject::~plotObject()
+{
+    mAcquisitionRunning = false;
+    mAcquisitionThread.Wait();
+    if (mRing.Overflows() != 0) {
+        std::cerr << "Warning: " << mRing.Overflows()
+                  << " sample(s) dropped, GUI could not keep up" << std::endl;
+    }
+    if (mReadErrors != 0) {
+        std::cerr << "Warning: " << mReadErrors << " read error(s)" << std::endl;
+    }
+}
+
+void * plotObject::AcquisitionLoop(int CMN_UNUSED(unused))
+{
+    double nextRead = osaGetTime();
+    while (mAcquisitionRunning) {
+        try {
+            mPort->Read();
+        } catch (const std::runtime_error & CMN_UNUSED(e)) {
+            ++mReadErrors;
+        }
+        plotSample * sample = mRing.Reserve();
+        if (sample) {
+            Acquire(*sample);
+            mRing.Publish();
+        } else {
+            // ring is full, still update filter and previous positions
+            Acquire(mDroppedSample);
+        }
+        // period of 0 means as fast as the bus allows
+        if (mPeriod > 0.0) {
+            nextRead += mPeriod;
+            const double sleepTime = nextRead - osaGetTime();
+            if (sleepTime > 0.0) {
+                osaSleep(sleepTime);
+            } else {
+                nextRead = osaGetTime();
+            }
+        }
+    }
+    return 0;
+}
+
+void plotObject::Acquire(plotSample & sample)
 {
-    mPort->Read();
-    // get time and plot 0 value
-    mElapsedTime += mRobot->ActuatorTimeStamp()[mActuatorIndex];
-    mZeroVelocity->AppendPoint(vct2(mElapsedTime, 0.005)); // slight offset to avoid overlap
+    const vctDoubleVec & timestamps = mRobot->ActuatorTimeStamp();
+    const prmStateJoint & state = mRobot->ActuatorJointState();
+    const vctDoubleVec & pots = mRobot->PotPosition();
+
+    mElapsedTime.Add(timestamps);
+    sample.Time.Assign(mElapsedTime);
 
     // encoder dt
-    mEncoderDtSignal->AppendPoint(vct2(mElapsedTime,
-                                       mRobot->ActuatorJointState().Velocity()[mActuatorIndex]));
+    sample.Values[plotSignal::ENCODER_VELOCITY].Assign(state.Velocity());
+
     // encoder velocity dx / dt
-    mEncoderDx.ForceAssign(mRobot->ActuatorJointState().Position());
-    mEncoderDx.Subtract(mPreviousEncoderPosition);
-    mEncoderDx.ElementwiseDivide(mRobot->ActuatorTimeStamp());
-    mEncoderDxSignal->AppendPoint((vct2(mElapsedTime,
-                                        mEncoderDx[mActuatorIndex])));
-
-    // filtered dx / dt
-    // update history
-    for (size_t index = 1; index < mFilterSize; ++index) {
-        mHistory[index - 1] = mHistory[index];
+    vctDoubleVec & encoderDx = sample.Values[plotSignal::ENCODER_DX];
+    encoderDx.DifferenceOf(state.Position(), mPreviousEncoderPosition);
+    encoderDx.ElementwiseDivide(timestamps);
+
+    // filtered dx / dt, overwrite oldest sample in circular history
+    mHistory.Row(mFilterIndex).Assign(encoderDx);
+    mFilterIndex = (mFilterIndex + 1) % mFilterSize;
+    vctDoubleVec & filtered = sample.Values[plotSignal::ENCODER_DX_FILTERED];
+    filtered.SetAll(0.0);
+    for (size_t index = 0; index < mFilterSize; ++index) {
+        // mFilterIndex now points to oldest sample, i.e. first coefficient
+        filtered.AddProductOf(mSavitzkyGolayCoeff[index],
+                              mHistory.Row((mFilterIndex + index) % mFilterSize));
     }
-    mHistory[mFilterSize - 1] = mEncoderDx[mActuatorIndex];
-    // apply filter
-    mFilterElementwiseProduct.ElementwiseProductOf(mSavitzkyGolayCoeff, mHistory);
-    mEncoderDxFilteredSignal->AppendPoint(vct2(mElapsedTime, mFilterElementwiseProduct.SumOfElements()));
 
     // pot velocity dx / dt
-    mPotDx.ForceAssign(mRobot->PotPosition());
-    mPotDx.Subtract(mPreviousPotPosition);
-    mPotDx.ElementwiseDivide(mRobot->ActuatorTimeStamp());
-    mPotDxSignal->AppendPoint((vct2(mElapsedTime,
-                                    mPotDx[mActuatorIndex])));
+    vctDoubleVec & potDx = sample.Values[plotSignal::POT_DX];
+    potDx.DifferenceOf(pots, mPreviousPotPosition);
+    potDx.ElementwiseDivide(timestamps);
 
-    // update plot
-    mPlot->update();
+    sample.Values[plotSignal::CURRENT_FEEDBACK].Assign(mRobot->ActuatorCurrentFeedback());
+    sample.Values[plotSignal::ENCODER_ACCELERATION].Assign(mRobot->ActuatorEncoderAcceleration());
 
     // save previous state
-    mPreviousEncoderPosition.Assign(mRobot->ActuatorJointState().Position());
-    mPreviousPotPosition.Assign(mRobot->PotPosition());
+    mPreviousEncoderPosition.Assign(state.Position());
+    mPreviousPotPosition.Assign(pots);
+}
+
+void plotObject::timerEvent(QTimerEvent * CMN_UNUSED(event))
+{
+    // drain all samples available and redraw once
+    const size_t actuator = mActuatorIndex;
+    bool newData = false;
+    const plotSample * sample;
+    while ((sample = mRing.Front())) {
+        const double time = sample->Time[actuator];
+        mZeroVelocity->AppendPoint(vct2(time, 0.005)); // slight offset to avoid overlap
+        for (size_t index = 0; index < plotSignal::NUMBER_OF_SIGNALS; ++index) {
+            mSignals[index]->AppendPoint(vct2(time, sample->Values[index][actuator]));
+        }
+        mRing.Pop();
+        newData = true;
+    }
+    if (newData) {
+        mPlot->update();
+    }
+}
+
+void plotObject::SlotActuatorIndex(int index)
+{
+    mActuatorIndex = index;
+}
+
+void plotObject::SlotSignalVisible(bool CMN_UNUSED(visible))
+{
+    for (size_t index = 0; index < plotSignal::NUMBER_OF_SIGNALS; ++index) {
+        mSignals[index]->SetVisible(QCBSignals[index]->isChecked());
+    }
 }
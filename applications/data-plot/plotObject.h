@@ -22,54 +22,118 @@ http://www.cisst.org/cisst/license.txt.
 
 // system
 #include <iostream>
+#include <atomic>
+#include <vector>
 
 // cisst/saw
+#include <cisstOSAbstraction/osaThread.h>
 #include <sawRobotIO1394/mtsRobotIO1394.h>
 #include <sawRobotIO1394/mtsRobot1394.h>
 
 // Qt
 #include <QFrame>
 #include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QSpinBox>
+#include <QCheckBox>
 #include <cisstVector/vctPlot2DOpenGLQtWidget.h>
 
 using namespace sawRobotIO1394;
 
+// signals that can be plotted, values are recorded for all actuators
+namespace plotSignal {
+    typedef enum {
+        ENCODER_VELOCITY = 0, // velocity computed on FPGA
+        ENCODER_DX,           // encoder dx / dt
+        ENCODER_DX_FILTERED,  // encoder dx / dt with Savitzky Golay filter
+        POT_DX,               // pot dx / dt
+        CURRENT_FEEDBACK,     // measured current
+        ENCODER_ACCELERATION, // acceleration computed on FPGA
+        NUMBER_OF_SIGNALS
+    } Type;
+    const char * Name(const Type signal);
+}
+
+// one sample for all actuators, preallocated so acquisition doesn't allocate
+class plotSample {
+public:
+    void SetSize(const size_t numberOfActuators);
+    vctDoubleVec Time; // elapsed time per actuator, based on FPGA timestamps
+    vctDoubleVec Values[plotSignal::NUMBER_OF_SIGNALS];
+};
+
+// single producer (acquisition thread), single consumer (GUI thread) ring
+class plotSampleRing {
+public:
+    plotSampleRing(const size_t capacity, const size_t numberOfActuators);
+    // producer side, returns 0 if the ring is full
+    plotSample * Reserve(void);
+    void Publish(void);
+    // consumer side, returns 0 if the ring is empty
+    const plotSample * Front(void) const;
+    void Pop(void);
+    inline size_t Overflows(void) const {
+        return mOverflows.load(std::memory_order_relaxed);
+    }
+protected:
+    std::vector<plotSample> mSamples;
+    std::atomic<size_t> mHead; // next slot written by producer
+    std::atomic<size_t> mTail; // next slot read by consumer
+    std::atomic<size_t> mOverflows;
+};
+
 class plotObject: public QObject
 {
     Q_OBJECT;
 public:
     plotObject(mtsRobotIO1394 * port,
                mtsRobot1394 * robot,
-               int actuatorIndex);
+               int actuatorIndex,
+               double periodInSeconds);
+    ~plotObject();
 
 private slots:
     void timerEvent(QTimerEvent * CMN_UNUSED(event));
+    void SlotActuatorIndex(int index);
+    void SlotSignalVisible(bool visible);
 
 protected:
+    // runs in acquisition thread
+    void * AcquisitionLoop(int CMN_UNUSED(unused));
+    void Acquire(plotSample & sample);
+
     QFrame * mFrame;
     QVBoxLayout * mLayout;
+    QSpinBox * QSBActuatorIndex;
+    QCheckBox * QCBSignals[plotSignal::NUMBER_OF_SIGNALS];
     vctPlot2DOpenGLQtWidget * mPlot;
     vctPlot2DBase::Scale * mVelocityScale;
     vctPlot2DBase::Signal * mZeroVelocity;
-    vctPlot2DBase::Signal * mEncoderDtSignal;
-    vctPlot2DBase::Signal * mEncoderDxSignal;
-    vctPlot2DBase::Signal * mEncoderDxFilteredSignal;
-    vctPlot2DBase::Signal * mPotDxSignal;
+    vctPlot2DBase::Signal * mSignals[plotSignal::NUMBER_OF_SIGNALS];
 
     mtsRobotIO1394 * mPort;
     mtsRobot1394 * mRobot;
+    size_t mNumberOfActuators;
     int mActuatorIndex;
 
-    double mElapsedTime;
+    // acquisition thread
+    osaThread mAcquisitionThread;
+    std::atomic<bool> mAcquisitionRunning;
+    double mPeriod;
+    size_t mReadErrors;
+    plotSampleRing mRing;
+
+    // data only used by acquisition thread
+    plotSample mDroppedSample;
+    vctDoubleVec mElapsedTime;
     vctDoubleVec mPreviousEncoderPosition;
-    vctDoubleVec mEncoderDx;
     vctDoubleVec mPreviousPotPosition;
-    vctDoubleVec mPotDx;
 
+    // Savitzky Golay filter on encoder dx / dt, circular history per actuator
     size_t mFilterSize;
+    size_t mFilterIndex;
     vctDoubleVec mSavitzkyGolayCoeff;
-    vctDoubleVec mHistory;
-    vctDoubleVec mFilterElementwiseProduct;
+    vctDoubleMat mHistory; // one row per sample, one column per actuator
 };
 
 #endif // _plotObject_h
@@ -0,0 +1,149 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  Author(s):  Anton Deguet
+  Created on: 2021-07-23
+
+  (C) Copyright 2021 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#include <algorithm>
+
+#include "osaFakeBoards1394.h"
+#include "osaFakePort1394.h"
+
+using namespace sawRobotIO1394;
+
+namespace {
+    // axes per FPGA/QLA board
+    const size_t AxesPerBoard = 4;
+    // boards per port, same as mtsRobotIO1394::MAX_BOARDS
+    const size_t BoardsPerPort = 16;
+}
+
+osaFakeBoards1394::osaFakeBoards1394()
+{
+}
+
+osaFakeBoards1394::~osaFakeBoards1394()
+{
+}
+
+int osaFakeBoards1394::NewBoard(void)
+{
+    // board key, port index * BoardsPerPort + board Id
+    return static_cast<int>(mNumberOfBoards++);
+}
+
+std::vector<BasePort *> osaFakeBoards1394::Ports(void) const
+{
+    std::vector<BasePort *> ports;
+    for (size_t first = 0; first < mNumberOfBoards; first += BoardsPerPort) {
+        const size_t numberOfBoards = std::min(BoardsPerPort, mNumberOfBoards - first);
+        ports.push_back(new osaFakePort1394(static_cast<int>(ports.size()),
+                                            static_cast<unsigned int>(numberOfBoards)));
+    }
+    return ports;
+}
+
+osaRobot1394Configuration osaFakeBoards1394::RobotConfiguration(const std::string & name,
+                                                                const size_t numberOfActuators,
+                                                                const bool coupling,
+                                                                const bool brakes)
+{
+    osaRobot1394Configuration config;
+    config.Name = name;
+    config.NumberOfActuators = static_cast<int>(numberOfActuators);
+    config.NumberOfJoints = static_cast<int>(numberOfActuators);
+    config.SerialNumber = 0;
+    config.NumberOfBrakes = brakes ? static_cast<int>(numberOfActuators) : 0;
+    config.PotLocation = osaPot1394Location::POTENTIOMETER_ON_ACTUATORS;
+
+    // typical dVRK values, conversions are the same for all values
+    int actuatorBoard = -1;
+    int brakeBoard = -1;
+    for (size_t index = 0; index < numberOfActuators; ++index) {
+        if ((index % AxesPerBoard) == 0) {
+            actuatorBoard = NewBoard();
+        }
+        osaActuator1394Configuration actuator;
+        actuator.BoardID = actuatorBoard;
+        actuator.AxisID = static_cast<int>(index % AxesPerBoard);
+        actuator.JointType = PRM_JOINT_REVOLUTE;
+        actuator.Drive.EffortToCurrent.Scale = 1.0 / 0.0438;
+        actuator.Drive.CurrentToBits.Scale = 5242.8;
+        actuator.Drive.CurrentToBits.Offset = 32768.0;
+        actuator.Drive.BitsToCurrent.Scale = 1.0 / 5242.8;
+        actuator.Drive.BitsToCurrent.Offset = -32768.0 / 5242.8;
+        actuator.Drive.EffortCommandLimit = 0.1;
+        actuator.Drive.CurrentCommandLimit = 1.0;
+        actuator.Encoder.BitsToPosition.Scale = 360.0 / 4000.0;
+        actuator.Encoder.BitsToPosition.Unit = "deg";
+        actuator.Pot.BitsToVoltage.Scale = 4.5 / 65536.0;
+        actuator.Pot.VoltageToPosition.Scale = 90.0;
+        actuator.Pot.VoltageToPosition.Offset = -180.0;
+        actuator.Pot.VoltageToPosition.Unit = "deg";
+        if (brakes) {
+            osaAnalogBrake1394Configuration * brake = new osaAnalogBrake1394Configuration;
+            mBrakes.emplace_back(brake);
+            brake->BoardID = -1; // set once all actuator boards are created
+            brake->AxisID = actuator.AxisID;
+            brake->Drive = actuator.Drive;
+            brake->ReleaseCurrent = 0.3;
+            brake->ReleaseTime = 0.5;
+            brake->ReleasedCurrent = 0.08;
+            brake->EngagedCurrent = 0.0;
+            actuator.Brake = brake;
+        }
+        config.Actuators.push_back(actuator);
+
+        // 0 disables pot/encoder check for this axis
+        osaPotTolerance1394Configuration tolerance;
+        tolerance.AxisID = static_cast<int>(index);
+        tolerance.Distance = 0.0;
+        tolerance.Latency = 0.0;
+        config.PotTolerances.push_back(tolerance);
+    }
+
+    config.HasActuatorToJointCoupling = coupling;
+    if (coupling) {
+        // lower triangular, similar to dVRK MTM last joints
+        vctDoubleMat actuatorToJoint(numberOfActuators, numberOfActuators, 0.0);
+        for (size_t row = 0; row < numberOfActuators; ++row) {
+            actuatorToJoint.Element(row, row) = 1.0;
+            if (row > 0) {
+                actuatorToJoint.Element(row, row - 1) = -1.0;
+            }
+        }
+        vctDoubleMat jointToActuator(numberOfActuators, numberOfActuators, 0.0);
+        for (size_t row = 0; row < numberOfActuators; ++row) {
+            for (size_t col = 0; col <= row; ++col) {
+                jointToActuator.Element(row, col) = 1.0;
+            }
+        }
+        config.Coupling.ActuatorToJointPosition().ForceAssign(actuatorToJoint);
+        config.Coupling.JointToActuatorPosition().ForceAssign(jointToActuator);
+        config.Coupling.ActuatorToJointEffort().ForceAssign(jointToActuator.Transpose());
+        config.Coupling.JointToActuatorEffort().ForceAssign(actuatorToJoint.Transpose());
+    }
+    // brakes on separate boards, after the actuator boards
+    for (size_t index = 0; index < config.Actuators.size(); ++index) {
+        if (!config.Actuators[index].Brake) {
+            continue;
+        }
+        if ((index % AxesPerBoard) == 0) {
+            brakeBoard = NewBoard();
+        }
+        config.Actuators[index].Brake->BoardID = brakeBoard;
+    }
+    return config;
+}
@@ -0,0 +1,68 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  Author(s):  Anton Deguet
+  Created on: 2021-07-23
+
+  (C) Copyright 2021 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#ifndef _osaFakeBoards1394_h
+#define _osaFakeBoards1394_h
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sawRobotIO1394/osaConfiguration1394.h>
+#include <sawRobotIO1394/sawRobotIO1394ForwardDeclarations.h>
+
+namespace sawRobotIO1394 {
+
+    /*! Configurations and ports for benchmarks.  Robot
+      configurations use 4 axes per board and brakes on separate
+      boards, like the dVRK controllers.  Boards are numbered in
+      order of creation and spread on as many osaFakePort1394 ports
+      as needed, 16 boards per port. */
+    class osaFakeBoards1394
+    {
+    public:
+        osaFakeBoards1394();
+        ~osaFakeBoards1394();
+
+        /*! Build a robot configuration using new boards.  Board Ids
+          are board keys (port index * 16 + board Id), as expected by
+          mtsRobotIO1394::AddRobot.  Brake configurations are owned by
+          this object so it must outlive the robot. */
+        osaRobot1394Configuration RobotConfiguration(const std::string & name,
+                                                     const size_t numberOfActuators,
+                                                     const bool coupling,
+                                                     const bool brakes);
+
+        /*! Create ports for all boards used so far.  Ports are owned
+          by the caller, i.e. mtsRobotIO1394. */
+        std::vector<BasePort *> Ports(void) const;
+
+        inline size_t NumberOfBoards(void) const {
+            return mNumberOfBoards;
+        }
+
+    protected:
+        int NewBoard(void);
+
+        size_t mNumberOfBoards = 0;
+        std::vector<std::unique_ptr<osaAnalogBrake1394Configuration> > mBrakes;
+    };
+
+} // namespace sawRobotIO1394
+
+#endif // _osaFakeBoards1394_h
@@ -0,0 +1,112 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  Author(s):  Anton Deguet
+  Created on: 2021-07-23
+
+  (C) Copyright 2021 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#include <cstring>
+
+#include <cisstCommon/cmnUnits.h>
+#include <sawRobotIO1394/sawRobotIO1394ForwardDeclarations.h>
+
+#include "osaFakePort1394.h"
+#include "BoardIO.h"
+
+using namespace sawRobotIO1394;
+
+namespace {
+    // hardware version register of a QLA board, "QLA1"
+    const quadlet_t QLAHardwareVersion = 0x514C4131;
+    // rev 6+ for acceleration
+    const quadlet_t FirmwareVersion = 7;
+    // 1 kHz IO loop
+    const quadlet_t PeriodTicks = static_cast<quadlet_t>(1.0 * cmn_ms * BoardClockFrequency);
+}
+
+osaFakePort1394::osaFakePort1394(const int portNumber,
+                                 const unsigned int numberOfBoards,
+                                 std::ostream & debugStream):
+    BasePort(portNumber, debugStream),
+    mNumberOfBoards(numberOfBoards)
+{
+    Init();
+    SetProtocol(BasePort::PROTOCOL_SEQ_RW);
+}
+
+osaFakePort1394::~osaFakePort1394()
+{
+    Cleanup();
+}
+
+bool osaFakePort1394::Init(void)
+{
+    return ScanNodes();
+}
+
+nodeid_t osaFakePort1394::InitNodes(void)
+{
+    // one node per board
+    return static_cast<nodeid_t>(mNumberOfBoards);
+}
+
+bool osaFakePort1394::ReadQuadletNode(nodeid_t node, nodeaddr_t address, quadlet_t & data,
+                                      unsigned char CMN_UNUSED(flags))
+{
+    if (node >= mNumberOfBoards) {
+        return false;
+    }
+    switch (address) {
+    case BoardIO::BOARD_STATUS:
+        // board Id in bits 24-27
+        data = static_cast<quadlet_t>(node) << 24;
+        break;
+    case BoardIO::HARDWARE_VERSION:
+        data = QLAHardwareVersion;
+        break;
+    case BoardIO::FIRMWARE_VERSION:
+        data = FirmwareVersion;
+        break;
+    default:
+        data = 0;
+    }
+    return true;
+}
+
+bool osaFakePort1394::WriteQuadletNode(nodeid_t CMN_UNUSED(node), nodeaddr_t CMN_UNUSED(address), quadlet_t CMN_UNUSED(data),
+                                       unsigned char CMN_UNUSED(flags))
+{
+    // broadcast writes use a node Id past the boards
+    return true;
+}
+
+bool osaFakePort1394::ReadBlockNode(nodeid_t node, nodeaddr_t address, quadlet_t * data,
+                                    unsigned int numberOfBytes, unsigned char CMN_UNUSED(flags))
+{
+    if (node >= mNumberOfBoards) {
+        return false;
+    }
+    memset(data, 0, numberOfBytes);
+    // real time block starts with the timestamp, ticks since last read
+    if ((address == 0) && (numberOfBytes >= sizeof(quadlet_t))) {
+        data[0] = PeriodTicks;
+    }
+    return true;
+}
+
+bool osaFakePort1394::WriteBlockNode(nodeid_t CMN_UNUSED(node), nodeaddr_t CMN_UNUSED(address), quadlet_t * CMN_UNUSED(data),
+                                     unsigned int CMN_UNUSED(numberOfBytes), unsigned char CMN_UNUSED(flags))
+{
+    return true;
+}
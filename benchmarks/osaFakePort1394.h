@@ -0,0 +1,95 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  Author(s):  Anton Deguet
+  Created on: 2021-07-23
+
+  (C) Copyright 2021 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#ifndef _osaFakePort1394_h
+#define _osaFakePort1394_h
+
+#include <iostream>
+
+#include <cisstCommon/cmnPortability.h>
+
+#include "BasePort.h"
+
+namespace sawRobotIO1394 {
+
+    /*! Port without hardware for benchmarks.  Node N answers the bus
+      scan as a QLA board with Id N, so AmpIO boards can be added to
+      the port and mtsRobotIO1394 runs its real read/write path.
+      Block reads return zeros except for the timestamp, one period
+      of a 1 kHz IO loop, and all writes succeed.  Only sequential
+      protocol is supported, broadcast requests are ignored. */
+    class osaFakePort1394: public BasePort
+    {
+    public:
+        osaFakePort1394(const int portNumber,
+                        const unsigned int numberOfBoards,
+                        std::ostream & debugStream = std::cerr);
+        ~osaFakePort1394();
+
+        bool IsOK(void) {
+            return true;
+        }
+        PortType GetPortType(void) const {
+            return PORT_FIREWIRE;
+        }
+        int NumberOfUsers(void) {
+            return 1;
+        }
+        unsigned int GetBusGeneration(void) const {
+            return 0;
+        }
+        void UpdateBusGeneration(unsigned int CMN_UNUSED(generation)) {}
+        bool CheckFwBusGeneration(const std::string & CMN_UNUSED(caller), bool CMN_UNUSED(doScan) = false) {
+            return true;
+        }
+
+        // no packet header or alignment, data is copied in place
+        unsigned int GetPrefixOffset(MsgType CMN_UNUSED(message)) const { return 0; }
+        unsigned int GetWritePostfixSize(void) const  { return 0; }
+        unsigned int GetReadPrefixSize(void) const    { return 0; }
+        unsigned int GetReadPostfixSize(void) const   { return 0; }
+        unsigned int GetWriteQuadAlign(void) const    { return 0; }
+        unsigned int GetReadQuadAlign(void) const     { return 0; }
+        unsigned int GetMaxReadDataSize(void) const   { return MAX_POSSIBLE_DATA_SIZE; }
+        unsigned int GetMaxWriteDataSize(void) const  { return MAX_POSSIBLE_DATA_SIZE; }
+
+    protected:
+        bool Init(void);
+        void Cleanup(void) {}
+        nodeid_t InitNodes(void);
+        bool WriteBroadcastReadRequest(unsigned int CMN_UNUSED(sequence)) {
+            return true;
+        }
+        void WaitBroadcastRead(void) {}
+        void PromDelay(void) const {}
+
+        bool ReadQuadletNode(nodeid_t node, nodeaddr_t address, quadlet_t & data,
+                             unsigned char flags = 0);
+        bool WriteQuadletNode(nodeid_t node, nodeaddr_t address, quadlet_t data,
+                              unsigned char flags = 0);
+        bool ReadBlockNode(nodeid_t node, nodeaddr_t address, quadlet_t * data,
+                           unsigned int numberOfBytes, unsigned char flags = 0);
+        bool WriteBlockNode(nodeid_t node, nodeaddr_t address, quadlet_t * data,
+                            unsigned int numberOfBytes, unsigned char flags = 0);
+
+        unsigned int mNumberOfBoards;
+    };
+
+} // namespace sawRobotIO1394
+
+#endif // _osaFakePort1394_h
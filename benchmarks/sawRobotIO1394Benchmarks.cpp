@@ -0,0 +1,251 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  Author(s):  Anton Deguet
+  Created on: 2021-07-23
+
+  (C) Copyright 2021 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include <cisstCommon/cmnPortability.h>
+#include <cisstCommon/cmnCommandLineOptions.h>
+#include <cisstCommon/cmnUnits.h>
+#include <cisstOSAbstraction/osaGetTime.h>
+#include <sawRobotIO1394/mtsRobot1394.h>
+#include <sawRobotIO1394/mtsRobotIO1394.h>
+#include <sawRobotIO1394/osaAllocationGuard1394.h>
+
+#if (CISST_OS == CISST_LINUX)
+#include <cstring>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "osaFakeBoards1394.h"
+
+using namespace sawRobotIO1394;
+
+namespace {
+
+    /*! Hardware cache misses for this thread, -1 if not supported
+      (non Linux OS, virtual machine or perf_event_paranoid). */
+    class CacheMissCounter {
+    public:
+        CacheMissCounter(void) {
+#if (CISST_OS == CISST_LINUX)
+            perf_event_attr attributes;
+            memset(&attributes, 0, sizeof(attributes));
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.size = sizeof(attributes);
+            attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+            attributes.disabled = 1;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            mFileDescriptor = static_cast<int>(syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0));
+#endif
+        }
+        ~CacheMissCounter() {
+#if (CISST_OS == CISST_LINUX)
+            if (mFileDescriptor >= 0) {
+                close(mFileDescriptor);
+            }
+#endif
+        }
+        void Start(void) {
+#if (CISST_OS == CISST_LINUX)
+            if (mFileDescriptor >= 0) {
+                ioctl(mFileDescriptor, PERF_EVENT_IOC_RESET, 0);
+                ioctl(mFileDescriptor, PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+        }
+        long long Stop(void) {
+#if (CISST_OS == CISST_LINUX)
+            if (mFileDescriptor >= 0) {
+                ioctl(mFileDescriptor, PERF_EVENT_IOC_DISABLE, 0);
+                long long count = 0;
+                if (read(mFileDescriptor, &count, sizeof(count)) == sizeof(count)) {
+                    return count;
+                }
+            }
+#endif
+            return -1;
+        }
+    protected:
+        int mFileDescriptor = -1;
+    };
+
+    struct Scenario {
+        size_t NumberOfRobots;
+        size_t NumberOfActuators;
+        bool Coupling;
+        bool Brakes;
+    };
+
+    struct Result {
+        double NanosecondsPerCycle;
+        double CacheMissesPerCycle;
+        double AllocationsPerCycle;
+    };
+
+    /*! One IO cycle, same as a queued command setting the joint
+      efforts followed by mtsRobotIO1394::Run, i.e. Read, PostRead,
+      Write and port transfers over osaFakePort1394. */
+    inline void Cycle(mtsRobotIO1394 & io,
+                      std::vector<mtsRobot1394 *> & robots,
+                      const std::vector<vctDoubleVec> & efforts)
+    {
+        for (size_t index = 0; index < robots.size(); ++index) {
+            robots[index]->SetJointEffort(efforts[index]);
+        }
+        io.Run();
+    }
+
+    Result Run(const Scenario & scenario,
+               const size_t numberOfCycles)
+    {
+        osaFakeBoards1394 boards;
+        std::vector<osaRobot1394Configuration> configs;
+        for (size_t index = 0; index < scenario.NumberOfRobots; ++index) {
+            configs.push_back(boards.RobotConfiguration("robot" + std::to_string(index),
+                                                        scenario.NumberOfActuators,
+                                                        scenario.Coupling, scenario.Brakes));
+        }
+
+        // component owns the ports and robots
+        mtsRobotIO1394 * io = new mtsRobotIO1394("io", 1.0 * cmn_ms, boards.Ports());
+        std::vector<mtsRobot1394 *> robots;
+        std::vector<vctDoubleVec> efforts;
+        for (const auto & config : configs) {
+            mtsRobot1394 * robot = new mtsRobot1394(*io, config);
+            if (!io->SetupRobot(robot)) {
+                std::cerr << "Error: unable to setup robot \"" << config.Name << "\"" << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            io->AddRobot(robot);
+            robots.push_back(robot);
+            efforts.push_back(vctDoubleVec(scenario.NumberOfActuators, 0.01));
+        }
+        io->DiscoverBoards(false);
+        if (scenario.Brakes) {
+            for (auto & robot : robots) {
+                robot->BrakeRelease();
+            }
+        }
+
+        // warm up caches and state tables
+        for (size_t cycle = 0; cycle < 1000; ++cycle) {
+            Cycle(*io, robots, efforts);
+        }
+
+        CacheMissCounter cacheMisses;
+        const size_t allocationsStart = osaAllocationGuard1394::Count();
+        cacheMisses.Start();
+        const double start = osaGetTime();
+        for (size_t cycle = 0; cycle < numberOfCycles; ++cycle) {
+            Cycle(*io, robots, efforts);
+        }
+        const double duration = osaGetTime() - start;
+        const long long misses = cacheMisses.Stop();
+        const size_t allocations = osaAllocationGuard1394::Count() - allocationsStart;
+
+        // deletes robots, boards and ports, brake configurations are
+        // owned by boards
+        delete io;
+
+        Result result;
+        result.NanosecondsPerCycle = duration * 1.0e9 / numberOfCycles;
+        result.CacheMissesPerCycle = (misses < 0) ? -1.0 : static_cast<double>(misses) / numberOfCycles;
+        // allocations are counted by the guard in mtsRobotIO1394::Run, -1 if not compiled in
+        result.AllocationsPerCycle =
+            osaAllocationGuard1394::Available() ? static_cast<double>(allocations) / numberOfCycles : -1.0;
+        return result;
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    cmnLogger::SetMask(CMN_LOG_ALLOW_ERRORS);
+
+    cmnCommandLineOptions options;
+    int numberOfCycles = 20000;
+    std::string outputFile;
+    options.AddOptionOneValue("n", "cycles",
+                              "number of cycles per scenario (default is 20000)",
+                              cmnCommandLineOptions::OPTIONAL_OPTION, &numberOfCycles);
+    options.AddOptionOneValue("o", "output",
+                              "save results in CSV file, default is standard output",
+                              cmnCommandLineOptions::OPTIONAL_OPTION, &outputFile);
+
+    std::string errorMessage;
+    if (!options.Parse(argc, argv, errorMessage)) {
+        std::cerr << "Error: " << errorMessage << std::endl;
+        options.PrintUsage(std::cerr);
+        return -1;
+    }
+    if (numberOfCycles <= 0) {
+        std::cerr << "Error: number of cycles must be positive" << std::endl;
+        return -1;
+    }
+
+    std::ofstream file;
+    if (!outputFile.empty()) {
+        file.open(outputFile.c_str());
+        if (!file.is_open()) {
+            std::cerr << "Error: can't open \"" << outputFile << "\"" << std::endl;
+            return -1;
+        }
+    }
+    std::ostream & output = outputFile.empty() ? std::cout : file;
+
+    output << "robots,actuators,coupling,brakes,cycles,ns-per-cycle,cache-misses-per-cycle,allocations-per-cycle" << std::endl;
+    const size_t robotCounts[] = {1, 2, 4, 8};
+    const size_t actuatorCounts[] = {4, 6, 8};
+    // with sawRobotIO1394_ALLOCATION_GUARD, steady state IO cycles must not allocate
+    size_t scenariosWithAllocations = 0;
+    for (const size_t numberOfRobots : robotCounts) {
+        for (const size_t numberOfActuators : actuatorCounts) {
+            for (const bool coupling : {false, true}) {
+                for (const bool brakes : {false, true}) {
+                    const Scenario scenario = {numberOfRobots, numberOfActuators, coupling, brakes};
+                    const Result result = Run(scenario, numberOfCycles);
+                    output << numberOfRobots << ","
+                           << numberOfActuators << ","
+                           << coupling << ","
+                           << brakes << ","
+                           << numberOfCycles << ","
+                           << result.NanosecondsPerCycle << ","
+                           << result.CacheMissesPerCycle << ","
+                           << result.AllocationsPerCycle << std::endl;
+                    if (result.AllocationsPerCycle > 0.0) {
+                        ++scenariosWithAllocations;
+                    }
+                }
+            }
+        }
+    }
+
+    if (scenariosWithAllocations > 0) {
+        std::cerr << "Error: heap allocation(s) during IO cycles for "
+                  << scenariosWithAllocations << " scenario(s)" << std::endl;
+        osaAllocationGuard1394::LogStackTraces(std::cerr);
+        return -1;
+    }
+
+    return 0;
+}
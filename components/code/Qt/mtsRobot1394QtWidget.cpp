@@ -29,6 +29,7 @@ http://www.cisst.org/cisst/license.txt.
 
 // project include
 #include <sawRobotIO1394/mtsRobot1394QtWidget.h>
+#include <sawRobotIO1394/osaTrace1394.h>
 
 #include <cisstOSAbstraction/osaGetTime.h>
 #include <cisstMultiTask/mtsInterfaceRequired.h>
@@ -340,6 +341,7 @@ void mtsRobot1394QtWidget::SlotBrakeRelease(void)
 
 void mtsRobot1394QtWidget::timerEvent(QTimerEvent * CMN_UNUSED(event))
 {
+    sawRobotIO1394::osaTrace1394::Scope trace("RobotWidget::timerEvent");
     ProcessQueuedEvents();
 
     // make sure we should update the display
@@ -347,6 +349,8 @@ void mtsRobot1394QtWidget::timerEvent(QTimerEvent * CMN_UNUSED(event))
         return;
     }
 
+    // read commands, i.e. wait for the IO component's state tables
+    sawRobotIO1394::osaTrace1394::Begin("RobotWidget::Read");
     bool isValid;
     Robot.IsValid(isValid);
     if (isValid) {
@@ -388,6 +392,7 @@ void mtsRobot1394QtWidget::timerEvent(QTimerEvent * CMN_UNUSED(event))
         ActuatorFeedbackCurrent.SetAll(DummyValueWhenNotConnected);
         ActuatorAmpTemperature.SetAll(DummyValueWhenNotConnected);
     }
+    sawRobotIO1394::osaTrace1394::End("RobotWidget::Read");
 
     DummyValueWhenNotConnected += 0.1;
 
@@ -399,6 +404,7 @@ void mtsRobot1394QtWidget::timerEvent(QTimerEvent * CMN_UNUSED(event))
         QVWActuatorCurrentSlider->SetValue(ActuatorRequestedCurrent);
     }
 
+    sawRobotIO1394::osaTrace1394::Begin("RobotWidget::Display");
     QMIntervalStatistics->SetValue(IntervalStatistics);
     if (NumberOfActuators != 0) {
         QVRJointPosition->SetValue(StateJoint.Position());
@@ -414,6 +420,7 @@ void mtsRobot1394QtWidget::timerEvent(QTimerEvent * CMN_UNUSED(event))
         QVRBrakeCurrentFeedback->SetValue(BrakeFeedbackCurrent);
         QVRBrakeAmpTemperature->SetValue(BrakeAmpTemperature);
     }
+    sawRobotIO1394::osaTrace1394::End("RobotWidget::Display");
 
     // refresh watchdog period if needed
     double watchdogPeriodInSeconds;
@@ -798,6 +805,7 @@ void mtsRobot1394QtWidget::setupUi(void)
 
 void mtsRobot1394QtWidget::UpdateRobotInfo(void)
 {
+    sawRobotIO1394::osaTrace1394::Scope trace("RobotWidget::UpdateRobotInfo");
     // safety relay
     QCBSafetyRelay->blockSignals(true); {
         QCBSafetyRelay->setChecked(SafetyRelay);
@@ -16,6 +16,11 @@ http://www.cisst.org/cisst/license.txt.
 --- end cisst license ---
 */
 
+#include <cstring>
+#include <map>
+#include <mutex>
+
+#include <cisstOSAbstraction/osaGetTime.h>
 #include <cisstMultiTask/mtsInterfaceProvided.h>
 #include <cisstMultiTask/mtsStateTable.h>
 #include <cisstParameterTypes/prmEventButton.h>
@@ -27,12 +32,27 @@ http://www.cisst.org/cisst/license.txt.
 #define DALLAS_START_READ   0x80
 #define DALLAS_MODEL_OFFSET 0xa4
 #define DALLAS_NAME_OFFSET  0x160
+#define DALLAS_DATA_ADDRESS 0x6000
+#define DALLAS_DATA_SIZE    256
+#define DALLAS_CHUNK_SIZE   64   // bytes per ReadBlock, first chunk contains the model number
 
 using namespace sawRobotIO1394;
 
+namespace {
+    // tool types indexed by board, the first chunk of data is used to
+    // check if the tool has changed
+    struct DallasCacheEntry {
+        std::string Header;
+        std::string ToolType;
+    };
+    std::mutex DallasCacheMutex;
+    std::map<int, DallasCacheEntry> DallasCache;
+}
+
 mtsDallasChip1394::mtsDallasChip1394(const cmnGenericObject & owner,
                                      const osaDallasChip1394Configuration & config):
-    OwnerServices(owner.Services())
+    OwnerServices(owner.Services()),
+    mBusTimeBudget(50.0 * cmn_us)
 {
     Configure(config);
 }
@@ -67,8 +87,9 @@ void mtsDallasChip1394::Configure(const osaDallasChip1394Configuration & config)
     // Store configuration
     mConfiguration = config;
     mName = config.Name;
+    mRateDivisor = (config.RateDivisor > 1) ? config.RateDivisor : 1;
     mToolType = ToolTypeUndefined;
-    mStatus = 0; // nothing happened so far
+    mState = DALLAS_IDLE; // nothing happened so far
 }
 
 void mtsDallasChip1394::SetBoard(AmpIO * board)
@@ -81,85 +102,172 @@ void mtsDallasChip1394::SetBoard(AmpIO * board)
 
 void mtsDallasChip1394::PollState(void)
 {
-    if (mStatus > 0) {
-        if (mStatus == 1) {
+    if (mState == DALLAS_IDLE) {
+        return;
+    }
+    // perform as many transactions as possible within budget
+    const double start = osaGetTime();
+    while (Step()
+           && (mState != DALLAS_IDLE)
+           && ((osaGetTime() - start) < mBusTimeBudget)) {
+    }
+}
+
+bool mtsDallasChip1394::Step(void)
+{
+    switch (mState) {
+
+    case DALLAS_IDLE:
+        return false;
+
+    case DALLAS_CHECK_FIRMWARE:
+        if (mBoard->GetFirmwareVersion() < 7) {
+            Fail(mName + ": tool info read requires firmware version 7 or greater");
+            return false;
+        }
+        mState = DALLAS_CHECK_QLA;
+        return true;
+
+    case DALLAS_CHECK_QLA:
+        // Check whether bi-directional I/O is available
+        if ((mBoard->ReadStatus() & 0x00300000) != 0x00300000) {
+            Fail(mName + ": QLA does not support bidirectional I/O (QLA Rev 1.4+ required)");
+            return false;
+        }
+        mState = DALLAS_WRITE_CONTROL;
+        return true;
+
+    case DALLAS_WRITE_CONTROL:
+        {
+            // Address to read tool info
+            unsigned short address = DALLAS_START_READ;
+            if (!(mBoard->DallasWriteControl((address << 16) | 2))) {
+                Fail(mName + ": DallasWriteControl failed");
+                return false;
+            }
+            mInterface->SendStatus(mName + ": requested tool read");
+            mState = DALLAS_WAIT_STATUS;
+        }
+        // chip needs some time, check status on next cycle
+        return false;
+
+    case DALLAS_WAIT_STATUS:
+        {
             AmpIO_UInt32 status;
             if (!mBoard->DallasReadStatus(status)) {
-                mInterface->SendWarning(mName + ": DallasReadStatus failed");
-                ToolTypeEvent(ToolTypeError);
-                mStatus = 0;
-                return;
-            } else {
-                if ((status&0x000000F0) == 0) {
-                    // Check family_code, dout_cfg_bidir, ds_reset, and ds_enable
-                    if ((status & 0xFF00000F) != 0x0B00000B) {
-                        mInterface->SendWarning(mName + ": check family_code, dout_cfg_bidir, ds_reset and/or ds_enable failed (see logs)");
-                        ToolTypeEvent(ToolTypeError);
-                        mStatus = 0;
-                        // detailled messages in logs
-                        if ((status & 0x00000001) != 0x00000001) {
-                            CMN_LOG_CLASS_RUN_ERROR << "PollState: DS2505 interface not enabled (hardware problem)" << std::endl;
-                        }
-                        unsigned char ds_reset = static_cast<unsigned char>((status & 0x00000006)>>1);
-                        if (ds_reset != 1) {
-                            CMN_LOG_CLASS_RUN_ERROR << "PollState: failed to communicate with DS2505" << std::endl;
-                            if (ds_reset == 2) {
-                                CMN_LOG_CLASS_RUN_ERROR << "PollState: DOUT3 did not reach high state -- is pullup resistor missing?" << std::endl;
-                            } else if (ds_reset == 3) {
-                                CMN_LOG_CLASS_RUN_ERROR << "PollState: did not received ACK from DS2505 -- is dMIB signal jumpered?" << std::endl;
-                            }
-                        }
-                        unsigned char family_code = static_cast<unsigned char>((status&0xFF000000)>>24);
-                        if (family_code != 0x0B) {
-                            CMN_LOG_CLASS_RUN_ERROR << "PollState: unknown device family code: 0x" << std::hex << static_cast<unsigned int>(family_code)
-                                                    << " (DS2505 should be 0x0B)" << std::endl;
-                        }
-                        unsigned char rise_time = static_cast<unsigned char>((status&0x00FF0000)>>16);
-                        CMN_LOG_CLASS_RUN_ERROR << "PollState: measured rise time: " << (rise_time/49.152) << " microseconds" << std::endl;
-                        return;
-                    } else {
-                        mInterface->SendStatus(mName + ": reading tool info");
-                        mStatus = 2;
+                Fail(mName + ": DallasReadStatus failed");
+                return false;
+            }
+            if ((status & 0x000000F0) != 0) {
+                // still busy, check again on next cycle
+                return false;
+            }
+            // Check family_code, dout_cfg_bidir, ds_reset, and ds_enable
+            if ((status & 0xFF00000F) != 0x0B00000B) {
+                Fail(mName + ": check family_code, dout_cfg_bidir, ds_reset and/or ds_enable failed (see logs)");
+                // detailled messages in logs
+                if ((status & 0x00000001) != 0x00000001) {
+                    CMN_LOG_CLASS_RUN_ERROR << "PollState: DS2505 interface not enabled (hardware problem)" << std::endl;
+                }
+                unsigned char ds_reset = static_cast<unsigned char>((status & 0x00000006)>>1);
+                if (ds_reset != 1) {
+                    CMN_LOG_CLASS_RUN_ERROR << "PollState: failed to communicate with DS2505" << std::endl;
+                    if (ds_reset == 2) {
+                        CMN_LOG_CLASS_RUN_ERROR << "PollState: DOUT3 did not reach high state -- is pullup resistor missing?" << std::endl;
+                    } else if (ds_reset == 3) {
+                        CMN_LOG_CLASS_RUN_ERROR << "PollState: did not received ACK from DS2505 -- is dMIB signal jumpered?" << std::endl;
                     }
                 }
+                unsigned char family_code = static_cast<unsigned char>((status&0xFF000000)>>24);
+                if (family_code != 0x0B) {
+                    CMN_LOG_CLASS_RUN_ERROR << "PollState: unknown device family code: 0x" << std::hex << static_cast<unsigned int>(family_code)
+                                            << " (DS2505 should be 0x0B)" << std::endl;
+                }
+                unsigned char rise_time = static_cast<unsigned char>((status&0x00FF0000)>>16);
+                CMN_LOG_CLASS_RUN_ERROR << "PollState: measured rise time: " << (rise_time/49.152) << " microseconds" << std::endl;
+                return false;
+            }
+            mInterface->SendStatus(mName + ": reading tool info");
+            mBytesRead = 0;
+            mState = DALLAS_READ_BLOCK;
+        }
+        return true;
+
+    case DALLAS_READ_BLOCK:
+        {
+            char * buffer = reinterpret_cast<char *>(mBuffer);
+            // Read next chunk of data, address is in quadlets
+            const nodeaddr_t address = DALLAS_DATA_ADDRESS + mBytesRead / 4;
+            if (!mBoard->ReadBlock(address,
+                                   reinterpret_cast<quadlet_t *>(buffer + mBytesRead),
+                                   DALLAS_CHUNK_SIZE)) {
+                Fail(mName + ": ReadBlock failed");
+                return false;
             }
-        } else if (mStatus == 2) {
-            nodeaddr_t address = 0x6000;
-            char buffer[256];
-            // Read first block of data (up to 256 bytes)
-            if (!mBoard->ReadBlock(address, reinterpret_cast<quadlet_t *>(buffer), 256)) {
-                mInterface->SendWarning(mName + ": ReadBlock failed");
-                ToolTypeEvent(ToolTypeError);
-                mStatus = 0;
-                return;
-            } else {
+            mBytesRead += DALLAS_CHUNK_SIZE;
+
+            if (mBytesRead == DALLAS_CHUNK_SIZE) {
                 // make sure we read the 997 from company statement
-                buffer[3] = '\0';
-                if (std::string(buffer) != std::string("997")) {
-                    mInterface->SendWarning(mName + ": failed to find string \"997\" in tool data.");
-                    ToolTypeEvent(ToolTypeError);
-                    mStatus = 0;
-                    return;
+                if (std::string(buffer, 3) != std::string("997")) {
+                    Fail(mName + ": failed to find string \"997\" in tool data.");
+                    return false;
                 }
-                // get model and name of tool to create unique string identifier
-                // model number uses only 3 bytes, set first one to zero just in case
-                buffer[DALLAS_MODEL_OFFSET] = 0;
-                int32_t * model = reinterpret_cast<int32_t *>(buffer + (DALLAS_MODEL_OFFSET - DALLAS_START_READ));
-                std::stringstream toolType;
-                cmnDataByteSwap(*model);
-                // concatenate name and model
-                toolType << std::string(buffer + (DALLAS_NAME_OFFSET - DALLAS_START_READ)) << "_" << *model;
-                mToolType.Data = toolType.str();
-                // replace spaces with "_" and use upper case (see mtsIntuitiveResearchKitToolTypes.cdg)
-                std::replace(mToolType.Data.begin(), mToolType.Data.end(), ' ', '_');
-                std::transform(mToolType.Data.begin(), mToolType.Data.end(), mToolType.Data.begin(), ::toupper);
-                // send info
-                mInterface->SendStatus(mName + ": found tool type \"" + mToolType.Data + "\"");
-                ToolTypeEvent(mToolType);
-                mStatus = 0;
+                // same header as last tool found on this board, no need to read the rest
+                const std::string header(buffer, DALLAS_CHUNK_SIZE);
+                std::lock_guard<std::mutex> lock(DallasCacheMutex);
+                auto cached = DallasCache.find(mConfiguration.BoardID);
+                if ((cached != DallasCache.end())
+                    && (cached->second.Header == header)) {
+                    SetToolType(cached->second.ToolType);
+                    return false;
+                }
+            }
+
+            if (mBytesRead < DALLAS_DATA_SIZE) {
+                return true;
             }
+
+            const std::string header(buffer, DALLAS_CHUNK_SIZE);
+            // get model and name of tool to create unique string identifier
+            // model number uses only 3 bytes, set first one to zero just in case
+            buffer[DALLAS_MODEL_OFFSET] = 0;
+            int32_t * model = reinterpret_cast<int32_t *>(buffer + (DALLAS_MODEL_OFFSET - DALLAS_START_READ));
+            std::stringstream toolType;
+            cmnDataByteSwap(*model);
+            // concatenate name and model
+            buffer[DALLAS_DATA_SIZE - 1] = '\0';
+            toolType << std::string(buffer + (DALLAS_NAME_OFFSET - DALLAS_START_READ)) << "_" << *model;
+            std::string toolTypeString = toolType.str();
+            // replace spaces with "_" and use upper case (see mtsIntuitiveResearchKitToolTypes.cdg)
+            std::replace(toolTypeString.begin(), toolTypeString.end(), ' ', '_');
+            std::transform(toolTypeString.begin(), toolTypeString.end(), toolTypeString.begin(), ::toupper);
+            {
+                std::lock_guard<std::mutex> lock(DallasCacheMutex);
+                DallasCacheEntry & entry = DallasCache[mConfiguration.BoardID];
+                entry.Header = header;
+                entry.ToolType = toolTypeString;
+            }
+            SetToolType(toolTypeString);
         }
+        return false;
     }
+    return false;
+}
+
+void mtsDallasChip1394::Fail(const std::string & message)
+{
+    mInterface->SendWarning(message);
+    ToolTypeEvent(ToolTypeError);
+    mState = DALLAS_IDLE;
+}
+
+void mtsDallasChip1394::SetToolType(const std::string & toolType)
+{
+    mToolType.Data = toolType;
+    // send info
+    mInterface->SendStatus(mName + ": found tool type \"" + mToolType.Data + "\"");
+    ToolTypeEvent(mToolType);
+    mState = DALLAS_IDLE;
 }
 
 const osaDallasChip1394Configuration & mtsDallasChip1394::Configuration(void) const
@@ -179,34 +287,22 @@ const std::string & mtsDallasChip1394::ToolType(void) const
 
 void mtsDallasChip1394::TriggerRead(void)
 {
-    if (mStatus > 0) {
+    if (mState != DALLAS_IDLE) {
         mInterface->SendWarning(mName + ": tool info read is already in progress, ignoring");
         ToolTypeEvent(ToolTypeError);
         return;
     }
+    // bus transactions are performed in PollState
+    mState = DALLAS_CHECK_FIRMWARE;
+}
 
-    AmpIO_UInt32 fver = mBoard->GetFirmwareVersion();
-    if (fver < 7) {
-        mInterface->SendWarning(mName + ": tool info read requires firmware version 7 or greater");
-        ToolTypeEvent(ToolTypeError);
-        return;
-    }
-    AmpIO_UInt32 status = mBoard->ReadStatus();
-    // Check whether bi-directional I/O is available
-    if ((status & 0x00300000) != 0x00300000) {
-        mInterface->SendWarning(mName + ": QLA does not support bidirectional I/O (QLA Rev 1.4+ required)");
-        ToolTypeEvent(ToolTypeError);
-        return;
-    }
-
-    // Address to read tool info
-    unsigned short address = DALLAS_START_READ;
-    if (!(mBoard->DallasWriteControl( (address<<16)|2 ))) {
-        mInterface->SendWarning(mName + ": DallasWriteControl failed");
-        ToolTypeEvent(ToolTypeError);
-        return;
-    }
+void mtsDallasChip1394::SetBusTimeBudget(const double budget)
+{
+    mBusTimeBudget = budget;
+}
 
-    mInterface->SendStatus(mName + ": requested tool read"); 
-    mStatus = 1;
+void mtsDallasChip1394::ClearToolTypeCache(void)
+{
+    std::lock_guard<std::mutex> lock(DallasCacheMutex);
+    DallasCache.clear();
 }
@@ -22,31 +22,17 @@ http://www.cisst.org/cisst/license.txt.
 
 #include <sawRobotIO1394/mtsDigitalInput1394.h>
 
-#include "AmpIO.h"
-
-namespace sawRobotIO1394 {
-    class mtsDigitalInput1394Data {
-    public:
-        mtsDigitalInput1394Data():
-            DigitalInputBits(0x0)
-        {};
-        AmpIO_UInt32 BitMask;       // BitMask for this input. From DigitalInput Stream.
-        AmpIO_UInt32 DigitalInputBits; // BitMask for this input. From DigitalInput Stream.
-    };
-}
-
 using namespace sawRobotIO1394;
 
 mtsDigitalInput1394::mtsDigitalInput1394(const cmnGenericObject & owner,
                                          const osaDigitalInput1394Configuration & config):
     OwnerServices(owner.Services()),
-    mData(0),
     mValue(false),
     mPreviousValue(false),
-    mDebounceCounter(-1)
+    mEdgeEventsHead(0),
+    mEdgeEventsTail(0),
+    mEdgeEventsOverflows(0)
 {
-    mData = new mtsDigitalInput1394Data;
-
     // predefined payloads
     mEventPayloads.Pressed.SetType(prmEventButton::PRESSED);
     mEventPayloads.Pressed.SetValid(true);
@@ -59,9 +45,6 @@ mtsDigitalInput1394::mtsDigitalInput1394(const cmnGenericObject & owner,
 
 mtsDigitalInput1394::~mtsDigitalInput1394()
 {
-    if (mData) {
-        delete mData;
-    }
 }
 
 void mtsDigitalInput1394::SetupStateTable(mtsStateTable & stateTable)
@@ -74,6 +57,8 @@ void mtsDigitalInput1394::SetupProvidedInterface(mtsInterfaceProvided * prov, mt
 {
     prov->AddCommandReadState(stateTable, this->mValue, "GetButton");
     prov->AddEventWrite(this->Button, "Button", prmEventButton());
+    prov->AddCommandRead(&mtsDigitalInput1394::GetEdgeEvents, this, "GetEdgeEvents",
+                         vctDoubleMat(0, EVENT_NUMBER_OF_COLUMNS));
 }
 
 void mtsDigitalInput1394::CheckState(void)
@@ -109,7 +94,7 @@ void mtsDigitalInput1394::Configure(const osaDigitalInput1394Configuration & con
     mConfiguration = config;
     mName = config.Name;
     mBitID = config.BitID;
-    mData->BitMask = 0x1 << mBitID;
+    mRateDivisor = (config.RateDivisor > 1) ? config.RateDivisor : 1;
     mPressedValue = config.PressedValue;
     mTriggerPress = config.TriggerWhenPressed;
     mTriggerRelease = config.TriggerWhenReleased;
@@ -121,57 +106,51 @@ void mtsDigitalInput1394::Configure(const osaDigitalInput1394Configuration & con
     mPreviousValue = mValue;
 }
 
-void mtsDigitalInput1394::SetBoard(AmpIO * board)
+void mtsDigitalInput1394::Click(void)
 {
-    if (board == 0) {
-        cmnThrow(this->Name() + ": invalid board pointer.");
+    if (mStateTable) {
+        mEventPayloads.Clicked.SetTimestamp(mStateTable->GetTic());
     }
-    mBoard = board;
+    Button(mEventPayloads.Clicked);
 }
 
-void mtsDigitalInput1394::PollState(void)
+void mtsDigitalInput1394::PushEdgeEvent(const prmEventButton::EventType type,
+                                        const double boardTime, const double hostTime)
 {
-    // Store previous value
-    mPreviousValue = mValue;
-
-    // Get the new value
-    mData->DigitalInputBits =  mBoard->GetDigitalInput();
-
-    // If the masked bit is low, set the value to the pressed value
-    bool value = (mData->DigitalInputBits & mData->BitMask)
-        ? (!mPressedValue) : (mPressedValue);
-
-    // No debounce needed
-    if (mDebounceThreshold == 0.0) {
-        mValue = value;
+    const size_t head = mEdgeEventsHead.load(std::memory_order_relaxed);
+    if ((head - mEdgeEventsTail.load(std::memory_order_acquire)) >= EDGE_EVENTS_SIZE) {
+        // queue is full, clients don't request events often enough
+        mEdgeEventsOverflows.fetch_add(1, std::memory_order_relaxed);
         return;
     }
+    EdgeEvent & event = mEdgeEvents[head % EDGE_EVENTS_SIZE];
+    event.Type = type;
+    event.BoardTime = boardTime;
+    event.HostTime = hostTime;
+    mEdgeEventsHead.store(head + 1, std::memory_order_release);
+}
 
-    // Debounce - start if we find one new different value
-    if (mDebounceCounter == -1.0) {
-        if (value != mPreviousValue) {
-            mDebounceCounter = 0.0;
-            mTransitionValue = value;
-        }
-    // count consecutive equal values
-    } else {
-        if (mDebounceCounter < mDebounceThreshold) {
-            if (value == mTransitionValue) {
-                mDebounceCounter += mBoard->GetTimestamp() / (49.125 * 1000.0 * 1000.0); // clock is 49.125 MHz
-            } else {
-                // click if button is now released and counter is short enough
-                if (!value && (mDebounceCounter >  mDebounceThresholdClick)) {
-                    if (mStateTable) {
-                        mEventPayloads.Clicked.SetTimestamp(mStateTable->GetTic());
-                    }
-                    Button(mEventPayloads.Clicked);
-                }
-                mDebounceCounter = -1.0;
-            }
-        } else {
-            mValue = value;
-            mDebounceCounter = -1.0;
-        }
+void mtsDigitalInput1394::GetEdgeEvents(vctDoubleMat & events) const
+{
+    std::lock_guard<std::mutex> lock(mEdgeEventsMutex);
+    const size_t tail = mEdgeEventsTail.load(std::memory_order_relaxed);
+    const size_t head = mEdgeEventsHead.load(std::memory_order_acquire);
+    const size_t numberOfEvents = head - tail;
+    if ((events.rows() != numberOfEvents) || (events.cols() != EVENT_NUMBER_OF_COLUMNS)) {
+        events.SetSize(numberOfEvents, EVENT_NUMBER_OF_COLUMNS);
+    }
+    for (size_t row = 0; row < numberOfEvents; ++row) {
+        const EdgeEvent & event = mEdgeEvents[(tail + row) % EDGE_EVENTS_SIZE];
+        events.Element(row, EVENT_TYPE) = static_cast<double>(event.Type);
+        events.Element(row, EVENT_BOARD_TIME) = event.BoardTime;
+        events.Element(row, EVENT_HOST_TIME) = event.HostTime;
+    }
+    // slots can be reused by the IO thread
+    mEdgeEventsTail.store(head, std::memory_order_release);
+    const size_t overflows = mEdgeEventsOverflows.exchange(0, std::memory_order_relaxed);
+    if (overflows != 0) {
+        CMN_LOG_CLASS_RUN_WARNING << "GetEdgeEvents: " << mName << " dropped "
+                                  << overflows << " event(s), queue full" << std::endl;
     }
 }
 
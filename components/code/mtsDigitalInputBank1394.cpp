@@ -0,0 +1,232 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  Author(s):  Anton Deguet
+  Created on: 2021-07-12
+
+  (C) Copyright 2021 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#include <cisstCommon/cmnThrow.h>
+
+#include <sawRobotIO1394/mtsDigitalInputBank1394.h>
+#include <sawRobotIO1394/mtsDigitalInput1394.h>
+#include <sawRobotIO1394/osaBoardClock1394.h>
+
+#include "AmpIO.h"
+
+using namespace sawRobotIO1394;
+
+mtsDigitalInputBank1394::mtsDigitalInputBank1394(AmpIO * board,
+                                                 const osaBoardClock1394 * clock):
+    mBoard(board),
+    mClock(clock)
+{
+    if (!mBoard || !mClock) {
+        cmnThrow("mtsDigitalInputBank1394: invalid board or board clock pointer.");
+    }
+    mBoardTime = mClock->Time();
+    for (size_t bit = 0; bit < NUMBER_OF_BITS; ++bit) {
+        mInputs[bit] = nullptr;
+        mCounters[bit] = 0.0;
+        mEdgeTimes[bit] = 0.0;
+    }
+}
+
+mtsDigitalInputBank1394::~mtsDigitalInputBank1394()
+{
+}
+
+void mtsDigitalInputBank1394::AddInput(mtsDigitalInput1394 * input)
+{
+    const int bit = input->mBitID;
+    if ((bit < 0) || (bit >= NUMBER_OF_BITS)) {
+        cmnThrow(input->Name() + ": invalid bit ID for digital input.");
+    }
+    if (mInputs[bit]) {
+        cmnThrow(input->Name() + ": bit already used by digital input " + mInputs[bit]->Name() + ".");
+    }
+    // the word is read once for all inputs on the board
+    if (!Empty() && (input->RateDivisor() != mRateDivisor)) {
+        cmnThrow(input->Name() + ": rate divisor must be the same for all digital inputs on a board.");
+    }
+    mInputs[bit] = input;
+    UpdateMasks();
+
+    // initial value, set by mtsDigitalInput1394::Configure
+    const unsigned int mask = 0x1 << bit;
+    mValues = (mValues & ~mask) | (input->mValue ? mask : 0x0);
+    mDebouncing &= ~mask;
+    mChanged &= ~mask;
+}
+
+void mtsDigitalInputBank1394::RemoveInput(mtsDigitalInput1394 * input)
+{
+    for (size_t bit = 0; bit < NUMBER_OF_BITS; ++bit) {
+        if (mInputs[bit] == input) {
+            mInputs[bit] = nullptr;
+        }
+    }
+    UpdateMasks();
+    mValues &= mUsedMask;
+    mDebouncing &= mUsedMask;
+    mChanged &= mUsedMask;
+}
+
+bool mtsDigitalInputBank1394::Empty(void) const
+{
+    return (mUsedMask == 0x0);
+}
+
+void mtsDigitalInputBank1394::CopyState(const mtsDigitalInputBank1394 & previous)
+{
+    unsigned int copied = 0x0;
+    for (size_t bit = 0; bit < NUMBER_OF_BITS; ++bit) {
+        if (mInputs[bit] && (mInputs[bit] == previous.mInputs[bit])) {
+            copied |= 0x1 << bit;
+            mCounters[bit] = previous.mCounters[bit];
+            mEdgeTimes[bit] = previous.mEdgeTimes[bit];
+        }
+    }
+    mValues = (mValues & ~copied) | (previous.mValues & copied);
+    mDebouncing = (mDebouncing & ~copied) | (previous.mDebouncing & copied);
+    mTransition = (mTransition & ~copied) | (previous.mTransition & copied);
+    mChanged = (mChanged & ~copied) | (previous.mChanged & copied);
+    mBoardTime = previous.mBoardTime;
+}
+
+void mtsDigitalInputBank1394::UpdateMasks(void)
+{
+    mUsedMask = 0x0;
+    mPressedMask = 0x0;
+    mImmediateMask = 0x0;
+    mRateDivisor = 0;
+    for (size_t bit = 0; bit < NUMBER_OF_BITS; ++bit) {
+        const mtsDigitalInput1394 * input = mInputs[bit];
+        if (!input) {
+            continue;
+        }
+        const unsigned int mask = 0x1 << bit;
+        mUsedMask |= mask;
+        if (input->mPressedValue) {
+            mPressedMask |= mask;
+        }
+        if (input->mDebounceThreshold == 0.0) {
+            mImmediateMask |= mask;
+        }
+        mRateDivisor = input->RateDivisor();
+    }
+    if (mRateDivisor == 0) {
+        mRateDivisor = 1;
+    }
+}
+
+void mtsDigitalInputBank1394::PollState(void)
+{
+    Update(mBoard->GetDigitalInput(), mClock->Time());
+}
+
+void mtsDigitalInputBank1394::Update(const unsigned int bits, const double boardTime)
+{
+    // Value is the pressed value if the bit is low
+    const unsigned int values = (bits ^ mPressedMask) & mUsedMask;
+    const unsigned int different = values ^ mValues;
+
+    // FPGA time since previous poll, exact even if the bank is not
+    // polled every read
+    const double elapsed = boardTime - mBoardTime;
+    mBoardTime = boardTime;
+
+    // Nothing changed and nothing to debounce
+    if ((different == 0x0) && (mDebouncing == 0x0) && (mChanged == 0x0)) {
+        return;
+    }
+
+    // edges happened between previous and current read
+    const double edgeTime = mBoardTime - 0.5 * elapsed;
+
+    const unsigned int previous = mValues;
+    // No debounce needed
+    unsigned int newValues = (mValues & ~mImmediateMask) | (values & mImmediateMask);
+
+    // Count consecutive equal values for bits already debouncing
+    const unsigned int debouncing = mDebouncing;
+    if (debouncing) {
+        unsigned int pending = debouncing;
+        for (size_t bit = 0; pending; ++bit, pending >>= 1) {
+            if (!(pending & 0x1)) {
+                continue;
+            }
+            const unsigned int mask = 0x1 << bit;
+            mtsDigitalInput1394 * input = mInputs[bit];
+            if (mCounters[bit] < input->mDebounceThreshold) {
+                if ((values & mask) == (mTransition & mask)) {
+                    mCounters[bit] += elapsed;
+                } else {
+                    // click if button is now released and counter is short enough
+                    if (!(values & mask) && (mCounters[bit] > input->mDebounceThresholdClick)) {
+                        input->PushEdgeEvent(prmEventButton::CLICKED, edgeTime, mClock->HostTime(edgeTime));
+                        input->Click();
+                    }
+                    mDebouncing &= ~mask;
+                }
+            } else {
+                newValues = (newValues & ~mask) | (values & mask);
+                mDebouncing &= ~mask;
+            }
+        }
+    }
+
+    // Debounce - start for bits with a new different value
+    const unsigned int start = different & ~mImmediateMask & ~debouncing;
+    if (start) {
+        mDebouncing |= start;
+        mTransition = (mTransition & ~start) | (values & start);
+        unsigned int pending = start;
+        for (size_t bit = 0; pending; ++bit, pending >>= 1) {
+            if (pending & 0x1) {
+                mCounters[bit] = 0.0;
+                mEdgeTimes[bit] = edgeTime;
+            }
+        }
+    }
+
+    // Update inputs changed now or during previous poll
+    const unsigned int changed = newValues ^ previous;
+    unsigned int update = changed | mChanged;
+    for (size_t bit = 0; update; ++bit, update >>= 1) {
+        if (update & 0x1) {
+            const unsigned int mask = 0x1 << bit;
+            mtsDigitalInput1394 * input = mInputs[bit];
+            input->mPreviousValue = ((previous & mask) != 0);
+            input->mValue = ((newValues & mask) != 0);
+            if (changed & mask) {
+                // debounced bits use time of first transition
+                const double time = (mImmediateMask & mask) ? edgeTime : mEdgeTimes[bit];
+                input->PushEdgeEvent(input->mValue ? prmEventButton::PRESSED : prmEventButton::RELEASED,
+                                     time, mClock->HostTime(time));
+            }
+        }
+    }
+    mValues = newValues;
+    mChanged = changed;
+}
+
+void mtsDigitalInputBank1394::CheckState(void)
+{
+    unsigned int changed = mChanged;
+    for (size_t bit = 0; changed; ++bit, changed >>= 1) {
+        if (changed & 0x1) {
+            mInputs[bit]->CheckState();
+        }
+    }
+}
@@ -28,10 +28,14 @@ namespace sawRobotIO1394 {
     class mtsDigitalOutput1394Data {
     public:
         mtsDigitalOutput1394Data():
-            DigitalOutputBits(0x0)
+            DigitalOutputBits(0x0),
+            PendingMask(0x0),
+            PendingBits(0x0)
         {};
         AmpIO_UInt32 BitMask;       // BitMask for this output. From DigitalOutput Stream.
         AmpIO_UInt32 DigitalOutputBits; // BitMask for this output. From DigitalOutput Stream.
+        AmpIO_UInt32 PendingMask;   // Set when value changed since last write
+        AmpIO_UInt32 PendingBits;   // New value, only bits in mask are used
     };
 }
 
@@ -82,10 +86,13 @@ void mtsDigitalOutput1394::Configure(const osaDigitalOutput1394Configuration & c
     mConfiguration = config;
     mName = config.Name;
     mBitID = config.BitID;
+    mRateDivisor = (config.RateDivisor > 1) ? config.RateDivisor : 1;
     mData->BitMask = 0x1 << mBitID;
 
     // Set the value
     mValue = false;
+    mData->PendingMask = 0x0;
+    mPWMPending = false;
 }
 
 void mtsDigitalOutput1394::SetBoard(AmpIO * board)
@@ -94,9 +101,8 @@ void mtsDigitalOutput1394::SetBoard(AmpIO * board)
         cmnThrow(this->Name() + ": invalid board pointer.");
     }
     mBoard = board;
-    mBoard->WriteDoutControl(mBitID,
-                             mBoard->GetDoutCounts(mConfiguration.HighDuration),
-                             mBoard->GetDoutCounts(mConfiguration.LowDuration));
+    // written by the IO thread, see WritePendingPWM
+    mControlPending = true;
 }
 
 void mtsDigitalOutput1394::PollState(void)
@@ -125,20 +131,43 @@ const bool & mtsDigitalOutput1394::Value(void) const
 
 void mtsDigitalOutput1394::SetValue(const bool & newValue)
 {
-    // read from the boards
-    mData->DigitalOutputBits = mBoard->GetDigitalOutput();
-    if (newValue) {
-        mData->DigitalOutputBits |= mData->BitMask;
-    } else {
-        mData->DigitalOutputBits &= ~(mData->BitMask);
-    }
-    mBoard->WriteDigitalOutput(0x0f, mData->DigitalOutputBits);
+    // buffered, sent to the board during the next write
+    mData->PendingMask = mData->BitMask;
+    mData->PendingBits = newValue ? mData->BitMask : 0x0;
 }
 
 void mtsDigitalOutput1394::SetPWMDutyCycle(const double & dutyCycle)
 {
-    if ((dutyCycle > 0.0) && (dutyCycle < 1.0)) {
-        mBoard->WritePWM(mBitID, mConfiguration.PWMFrequency, dutyCycle);
+    // buffered, only the last duty cycle is sent during the next write
+    mPWMDutyCycle = dutyCycle;
+    mPWMPending = true;
+}
+
+bool mtsDigitalOutput1394::GetPendingWrite(unsigned int & mask, unsigned int & bits)
+{
+    if (mData->PendingMask == 0x0) {
+        return false;
+    }
+    mask = mData->PendingMask;
+    bits = mData->PendingBits;
+    mData->PendingMask = 0x0;
+    return true;
+}
+
+void mtsDigitalOutput1394::WritePendingPWM(void)
+{
+    if (mControlPending) {
+        mControlPending = false;
+        mBoard->WriteDoutControl(mBitID,
+                                 mBoard->GetDoutCounts(mConfiguration.HighDuration),
+                                 mBoard->GetDoutCounts(mConfiguration.LowDuration));
+    }
+    if (!mPWMPending) {
+        return;
+    }
+    mPWMPending = false;
+    if ((mPWMDutyCycle > 0.0) && (mPWMDutyCycle < 1.0)) {
+        mBoard->WritePWM(mBitID, mConfiguration.PWMFrequency, mPWMDutyCycle);
     } else {
         mBoard->WriteDoutControl(mBitID, 0, 0);
     }
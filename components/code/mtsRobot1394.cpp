@@ -16,9 +16,11 @@ http://www.cisst.org/cisst/license.txt.
 --- end cisst license ---
 */
 
+#include <algorithm>
 #include <cmath>
 
 #include <cisstNumerical/nmrInverse.h>
+#include <cisstOSAbstraction/osaGetTime.h>
 
 #include <cisstMultiTask/mtsInterfaceProvided.h>
 #include <cisstMultiTask/mtsStateTable.h>
@@ -31,9 +33,31 @@ http://www.cisst.org/cisst/license.txt.
 #include <AmpIO.h>
 
 #include <sawRobotIO1394/mtsRobot1394.h>
+#include <sawRobotIO1394/osaBoardClock1394.h>
+#include <sawRobotIO1394/osaTrace1394.h>
+#include <sawRobotIO1394/osaProbes1394.h>
 
 using namespace sawRobotIO1394;
 
+namespace {
+    /*! Raw FPGA velocity compensated for its delay using the
+      acceleration, clamped to zero if this would change the sign of
+      the velocity.  No branch in the loop body so the compiler can
+      vectorize it. */
+    inline void osaRobot1394AccelerationCompensation(const size_t size,
+                                                     const double * velocities,
+                                                     const double * accelerations,
+                                                     const double * delays,
+                                                     double * results)
+    {
+        for (size_t i = 0; i < size; ++i) {
+            const double velocity = velocities[i];
+            const double predicted = velocity + accelerations[i] * delays[i];
+            results[i] = (velocity * predicted < 0.0) ? 0.0 : predicted;
+        }
+    }
+}
+
 mtsRobot1394::mtsRobot1394(const cmnGenericObject & owner,
                            const osaRobot1394Configuration & config):
     OwnerServices(owner.Services()),
@@ -103,6 +127,9 @@ bool mtsRobot1394::SetupStateTables(const size_t stateTableSize,
     mStateTableRead->AddData(mActuatorMeasuredJS, "actuator_measured_js");
     mStateTableRead->AddData(mEncoderAcceleration, "measured_ja");
     mStateTableRead->AddData(mActuatorEncoderAcceleration, "actuator_measured_ja");
+    mStateTableRead->AddData(mVelocity.EstimatesSI, "ActuatorVelocityEstimates");
+    mStateTableRead->AddData(mVelocity.Statistics, "VelocityEstimatorStatistics");
+    mStateTableRead->AddData(mActuatorSampleTime, "ActuatorSampleTime");
 
     mStateTableWrite->AddData(mActuatorCurrentBitsCommand, "ActuatorControlCurrentRaw");
     mStateTableWrite->AddData(mActuatorCurrentCommand, "ActuatorControlCurrent");
@@ -360,6 +387,14 @@ void mtsRobot1394::SetupInterfaces(mtsInterfaceProvided * robotInterface,
                                         "measured_js");
     robotInterface->AddCommandReadState(*mStateTableRead, mActuatorMeasuredJS,
                                         "actuator_measured_js");
+    robotInterface->AddCommandReadState(*mStateTableRead, mVelocity.EstimatesSI,
+                                        "GetActuatorVelocityEstimates"); // matrix[double], see NUMBER_OF_VELOCITY_ESTIMATORS
+    robotInterface->AddCommandReadState(*mStateTableRead, mVelocity.Statistics,
+                                        "GetVelocityEstimatorStatistics"); // matrix[double], see VELOCITY_STATISTICS_
+    robotInterface->AddCommandReadState(*mStateTableRead, mActuatorSampleTime,
+                                        "GetActuatorSampleTime"); // vector[double], host time of each actuator's board read
+    robotInterface->AddCommandWrite(&mtsRobot1394::SetEstimateAllVelocities, this,
+                                    "SetEstimateAllVelocities"); // bool
 
     robotInterface->AddCommandReadState(*mStateTableRead, mPotBits,
                                         "GetAnalogInputRaw");
@@ -486,6 +521,8 @@ void mtsRobot1394::Configure(const osaRobot1394Configuration & config)
     mName = config.Name;
     mNumberOfActuators = config.NumberOfActuators;
     mNumberOfJoints = config.NumberOfJoints;
+    // loaders reject rate divisors for robots with safety checks
+    mRateDivisor = (config.OnlyIO && (config.RateDivisor > 1)) ? config.RateDivisor : 1;
     mSerialNumber = config.SerialNumber;
     mPotType = config.PotLocation;
 
@@ -509,9 +546,17 @@ void mtsRobot1394::Configure(const osaRobot1394Configuration & config)
     mActuatorCurrentBitsFeedback.SetSize(mNumberOfActuators);
 
     mActuatorTimestamp.SetSize(mNumberOfActuators);
+    mActuatorSampleTime.SetSize(mNumberOfActuators);
+    mActuatorSampleTime.SetAll(0.0);
     mPotVoltage.SetSize(mNumberOfActuators);
     mPotPosition.SetSize(mNumberOfActuators);
     mEncoderVelocityPredictedCountsPerSec.SetSize(mNumberOfActuators);
+    mEncoderVelocityCountsPerSec.SetSize(mNumberOfActuators);
+    mEncoderVelocityCountsPerSec.SetAll(0.0);
+    mEncoderVelocityDelay.SetSize(mNumberOfActuators);
+    mEncoderVelocityDelay.SetAll(0.0);
+    mEncoderVelocityCompensatedCountsPerSec.SetSize(mNumberOfActuators);
+    mEncoderVelocityCompensatedCountsPerSec.SetAll(0.0);
     mEncoderAccelerationCountsPerSecSec.SetSize(mNumberOfActuators);
     mActuatorEncoderAcceleration.SetSize(mNumberOfActuators);
     mEncoderAcceleration.SetSize(mNumberOfActuators);
@@ -673,6 +718,54 @@ void mtsRobot1394::Configure(const osaRobot1394Configuration & config)
     } else {
         mJointEffortCommandLimits.Assign(mActuatorEffortCommandLimits);
     }
+
+    // Temporaries
+    mScratch.ActuatorEfforts.SetSize(mNumberOfActuators);
+    mScratch.ActuatorCurrents.SetSize(mNumberOfActuators);
+    mScratch.ActuatorPositions.SetSize(mNumberOfActuators);
+    mScratch.ActuatorBits.SetSize(mNumberOfActuators);
+    mScratch.BrakeBits.SetSize(mNumberOfBrakes);
+    mScratch.Potentiometers.SetSize(mNumberOfActuators);
+    mScratch.EncoderReference.SetSize(mNumberOfActuators);
+    mScratch.EncoderDelta.SetSize(mNumberOfActuators);
+    mScratch.PotentiometersSample.Data.SetSize(mNumberOfActuators);
+    mScratch.EncodersSample.Position().SetSize(mNumberOfActuators);
+    mScratch.EncodersSample.Velocity().SetSize(mNumberOfActuators);
+    mScratch.EncodersSample.Effort().SetSize(mNumberOfActuators);
+
+    // Software velocity estimation, ring buffers sized for the largest window
+    int window = 2;
+    mVelocity.Estimator.SetSize(mNumberOfActuators);
+    mVelocity.Window.SetSize(mNumberOfActuators);
+    mVelocity.ObserverBandwidth.SetSize(mNumberOfActuators);
+    mVelocity.Statistics.SetSize(NUMBER_OF_VELOCITY_ESTIMATORS, VELOCITY_STATISTICS_NUMBER_OF_COLUMNS);
+    mVelocity.Statistics.SetAll(0.0);
+    for (size_t estimator = 0; estimator < NUMBER_OF_VELOCITY_ESTIMATORS; ++estimator) {
+        mVelocity.NumberOfActuators[estimator] = 0;
+    }
+    for (size_t i = 0; i < mNumberOfActuators; i++) {
+        const osaEncoder1394Configuration & encoder = config.Actuators[i].Encoder;
+        mVelocity.Estimator[i] = encoder.VelocityEstimator;
+        mVelocity.Window[i] = std::max(2, std::min(encoder.VelocityWindow, MAX_VELOCITY_WINDOW));
+        mVelocity.ObserverBandwidth[i] = 2.0 * cmnPI * encoder.VelocityBandwidth;
+        window = std::max(window, mVelocity.Window[i]);
+        mVelocity.NumberOfActuators[encoder.VelocityEstimator]++;
+        mVelocity.Statistics.Element(encoder.VelocityEstimator, VELOCITY_STATISTICS_ACTUATORS) += 1.0;
+    }
+    mVelocity.Positions.SetSize(window, mNumberOfActuators);
+    mVelocity.Times.SetSize(window, mNumberOfActuators);
+    mVelocity.ObserverPosition.SetSize(mNumberOfActuators);
+    mVelocity.ObserverVelocity.SetSize(mNumberOfActuators);
+    mVelocity.SumWeights.SetSize(mNumberOfActuators);
+    mVelocity.SumTimes.SetSize(mNumberOfActuators);
+    mVelocity.SumPositions.SetSize(mNumberOfActuators);
+    mVelocity.SumTimes2.SetSize(mNumberOfActuators);
+    mVelocity.SumTimesPositions.SetSize(mNumberOfActuators);
+    mVelocity.Estimates.SetSize(NUMBER_OF_VELOCITY_ESTIMATORS, mNumberOfActuators);
+    mVelocity.Estimates.SetAll(0.0);
+    mVelocity.EstimatesSI.SetSize(NUMBER_OF_VELOCITY_ESTIMATORS, mNumberOfActuators);
+    mVelocity.EstimatesSI.SetAll(0.0);
+    ResetVelocityEstimators();
 }
 
 void mtsRobot1394::SetBoards(const std::vector<osaActuatorMapping> & actuatorBoards,
@@ -687,58 +780,60 @@ void mtsRobot1394::SetBoards(const std::vector<osaActuatorMapping> & actuatorBoa
     }
 
     for (size_t i = 0; i < mNumberOfActuators; i++) {
+        if (!actuatorBoards.at(i).Board || !actuatorBoards.at(i).Clock) {
+            cmnThrow(this->Name() + ": board or board clock not set for actuator " + std::to_string(i));
+        }
         // Store this board
         mActuatorInfo.at(i).Board = actuatorBoards.at(i).Board;
+        mActuatorInfo.at(i).Clock = actuatorBoards.at(i).Clock;
         mActuatorInfo.at(i).BoardID = actuatorBoards.at(i).BoardID;
         mActuatorInfo.at(i).Axis = actuatorBoards.at(i).Axis;
         // Construct a list of unique boards
-        mUniqueBoards[actuatorBoards.at(i).Board->GetBoardId()] = actuatorBoards.at(i).Board;
+        mUniqueBoards[actuatorBoards.at(i).BoardID] = actuatorBoards.at(i).Board;
     }
 
     for (size_t i = 0; i < mNumberOfBrakes; i++) {
+        if (!brakeBoards.at(i).Board || !brakeBoards.at(i).Clock) {
+            cmnThrow(this->Name() + ": board or board clock not set for brake " + std::to_string(i));
+        }
         // Store this board
         mBrakeInfo.at(i).Board = brakeBoards.at(i).Board;
+        mBrakeInfo.at(i).Clock = brakeBoards.at(i).Clock;
         mBrakeInfo.at(i).BoardID = brakeBoards.at(i).BoardID;
         mBrakeInfo.at(i).Axis = brakeBoards.at(i).Axis;
         // Construct a list of unique boards
-        mUniqueBoards[brakeBoards.at(i).Board->GetBoardId()] = brakeBoards.at(i).Board;
+        mUniqueBoards[brakeBoards.at(i).BoardID] = brakeBoards.at(i).Board;
     }
 
+    // firmware versions are set by SetFirmwareVersions once the boards have been queried
     mLowestFirmWareVersion = 999999;
     mHighestFirmWareVersion = 0;
-    size_t boardCounter = 0;
-    for (auto board = mUniqueBoards.begin();
-         board != mUniqueBoards.end();
-         ++board, ++boardCounter) {
-        AmpIO_UInt32 fversion = board->second->GetFirmwareVersion();
-        if (fversion == 0) {
-            CMN_LOG_CLASS_INIT_ERROR << "SetBoards: " << this->mName
-                                     << ", unable to get firmware version for board: " << boardCounter
-                                     << ", Id: " << static_cast<int>(board->second->GetBoardId())
-                                     << ".  Make sure the controller is powered and connected" << std::endl;
-            exit(EXIT_FAILURE);
-        }
-        std::string serialQLA = board->second->GetQLASerialNumber();
-        if (serialQLA.empty()) {
-            serialQLA = "unknown";
-        }
-        std::string serialFPGA = board->second->GetFPGASerialNumber();
-        if (serialFPGA.empty()) {
-            serialFPGA = "unknown";
+    mAccelerationCompensatedVelocity = mConfiguration.AccelerationCompensatedVelocity;
+}
+
+void mtsRobot1394::SetFirmwareVersions(const std::map<int, unsigned int> & firmwareVersions)
+{
+    mLowestFirmWareVersion = 999999;
+    mHighestFirmWareVersion = 0;
+    for (const auto & board : mUniqueBoards) {
+        const auto version = firmwareVersions.find(board.first);
+        if (version == firmwareVersions.end()) {
+            cmnThrow(this->Name() + ": firmware version not known for all boards.");
         }
-        if (fversion < mLowestFirmWareVersion) {
-            mLowestFirmWareVersion = fversion;
+        if (version->second < mLowestFirmWareVersion) {
+            mLowestFirmWareVersion = version->second;
         }
-        if (fversion > mHighestFirmWareVersion) {
-            mHighestFirmWareVersion = fversion;
+        if (version->second > mHighestFirmWareVersion) {
+            mHighestFirmWareVersion = version->second;
         }
-        CMN_LOG_CLASS_INIT_WARNING << "SetBoards: " << this->mName
-                                   << ", board: " << boardCounter
-                                   << ", Id: " << static_cast<int>(board->second->GetBoardId())
-                                   << ", firmware: " << fversion
-                                   << ", FPGA serial: " << serialFPGA
-                                   << ", QLA serial: " << serialQLA
-                                   << std::endl;
+    }
+    // acceleration is only provided by firmware rev 6+
+    mAccelerationCompensatedVelocity = mConfiguration.AccelerationCompensatedVelocity;
+    if (mAccelerationCompensatedVelocity && (mLowestFirmWareVersion < 6)) {
+        CMN_LOG_CLASS_INIT_WARNING << "SetFirmwareVersions: " << this->Name()
+                                   << ", acceleration compensated velocity requires firmware 6 or higher, found "
+                                   << mLowestFirmWareVersion << ", using FPGA velocity" << std::endl;
+        mAccelerationCompensatedVelocity = false;
     }
 }
 
@@ -804,14 +899,18 @@ void mtsRobot1394::PollValidity(void)
 
 void mtsRobot1394::PollState(void)
 {
+    osaTrace1394::Scope trace("Robot::PollState");
     // Poll data
     for (size_t i = 0; i < mNumberOfActuators; i++) {
         AmpIO * board = mActuatorInfo[i].Board;
+        const osaBoardClock1394 * clock = mActuatorInfo[i].Clock;
         int axis = mActuatorInfo[i].Axis;
 
         if (!board || (axis < 0)) continue; // We probably don't need this check any more
 
-        mActuatorTimestamp[i] = board->GetTimestamp() * 1.0 / 49125000.0;
+        // timestamp decoded once per board by mtsRobotIO1394
+        mActuatorTimestamp[i] = clock->Elapsed();
+        mActuatorSampleTime[i] = clock->SampleTime();
         mDigitalInputs[i] = board->GetDigitalInput();
 
         // vectors of bits
@@ -829,6 +928,17 @@ void mtsRobot1394::PollState(void)
         // Second argument below is how much quantization error do we accept
         mEncoderVelocityPredictedCountsPerSec[i] = board->GetEncoderVelocityPredicted(axis, 0.0005);
 
+        // Raw velocity, i.e. without Amp1394 prediction, for our own
+        // compensation.  Velocity is measured over the last encoder
+        // count period, i.e. centered half a period before the last
+        // edge, plus time since last edge
+        if (mAccelerationCompensatedVelocity) {
+            const double velocity = board->GetEncoderVelocityCountsPerSecond(axis);
+            mEncoderVelocityCountsPerSec[i] = velocity;
+            mEncoderVelocityDelay[i] = board->GetEncoderRunningCounterSeconds(axis)
+                + ((velocity != 0.0) ? (0.5 / std::fabs(velocity)) : 0.0);
+        }
+
         mPotBits[i] = board->GetAnalogInput(axis);
 
         mActuatorCurrentBitsFeedback[i] = board->GetMotorCurrent(axis);
@@ -846,7 +956,7 @@ void mtsRobot1394::PollState(void)
 
         if (!board || (axis < 0)) continue; // We probably don't need this check any more
 
-        mBrakeTimestamp[i] = board->GetTimestamp() * 1.0 / 49125000.0;
+        mBrakeTimestamp[i] = mBrakeInfo[i].Clock->Elapsed();
         mBrakeCurrentBitsFeedback[i] = board->GetMotorCurrent(axis);
         mBrakeAmpEnable[i] = board->GetAmpEnable(axis);
         mBrakeAmpStatus[i] = board->GetAmpStatus(axis);
@@ -860,6 +970,7 @@ void mtsRobot1394::PollState(void)
 
 void mtsRobot1394::ConvertState(void)
 {
+    osaTrace1394::Scope trace("Robot::ConvertState");
     // Perform read conversions
     EncoderBitsToPosition(mEncoderPositionBits,
                           mActuatorMeasuredJS.Position());
@@ -870,8 +981,8 @@ void mtsRobot1394::ConvertState(void)
         mMeasuredJS.Position().Assign(mActuatorMeasuredJS.Position());
     }
 
-    // Velocity from counts/sec to SI units
-    mActuatorMeasuredJS.Velocity().ElementwiseProductOf(mBitsToPositionScales, mEncoderVelocityPredictedCountsPerSec);
+    // Velocity, FPGA or software estimation, see osaVelocityEstimator1394
+    EstimateVelocities();
     if (mConfiguration.HasActuatorToJointCoupling) {
         mMeasuredJS.Velocity().ProductOf(mConfiguration.Coupling.ActuatorToJointPosition(),
                                          mActuatorMeasuredJS.Velocity());
@@ -906,8 +1017,202 @@ void mtsRobot1394::ConvertState(void)
     PotVoltageToPosition(mPotVoltage, mPotPosition);
 }
 
+void mtsRobot1394::ResetVelocityEstimators(void)
+{
+    mVelocity.Reset = true;
+}
+
+void mtsRobot1394::SetEstimateAllVelocities(const bool & all)
+{
+    mVelocity.All = all;
+    // estimators not selected are no longer computed
+    if (!all) {
+        for (size_t estimator = 0; estimator < NUMBER_OF_VELOCITY_ESTIMATORS; ++estimator) {
+            if (!mVelocity.NumberOfActuators[estimator]) {
+                mVelocity.Estimates.Row(estimator).SetAll(0.0);
+                mVelocity.EstimatesSI.Row(estimator).SetAll(0.0);
+            }
+        }
+    }
+}
+
+void mtsRobot1394::UpdateVelocityStatistics(const size_t estimator, const double time)
+{
+    vctDoubleMat::RowRefType statistics = mVelocity.Statistics.Row(estimator);
+    statistics[VELOCITY_STATISTICS_AVERAGE_TIME] += 0.001 * (time - statistics[VELOCITY_STATISTICS_AVERAGE_TIME]);
+    if (time > statistics[VELOCITY_STATISTICS_MAXIMUM_TIME]) {
+        statistics[VELOCITY_STATISTICS_MAXIMUM_TIME] = time;
+    }
+}
+
+void mtsRobot1394::EstimateVelocities(void)
+{
+    const size_t numberOfRows = mVelocity.Positions.rows();
+
+    // FPGA velocity, raw velocity compensated for the FPGA edge delay
+    // if requested, otherwise Amp1394 predicted velocity
+    if (mAccelerationCompensatedVelocity) {
+        osaRobot1394AccelerationCompensation(mNumberOfActuators,
+                                             mEncoderVelocityCountsPerSec.Pointer(),
+                                             mEncoderAccelerationCountsPerSecSec.Pointer(),
+                                             mEncoderVelocityDelay.Pointer(),
+                                             mEncoderVelocityCompensatedCountsPerSec.Pointer());
+    }
+    const vctDoubleVec & fpgaVelocity = mAccelerationCompensatedVelocity ?
+        mEncoderVelocityCompensatedCountsPerSec : mEncoderVelocityPredictedCountsPerSec;
+
+    // add latest sample to ring buffers, encoder counts and time
+    if (mVelocity.Reset) {
+        mVelocity.Samples = 0;
+    } else {
+        mVelocity.Head = (mVelocity.Head + 1) % numberOfRows;
+    }
+    const size_t head = mVelocity.Head;
+    const size_t previous = (head + numberOfRows - 1) % numberOfRows;
+    double * positions = mVelocity.Positions.Row(head).Pointer();
+    double * times = mVelocity.Times.Row(head).Pointer();
+    const double * previousPositions = mVelocity.Positions.Row(previous).Pointer();
+    const double * previousTimes = mVelocity.Times.Row(previous).Pointer();
+    for (size_t i = 0; i < mNumberOfActuators; i++) {
+        positions[i] = mEncoderPositionBits[i];
+        // FPGA time, exact sample spacing even if the robot is not polled every read
+        times[i] = mActuatorInfo[i].Clock->Time();
+    }
+    if (mVelocity.Samples < numberOfRows) {
+        mVelocity.Samples++;
+    }
+    if (mVelocity.Reset) {
+        mVelocity.ObserverPosition.Assign(mVelocity.Positions.Row(head));
+        mVelocity.ObserverVelocity.Assign(fpgaVelocity);
+        mVelocity.Reset = false;
+    }
+    // until we have 2 samples, software estimators fall back on the FPGA estimate
+    const bool hasPrevious = (mVelocity.Samples > 1);
+    const double * fpga = fpgaVelocity.Pointer();
+    // estimators are timed only when comparing them, see
+    // SetEstimateAllVelocities.  Rows of estimators not used stay at 0
+    const bool timed = mVelocity.All;
+    double start = 0.0;
+
+    // FPGA, velocity measured using the time between encoder edges
+    if (mVelocity.All || mVelocity.NumberOfActuators[osaVelocityEstimator1394::VELOCITY_FPGA]) {
+        if (timed) {
+            start = osaGetTime();
+        }
+        mVelocity.Estimates.Row(osaVelocityEstimator1394::VELOCITY_FPGA).Assign(fpgaVelocity);
+        if (timed) {
+            UpdateVelocityStatistics(osaVelocityEstimator1394::VELOCITY_FPGA, osaGetTime() - start);
+        }
+    }
+
+    // backward difference between the last 2 samples
+    if (mVelocity.All || mVelocity.NumberOfActuators[osaVelocityEstimator1394::VELOCITY_FINITE_DIFFERENCE]) {
+        if (timed) {
+            start = osaGetTime();
+        }
+        double * estimates = mVelocity.Estimates.Row(osaVelocityEstimator1394::VELOCITY_FINITE_DIFFERENCE).Pointer();
+        for (size_t i = 0; i < mNumberOfActuators; i++) {
+            const double dt = times[i] - previousTimes[i];
+            estimates[i] = (hasPrevious && (dt > 0.0)) ? (positions[i] - previousPositions[i]) / dt : fpga[i];
+        }
+        if (timed) {
+            UpdateVelocityStatistics(osaVelocityEstimator1394::VELOCITY_FINITE_DIFFERENCE, osaGetTime() - start);
+        }
+    }
+
+    // slope of the least squares line over the last Window samples,
+    // same as a first order Savitzky-Golay derivative for a constant
+    // period.  Samples are relative to the latest one to avoid
+    // cancellation, one pass over the ring buffer for all actuators.
+    if (mVelocity.All || mVelocity.NumberOfActuators[osaVelocityEstimator1394::VELOCITY_LEAST_SQUARES]) {
+        if (timed) {
+            start = osaGetTime();
+        }
+        double * sumWeights = mVelocity.SumWeights.Pointer();
+        double * sumTimes = mVelocity.SumTimes.Pointer();
+        double * sumPositions = mVelocity.SumPositions.Pointer();
+        double * sumTimes2 = mVelocity.SumTimes2.Pointer();
+        double * sumTimesPositions = mVelocity.SumTimesPositions.Pointer();
+        const int * window = mVelocity.Window.Pointer();
+        mVelocity.SumWeights.SetAll(0.0);
+        mVelocity.SumTimes.SetAll(0.0);
+        mVelocity.SumPositions.SetAll(0.0);
+        mVelocity.SumTimes2.SetAll(0.0);
+        mVelocity.SumTimesPositions.SetAll(0.0);
+        for (size_t sample = 0; sample < mVelocity.Samples; ++sample) {
+            const size_t row = (head + numberOfRows - sample) % numberOfRows;
+            const double * rowPositions = mVelocity.Positions.Row(row).Pointer();
+            const double * rowTimes = mVelocity.Times.Row(row).Pointer();
+            const int index = static_cast<int>(sample);
+            for (size_t i = 0; i < mNumberOfActuators; i++) {
+                const double weight = (index < window[i]) ? 1.0 : 0.0;
+                const double t = rowTimes[i] - times[i];
+                const double x = rowPositions[i] - positions[i];
+                sumWeights[i] += weight;
+                sumTimes[i] += weight * t;
+                sumPositions[i] += weight * x;
+                sumTimes2[i] += weight * t * t;
+                sumTimesPositions[i] += weight * t * x;
+            }
+        }
+        double * estimates = mVelocity.Estimates.Row(osaVelocityEstimator1394::VELOCITY_LEAST_SQUARES).Pointer();
+        for (size_t i = 0; i < mNumberOfActuators; i++) {
+            const double denominator = sumWeights[i] * sumTimes2[i] - sumTimes[i] * sumTimes[i];
+            estimates[i] = (denominator > 0.0) ?
+                (sumWeights[i] * sumTimesPositions[i] - sumTimes[i] * sumPositions[i]) / denominator
+                : fpga[i];
+        }
+        if (timed) {
+            UpdateVelocityStatistics(osaVelocityEstimator1394::VELOCITY_LEAST_SQUARES, osaGetTime() - start);
+        }
+    }
+
+    // alpha-beta tracking observer on position, gains are computed
+    // for a critically damped response with the requested bandwidth
+    // and the actual time step, stable for any time step
+    double * observerPosition = mVelocity.ObserverPosition.Pointer();
+    double * observerVelocity = mVelocity.ObserverVelocity.Pointer();
+    if (mVelocity.All || mVelocity.NumberOfActuators[osaVelocityEstimator1394::VELOCITY_OBSERVER]) {
+        if (timed) {
+            start = osaGetTime();
+        }
+        const double * bandwidth = mVelocity.ObserverBandwidth.Pointer();
+        double * estimates = mVelocity.Estimates.Row(osaVelocityEstimator1394::VELOCITY_OBSERVER).Pointer();
+        for (size_t i = 0; i < mNumberOfActuators; i++) {
+            const double dt = hasPrevious ? (times[i] - previousTimes[i]) : 0.0;
+            const double pole = std::exp(-bandwidth[i] * dt);
+            const double alpha = 1.0 - pole * pole;
+            const double beta = (1.0 - pole) * (1.0 - pole);
+            observerPosition[i] += observerVelocity[i] * dt;
+            const double error = positions[i] - observerPosition[i];
+            observerPosition[i] += alpha * error;
+            observerVelocity[i] += (dt > 0.0) ? (beta * error / dt) : 0.0;
+            estimates[i] = observerVelocity[i];
+        }
+        if (timed) {
+            UpdateVelocityStatistics(osaVelocityEstimator1394::VELOCITY_OBSERVER, osaGetTime() - start);
+        }
+    } else {
+        // keep observer close to measurements in case it's enabled later
+        mVelocity.ObserverPosition.Assign(mVelocity.Positions.Row(head));
+        mVelocity.ObserverVelocity.Assign(fpgaVelocity);
+    }
+
+    // counts/s to SI units, selected estimator for each actuator
+    for (size_t estimator = 0; estimator < NUMBER_OF_VELOCITY_ESTIMATORS; ++estimator) {
+        if (mVelocity.All || mVelocity.NumberOfActuators[estimator]) {
+            mVelocity.EstimatesSI.Row(estimator).ElementwiseProductOf(mBitsToPositionScales,
+                                                                      mVelocity.Estimates.Row(estimator));
+        }
+    }
+    for (size_t i = 0; i < mNumberOfActuators; i++) {
+        mActuatorMeasuredJS.Velocity()[i] = mVelocity.EstimatesSI.Element(mVelocity.Estimator[i], i);
+    }
+}
+
 void mtsRobot1394::CheckState(void)
 {
+    osaTrace1394::Scope trace("Robot::CheckState");
     // set data as invalid by default
     mMeasuredJS.SetValid(false);
     mActuatorMeasuredJS.SetValid(false);
@@ -930,6 +1235,7 @@ void mtsRobot1394::CheckState(void)
                  ++limit,
                  ++index) {
             if (fabs(*feedback) >= *limit) {
+                SAW_ROBOTIO1394_PROBE2(safety_actuator_current, mName.c_str(), index);
                 CMN_LOG_CLASS_RUN_WARNING << "CheckState: " << this->mName << ", actuator " << index
                                           << " power: " << *feedback
                                           << " > limit: " << *limit << std::endl;
@@ -948,6 +1254,7 @@ void mtsRobot1394::CheckState(void)
                  ++limit,
                  ++index) {
             if (fabs(*feedback) >= *limit) {
+                SAW_ROBOTIO1394_PROBE2(safety_brake_current, mName.c_str(), index);
                 CMN_LOG_CLASS_RUN_WARNING << "CheckState: " << this->mName << ", brake " << index
                                           << " power: " << *feedback
                                           << " > limit: " << *limit << std::endl;
@@ -963,6 +1270,7 @@ void mtsRobot1394::CheckState(void)
     }
 
     if (mCurrentSafetyViolationsCounter > mCurrentSafetyViolationsMaximum) {
+        SAW_ROBOTIO1394_PROBE1(safety_current_power_off, mName.c_str());
         this->PowerOffSequence(false /* do no open safety relays */);
         cmnThrow(this->Name() + ": too many consecutive current safety violations.  Power has been disabled.");
     }
@@ -978,6 +1286,7 @@ void mtsRobot1394::CheckState(void)
     if (newSafetyAmpDisabled && !mSafetyAmpDisabled) {
         // update status - this needs to be here, throw will interrupt execution...
         mSafetyAmpDisabled = newSafetyAmpDisabled;
+        SAW_ROBOTIO1394_PROBE1(safety_amp_disable, mName.c_str());
         // throw only if this is new
         cmnThrow(this->Name() + ": hardware current safety amp disable tripped." + mActuatorTimestamp.ToString());
     } else {
@@ -1042,12 +1351,14 @@ void mtsRobot1394::CheckState(void)
         }
 
         if (temperatureError) {
+            SAW_ROBOTIO1394_PROBE1(safety_temperature_error, mName.c_str());
             this->PowerOffSequence(false /* do not open safety relays */);
             std::stringstream message;
             message << "IO: " << this->Name() << " controller measured temperature is " << temperatureTrigger
                     << "ºC, error threshold is set to " << sawRobotIO1394::TemperatureErrorThreshold << "ºC";
             mInterface->SendError(message.str());
         } else if (temperatureWarning) {
+            SAW_ROBOTIO1394_PROBE1(safety_temperature_warning, mName.c_str());
             if (mTimeLastTemperatureWarning >= sawRobotIO1394::TimeBetweenTemperatureWarnings) {
                 std::stringstream message;
                 message << "IO: " << this->Name() << " controller measured temperature is " << temperatureTrigger
@@ -1135,6 +1446,7 @@ void mtsRobot1394::CheckState(void)
                                 // maybe it's not new, used for reporting
                                 if (*potValid) {
                                     // this is new
+                                    SAW_ROBOTIO1394_PROBE2(safety_potentiometer, mName.c_str(), pot - mPotPosition.begin());
                                     statusChanged = true;
                                     error = true;
                                     *potValid = false;
@@ -1187,6 +1499,7 @@ void mtsRobot1394::CheckState(void)
         this->SetEncoderPosition(vctDoubleVec(mNumberOfActuators, 0.0));
         if (mEncoderOverflow.NotEqual(mPreviousEncoderOverflow)) {
             mPreviousEncoderOverflow.Assign(mEncoderOverflow);
+            SAW_ROBOTIO1394_PROBE1(safety_encoder_overflow, mName.c_str());
             std::string errorMessage = this->Name() + ": encoder overflow detected: ";
             errorMessage.append(mEncoderOverflow.ToString());
             // if we have already performed encoder calibration, this is really bad
@@ -1207,6 +1520,7 @@ void mtsRobot1394::CheckState(void)
         if (!mFullyPowered && mUserExpectsPower) {
             // give some time to power, if greater then it's an issue
             if ((mStateTableRead->Tic - mPoweringStartTime) > sawRobotIO1394::MaximumTimeToPower) {
+                SAW_ROBOTIO1394_PROBE1(safety_power_lost, mName.c_str());
                 mInterface->SendError("IO: " + this->Name() + " power is unexpectedly off");
             }
         }
@@ -1215,6 +1529,7 @@ void mtsRobot1394::CheckState(void)
     if (mPreviousWatchdogTimeoutStatus != mWatchdogTimeoutStatus) {
         EventTriggers.WatchdogTimeoutStatus(mWatchdogTimeoutStatus);
         if (mWatchdogTimeoutStatus) {
+            SAW_ROBOTIO1394_PROBE1(safety_watchdog, mName.c_str());
             mInterface->SendError("IO: " + this->Name() + " watchdog triggered");
         } else {
             mInterface->SendStatus("IO: " + this->Name() + " watchdog ok");
@@ -1228,13 +1543,13 @@ void mtsRobot1394::CheckState(void)
             CalibrateEncoderOffsets.SamplesFromPots--;
         } else {
             // data read from state table
-            vctDoubleVec potentiometers(mNumberOfActuators, 0.0);
-            mtsGenericObjectProxy<vctDoubleVec> newPot;
-            newPot.Data.SetSize(mNumberOfActuators);
-            vctDoubleVec encoderRef(mNumberOfActuators, 0.0);
-            vctDoubleVec encoderDelta(mNumberOfActuators);
-            prmStateJoint newEnc;
-            newEnc.Position().SetSize(mNumberOfActuators);
+            vctDoubleVec & potentiometers = mScratch.Potentiometers;
+            potentiometers.SetAll(0.0);
+            mtsGenericObjectProxy<vctDoubleVec> & newPot = mScratch.PotentiometersSample;
+            vctDoubleVec & encoderRef = mScratch.EncoderReference;
+            encoderRef.SetAll(0.0);
+            vctDoubleVec & encoderDelta = mScratch.EncoderDelta;
+            prmStateJoint & newEnc = mScratch.EncodersSample;
 
             int nbElements = 0;
             mtsStateIndex index = mStateTableRead->GetIndexReader();
@@ -1261,7 +1576,7 @@ void mtsRobot1394::CheckState(void)
             potentiometers.Divide(nbElements);
 
             // determine where pots are
-            vctDoubleVec actuatorPosition(mNumberOfActuators);
+            vctDoubleVec & actuatorPosition = mScratch.ActuatorPositions;
             switch(mPotType) {
             case osaPot1394Location::POTENTIOMETER_UNDEFINED:
                 cmnThrow("mtsRobot1394::CheckState: can't set encoder offset, potentiometer's position undefined");
@@ -1337,6 +1652,14 @@ void mtsRobot1394::SetWatchdogPeriod(const double & periodInSeconds)
     EventTriggers.WatchdogPeriod(mWatchdogPeriod);
 }
 
+void mtsRobot1394::Invalidate(void)
+{
+    mStateTableRead->Start();
+    mValid = false;
+    mFullyPowered = false;
+    mStateTableRead->Advance();
+}
+
 void mtsRobot1394::WriteSafetyRelay(const bool & close)
 {
     for (auto & board : mUniqueBoards) {
@@ -1388,9 +1711,8 @@ void mtsRobot1394::SetBrakeAmpEnable(const vctBoolVec & enable)
 
 void mtsRobot1394::SetEncoderPosition(const vctDoubleVec & pos)
 {
-    vctIntVec bits(mNumberOfActuators);
-    this->EncoderPositionToBits(pos, bits);
-    this->SetEncoderPositionBits(bits);
+    this->EncoderPositionToBits(pos, mScratch.ActuatorBits);
+    this->SetEncoderPositionBits(mScratch.ActuatorBits);
 }
 
 void mtsRobot1394::SetEncoderPositionBits(const vctIntVec & bits)
@@ -1398,6 +1720,8 @@ void mtsRobot1394::SetEncoderPositionBits(const vctIntVec & bits)
     for (size_t i = 0; i < mNumberOfActuators; i++) {
         mActuatorInfo[i].Board->WriteEncoderPreload(mActuatorInfo[i].Axis, bits[i]);
     }
+    // position history is no longer valid
+    ResetVelocityEstimators();
 }
 
 void mtsRobot1394::SetSingleEncoderPosition(const int index, const double pos)
@@ -1408,6 +1732,7 @@ void mtsRobot1394::SetSingleEncoderPosition(const int index, const double pos)
 void mtsRobot1394::SetSingleEncoderPositionBits(const int index, const int bits)
 {
     mActuatorInfo[index].Board->WriteEncoderPreload(mActuatorInfo[index].Axis, bits);
+    ResetVelocityEstimators();
 }
 
 void mtsRobot1394::ClipActuatorEffort(vctDoubleVec & efforts)
@@ -1427,7 +1752,7 @@ void mtsRobot1394::ClipBrakeCurrent(vctDoubleVec & currents)
 
 void mtsRobot1394::SetJointEffort(const vctDoubleVec & efforts)
 {
-    vctDoubleVec actuatorEfforts(mNumberOfActuators);
+    vctDoubleVec & actuatorEfforts = mScratch.ActuatorEfforts;
     if (mConfiguration.HasActuatorToJointCoupling) {
         actuatorEfforts.ProductOf(mConfiguration.Coupling.JointToActuatorEffort(), efforts);
     } else {
@@ -1439,27 +1764,18 @@ void mtsRobot1394::SetJointEffort(const vctDoubleVec & efforts)
 void mtsRobot1394::SetActuatorEffort(const vctDoubleVec & efforts)
 {
     // Convert efforts to bits and set the command
-    vctDoubleVec clipped_efforts = efforts;
-    vctDoubleVec currents(mNumberOfActuators);
-
     // this->clip_actuator_efforts(clipped_efforts);
-
-    this->ActuatorEffortToCurrent(clipped_efforts, currents);
-    this->SetActuatorCurrent(currents);
+    this->ActuatorEffortToCurrent(efforts, mScratch.ActuatorCurrents);
+    this->SetActuatorCurrent(mScratch.ActuatorCurrents);
 }
 
 void mtsRobot1394::SetActuatorCurrent(const vctDoubleVec & currents)
 {
-    // Convert amps to bits and set the command
-    vctDoubleVec clipped_amps = currents;
-    vctIntVec bits(mNumberOfActuators);
-
-    this->ClipActuatorCurrent(clipped_amps);
-    this->ActuatorCurrentToBits(clipped_amps, bits);
-    this->SetActuatorCurrentBits(bits);
-
-    // Store commanded amps
-    mActuatorCurrentCommand = clipped_amps;
+    // Store clipped commanded amps, then convert to bits and set the command
+    mActuatorCurrentCommand.Assign(currents);
+    this->ClipActuatorCurrent(mActuatorCurrentCommand);
+    this->ActuatorCurrentToBits(mActuatorCurrentCommand, mScratch.ActuatorBits);
+    this->SetActuatorCurrentBits(mScratch.ActuatorBits);
 }
 
 void mtsRobot1394::SetActuatorCurrentBits(const vctIntVec & bits)
@@ -1474,16 +1790,11 @@ void mtsRobot1394::SetActuatorCurrentBits(const vctIntVec & bits)
 
 void mtsRobot1394::SetBrakeCurrent(const vctDoubleVec & currents)
 {
-    // Convert amps to bits and set the command
-    vctDoubleVec clipped_amps = currents;
-    vctIntVec bits(mNumberOfBrakes);
-
-    this->ClipBrakeCurrent(clipped_amps);
-    this->BrakeCurrentToBits(clipped_amps, bits);
-    this->SetBrakeCurrentBits(bits);
-
-    // Store commanded amps
-    mBrakeCurrentCommand = clipped_amps;
+    // Store clipped commanded amps, then convert to bits and set the command
+    mBrakeCurrentCommand.Assign(currents);
+    this->ClipBrakeCurrent(mBrakeCurrentCommand);
+    this->BrakeCurrentToBits(mBrakeCurrentCommand, mScratch.BrakeBits);
+    this->SetBrakeCurrentBits(mScratch.BrakeBits);
 }
 
 void mtsRobot1394::SetBrakeCurrentBits(const vctIntVec & bits)
@@ -1515,7 +1826,7 @@ void mtsRobot1394::BrakeEngage(void)
 
 void mtsRobot1394::CalibrateEncoderOffsetsFromPots(void)
 {
-    vctDoubleVec actuatorPosition(mNumberOfActuators);
+    vctDoubleVec & actuatorPosition = mScratch.ActuatorPositions;
     switch(mPotType) {
     case osaPot1394Location::POTENTIOMETER_UNDEFINED:
         cmnThrow("mtsRobot1394::CalibrateEncoderOffsetsFromPots: can't set encoder offset, potentiometer's position undefined");
@@ -1564,6 +1875,10 @@ const vctDoubleVec & mtsRobot1394::BrakeTimeStamp(void) const {
     return mBrakeTimestamp;
 }
 
+const vctDoubleVec & mtsRobot1394::ActuatorSampleTime(void) const {
+    return mActuatorSampleTime;
+}
+
 const vctDoubleVec & mtsRobot1394::ActuatorEncoderAcceleration(void) const {
     return mActuatorEncoderAcceleration;
 }
@@ -1664,36 +1979,16 @@ void mtsRobot1394::EncoderBitsToPosition(const vctIntVec & bits, vctDoubleVec &
     }
 }
 
-#if 0
 void mtsRobot1394::EncoderBitsToVelocityPredicted(vctDoubleVec & vel) const
 {
-    if ((mLowestFirmWareVersion >= 6) && (mHighestFirmWareVersion >= 6)) {
-        const vctDoubleVec::iterator end = vel.end();
-        vctDoubleVec::iterator velocity = vel.begin();
-        vctDoubleVec::const_iterator enc_vel_cnts_per_sec = mEncoderVelocityCountsPerSecond.begin();
-        vctDoubleVec::const_iterator enc_acc_cnts_per_sec_sec = mEncoderAccelerationCountsPerSecSec.begin();
-        vctDoubleVec::const_iterator enc_vel_delay = mEncoderVelocityDelay.begin();
-        vctDoubleVec::const_iterator scale = mBitsToPositionScales.begin();
-        for (; velocity != end;
-             ++velocity,
-                 ++enc_vel_cnts_per_sec,
-                 ++enc_acc_cnts_per_sec_sec,
-                 ++enc_vel_delay,
-                 ++scale) {
-            const double vel_term = *enc_vel_cnts_per_sec;
-            const double acc_term = *enc_acc_cnts_per_sec_sec * *enc_vel_delay;
-            // Don't decelerate past a zero-crossing; first expression checks whether vel_term and
-            // acc_term have different signs (i.e., one positive and one negative).
-            if ((vel_term * acc_term < 0.0) && (abs(acc_term) > abs(vel_term))){
-                *velocity = 0.0;
-            }
-            else {
-                *velocity = *scale * (vel_term + acc_term);
-            }
-        }
-    }
+    vel.SetSize(mNumberOfActuators);
+    osaRobot1394AccelerationCompensation(mNumberOfActuators,
+                                         mEncoderVelocityCountsPerSec.Pointer(),
+                                         mEncoderAccelerationCountsPerSecSec.Pointer(),
+                                         mEncoderVelocityDelay.Pointer(),
+                                         vel.Pointer());
+    vel.ElementwiseMultiply(mBitsToPositionScales);
 }
-#endif
 
 void mtsRobot1394::ActuatorEffortToCurrent(const vctDoubleVec & efforts, vctDoubleVec & currents) const {
     currents.ElementwiseProductOf(efforts, mEffortToCurrentScales);
@@ -16,21 +16,44 @@
  --- end cisst license ---
  */
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <thread>
 
 #include <cisstBuildType.h>
+#include <cisstCommon/cmnPortability.h>
+
 #include <cisstCommon/cmnLogger.h>
 #include <cisstCommon/cmnUnits.h>
+#include <cisstOSAbstraction/osaGetTime.h>
+#include <cisstOSAbstraction/osaSleep.h>
+#include <cisstOSAbstraction/osaCPUAffinity.h>
+
+#if (CISST_OS == CISST_LINUX)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#endif
 
 #include <cisstMultiTask/mtsInterfaceProvided.h>
 
 #include <sawRobotIO1394/mtsRobotIO1394.h>
 #include <sawRobotIO1394/mtsDigitalInput1394.h>
+#include <sawRobotIO1394/mtsDigitalInputBank1394.h>
 #include <sawRobotIO1394/mtsDigitalOutput1394.h>
 #include <sawRobotIO1394/mtsDallasChip1394.h>
 #include <sawRobotIO1394/mtsRobot1394.h>
 #include <sawRobotIO1394/osaXML1394.h>
+#include <sawRobotIO1394/osaJSON1394.h>
+#include <sawRobotIO1394/osaCache1394.h>
+#include <sawRobotIO1394/osaTrace1394.h>
+#include <sawRobotIO1394/osaProbes1394.h>
+#include <sawRobotIO1394/osaAllocationGuard1394.h>
 
 #include <Amp1394/AmpIORevision.h>
 #include "PortFactory.h"
@@ -40,6 +63,20 @@ CMN_IMPLEMENT_SERVICES_DERIVED_ONEARG(mtsRobotIO1394, mtsTaskPeriodic, mtsTaskPe
 
 using namespace sawRobotIO1394;
 
+namespace {
+    // CPUs that can be used with osaCPUSetAffinity, limited by the
+    // number of CPUs and bits in the mask
+    int NumberOfAffinityCPUs(void)
+    {
+        int count = static_cast<int>(sizeof(osaCPUMask) * CHAR_BIT);
+        const unsigned int hardware = std::thread::hardware_concurrency();
+        if ((hardware > 0) && (static_cast<int>(hardware) < count)) {
+            count = static_cast<int>(hardware);
+        }
+        return count;
+    }
+}
+
 mtsRobotIO1394::mtsRobotIO1394(const std::string & name, const double periodInSeconds, const std::string & port):
     mtsTaskPeriodic(name, periodInSeconds)
 {
@@ -52,8 +89,35 @@ mtsRobotIO1394::mtsRobotIO1394(const mtsTaskPeriodicConstructorArg & arg):
     Init(mtsRobotIO1394::DefaultPort());
 }
 
+mtsRobotIO1394::mtsRobotIO1394(const std::string & name, const double periodInSeconds,
+                               const std::vector<BasePort *> & ports):
+    mtsTaskPeriodic(name, periodInSeconds)
+{
+    Init(ports);
+}
+
 mtsRobotIO1394::~mtsRobotIO1394()
 {
+    // stop port threads if Cleanup has not been called
+    StopPortWorkers();
+
+    // staged change never applied, or previous lists
+    if (mStagedChangesPending) {
+        DiscardStagedChanges(mStagedChanges);
+    } else {
+        RetireStagedChanges(mStagedChanges);
+    }
+
+    // devices removed at runtime
+    mRobots.insert(mRobots.end(), mRetiredRobots.begin(), mRetiredRobots.end());
+    mRetiredRobots.clear();
+    mDigitalInputs.insert(mDigitalInputs.end(), mRetiredDigitalInputs.begin(), mRetiredDigitalInputs.end());
+    mRetiredDigitalInputs.clear();
+    mDigitalOutputs.insert(mDigitalOutputs.end(), mRetiredDigitalOutputs.begin(), mRetiredDigitalOutputs.end());
+    mRetiredDigitalOutputs.clear();
+    mDallasChips.insert(mDallasChips.end(), mRetiredDallasChips.begin(), mRetiredDallasChips.end());
+    mRetiredDallasChips.clear();
+
     // delete robots before deleting boards
     for (auto & robot : mRobots) {
         if (robot != 0) {
@@ -64,6 +128,10 @@ mtsRobotIO1394::~mtsRobotIO1394()
     mRobotsByName.clear();
 
     // delete digital inputs before deleting boards
+    for (auto & bank : mDigitalInputBanks) {
+        delete bank.second;
+    }
+    mDigitalInputBanks.clear();
     for (auto & input : mDigitalInputs) {
         if (input != 0) {
             delete input;
@@ -90,21 +158,38 @@ mtsRobotIO1394::~mtsRobotIO1394()
     mDallasChips.clear();
     mDallasChipsByName.clear();
 
+    // state tables used by digital IOs and Dallas chips added at runtime
+    for (auto & stateTable : mStagedStateTables) {
+        delete stateTable;
+    }
+    mStagedStateTables.clear();
+
     // delete board structures
     for (board_iterator iter = mBoards.begin();
          iter != mBoards.end();
          ++iter) {
         if (iter->second != 0) {
-            mPort->RemoveBoard(iter->first);
+            mPorts[iter->first / MAX_BOARDS]->RemoveBoard(iter->first % MAX_BOARDS);
+            delete iter->second->Board;
             delete iter->second;
         }
     }
     mBoards.clear();
+    // boards removed at runtime are no longer on their port
+    for (auto & board : mRetiredBoards) {
+        delete board->Board;
+        delete board;
+    }
+    mRetiredBoards.clear();
 
-    // delete firewire port
-    if (mPort != 0) {
-        delete mPort;
+    // delete ports
+    for (auto & port : mPorts) {
+        delete port;
     }
+    mPorts.clear();
+    mPort = 0;
+
+    delete mFlightRecorder;
 
     // delete message stream
     delete mMessageStream;
@@ -112,26 +197,127 @@ mtsRobotIO1394::~mtsRobotIO1394()
 
 void mtsRobotIO1394::SetProtocol(const sawRobotIO1394::ProtocolType & protocol)
 {
-    bool ok = false;
-    switch (protocol) {
-    case PROTOCOL_SEQ_RW:
-        ok = mPort->SetProtocol(BasePort::PROTOCOL_SEQ_RW);
-        break;
-    case PROTOCOL_SEQ_R_BC_W:
-        ok = mPort->SetProtocol(BasePort::PROTOCOL_SEQ_R_BC_W);
-        break;
-    case PROTOCOL_BC_QRW:
-        ok = mPort->SetProtocol(BasePort::PROTOCOL_BC_QRW);
-        break;
-    default:
-        break;
-    }
-    if (!ok) {
+    // benchmark in Startup once all boards are known
+    if (protocol == PROTOCOL_AUTO) {
+        mAutoProtocol = true;
+        return;
+    }
+    mAutoProtocol = false;
+    if (!SetPortsProtocol(protocol)) {
         CMN_LOG_CLASS_INIT_ERROR << "mtsRobot1394::SetProtocol failed" << std::endl;
         exit(EXIT_FAILURE);
     }
 }
 
+bool mtsRobotIO1394::SetPortsProtocol(const sawRobotIO1394::ProtocolType protocol)
+{
+    bool ok = !mPorts.empty();
+    for (auto & port : mPorts) {
+        switch (protocol) {
+        case PROTOCOL_SEQ_RW:
+            ok &= port->SetProtocol(BasePort::PROTOCOL_SEQ_RW);
+            break;
+        case PROTOCOL_SEQ_R_BC_W:
+            ok &= port->SetProtocol(BasePort::PROTOCOL_SEQ_R_BC_W);
+            break;
+        case PROTOCOL_BC_QRW:
+            ok &= port->SetProtocol(BasePort::PROTOCOL_BC_QRW);
+            break;
+        default:
+            ok = false;
+            break;
+        }
+    }
+    if (ok) {
+        mProtocol = protocol;
+    }
+    return ok;
+}
+
+void mtsRobotIO1394::BenchmarkProtocols(void)
+{
+    // from most to least conservative
+    const ProtocolType protocols[] = {PROTOCOL_SEQ_RW, PROTOCOL_SEQ_R_BC_W, PROTOCOL_BC_QRW};
+    const size_t numberOfProtocols = sizeof(protocols) / sizeof(ProtocolType);
+    mProtocolBenchmark.SetSize(numberOfProtocols, BENCHMARK_NUMBER_OF_COLUMNS);
+    mProtocolBenchmark.SetAll(0.0);
+
+    int best = -1;
+    for (size_t index = 0; index < numberOfProtocols; ++index) {
+        vctDoubleMat::RowRefType row = mProtocolBenchmark.Row(index);
+        row[BENCHMARK_PROTOCOL] = protocols[index];
+        if (!SetPortsProtocol(protocols[index])) {
+            CMN_LOG_CLASS_INIT_WARNING << "BenchmarkProtocols: protocol " << protocols[index]
+                                       << " not supported by all boards" << std::endl;
+            continue;
+        }
+        row[BENCHMARK_SUPPORTED] = 1.0;
+        const size_t errorsBefore = mTransferErrors;
+        size_t exceptions = 0;
+        for (size_t cycle = 0; cycle < ProtocolBenchmarkCycles; ++cycle) {
+            try {
+                TransferAllPorts(PORT_READ);
+                row[BENCHMARK_READ_TIME] += mPortReadTime.SumOfElements() / mPorts.size();
+                TransferAllPorts(PORT_WRITE);
+                row[BENCHMARK_WRITE_TIME] += mPortWriteTime.SumOfElements() / mPorts.size();
+            } catch (...) {
+                exceptions++;
+            }
+        }
+        row[BENCHMARK_READ_TIME] /= ProtocolBenchmarkCycles;
+        row[BENCHMARK_WRITE_TIME] /= ProtocolBenchmarkCycles;
+        // read and write per cycle
+        row[BENCHMARK_ERROR_RATE] = static_cast<double>(mTransferErrors - errorsBefore + exceptions)
+            / (2.0 * ProtocolBenchmarkCycles);
+        CMN_LOG_CLASS_INIT_VERBOSE << "BenchmarkProtocols: protocol " << protocols[index]
+                                   << ", read " << row[BENCHMARK_READ_TIME] * 1000.0
+                                   << " ms, write " << row[BENCHMARK_WRITE_TIME] * 1000.0
+                                   << " ms, error rate " << row[BENCHMARK_ERROR_RATE] << std::endl;
+        if (row[BENCHMARK_ERROR_RATE] > ProtocolMaxErrorRate) {
+            continue;
+        }
+        if ((best < 0)
+            || ((row[BENCHMARK_READ_TIME] + row[BENCHMARK_WRITE_TIME])
+                < (mProtocolBenchmark.Element(best, BENCHMARK_READ_TIME)
+                   + mProtocolBenchmark.Element(best, BENCHMARK_WRITE_TIME)))) {
+            best = static_cast<int>(index);
+        }
+    }
+
+    if (best < 0) {
+        CMN_LOG_CLASS_INIT_ERROR << "BenchmarkProtocols: no reliable protocol found" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    SetPortsProtocol(protocols[best]);
+    CMN_LOG_CLASS_INIT_WARNING << "BenchmarkProtocols: using protocol " << protocols[best] << std::endl;
+    mCheckedCycles = 0;
+    mCheckedErrors = mTransferErrors;
+}
+
+void mtsRobotIO1394::CheckProtocolErrors(void)
+{
+    mCheckedCycles++;
+    if (mCheckedCycles < ProtocolCheckCycles) {
+        return;
+    }
+    const double errorRate = static_cast<double>(mTransferErrors - mCheckedErrors)
+        / (2.0 * mCheckedCycles);
+    mCheckedCycles = 0;
+    mCheckedErrors = mTransferErrors;
+    if ((errorRate <= ProtocolMaxErrorRate)
+        || (mProtocol == PROTOCOL_SEQ_RW)) {
+        return;
+    }
+    // fall back to next more conservative protocol
+    const ProtocolType fallback = (mProtocol == PROTOCOL_BC_QRW) ? PROTOCOL_SEQ_R_BC_W : PROTOCOL_SEQ_RW;
+    CMN_LOG_CLASS_RUN_WARNING << "CheckProtocolErrors: error rate " << errorRate
+                              << " with protocol " << mProtocol
+                              << ", switching to protocol " << fallback << std::endl;
+    // ports can't be modified during a transfer
+    CompletePendingWrite();
+    SetPortsProtocol(fallback);
+}
+
 void mtsRobotIO1394::SetWatchdogPeriod(const double & periodInSeconds)
 {
     mWatchdogPeriod = periodInSeconds;
@@ -141,6 +327,29 @@ void mtsRobotIO1394::SetWatchdogPeriod(const double & periodInSeconds)
 }
 
 void mtsRobotIO1394::Init(const std::string & port)
+{
+    // create ports, comma separated list
+    mMessageStream = new std::ostream(this->GetLogMultiplexer());
+    std::vector<BasePort *> ports;
+    std::stringstream portList(port);
+    std::string portName;
+    while (std::getline(portList, portName, ',')) {
+        BasePort * newPort = PortFactory(portName.c_str(), *mMessageStream);
+        if (!newPort) {
+            CMN_LOG_CLASS_INIT_ERROR << "Init: unknown port type: " << portName
+                                     << ", port can be: " << std::endl
+                                     << "  - a single number (implicitly a FireWire port)" << std::endl
+                                     << "  - fw[:X] for a FireWire port" << std::endl
+                                     << "  - udp[:xx.xx.xx.xx] for raw UDP (IP is optional)" << std::endl
+                                     << "  - a comma separated list of ports" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        ports.push_back(newPort);
+    }
+    Init(ports);
+}
+
+void mtsRobotIO1394::Init(const std::vector<BasePort *> & ports)
 {
     // write warning to cerr if not compiled in Release mode
     if (std::string(CISST_BUILD_TYPE) != "Release") {
@@ -156,6 +365,8 @@ void mtsRobotIO1394::Init(const std::string & port)
     // default watchdog period
     mWatchdogPeriod = sawRobotIO1394::WatchdogTimeout;
     mSkipConfigurationCheck = false;
+    mStagedChangesPending = false;
+    mStagingErrorsPending = false;
 
     // add state tables for stats
     mStateTableRead = new mtsStateTable(100, this->GetName() + "Read");
@@ -163,33 +374,80 @@ void mtsRobotIO1394::Init(const std::string & port)
     mStateTableWrite = new mtsStateTable(100, this->GetName() + "Write");
     mStateTableWrite->SetAutomaticAdvance(false);
 
-    // create port
-    mMessageStream = new std::ostream(this->GetLogMultiplexer());
-    mPort = PortFactory(port.c_str(), *mMessageStream);
-    if (!mPort) {
-        CMN_LOG_CLASS_INIT_ERROR << "Init: unknown port type: " << port
-                                 << ", port can be: " << std::endl
-                                 << "  - a single number (implicitly a FireWire port)" << std::endl
-                                 << "  - fw[:X] for a FireWire port" << std::endl
-                                 << "  - udp[:xx.xx.xx.xx] for raw UDP (IP is optional)"
-                                 << std::endl;
-        exit(EXIT_FAILURE);
+    // ports created from the port string or by caller
+    if (!mMessageStream) {
+        mMessageStream = new std::ostream(this->GetLogMultiplexer());
+    }
+    for (auto & newPort : ports) {
+        // test port
+        if (!newPort->IsOK()) {
+            CMN_LOG_CLASS_INIT_ERROR << "Init: failed to initialize " << newPort->GetPortTypeString() << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        mPorts.push_back(newPort);
     }
-    // test port
-    if (!mPort->IsOK()) {
-        CMN_LOG_CLASS_INIT_ERROR << "Init: failed to initialize " << mPort->GetPortTypeString() << std::endl;
+    if (mPorts.empty()) {
+        CMN_LOG_CLASS_INIT_ERROR << "Init: no port specified" << std::endl;
         exit(EXIT_FAILURE);
     }
+    mPort = mPorts.at(0);
+    // protocol enums are the same
+    mProtocol = static_cast<ProtocolType>(mPort->GetProtocol());
+
+    // time spent on each port, per cycle
+    mPortReadTime.SetSize(mPorts.size(), 0.0);
+    mPortReadStart.SetSize(mPorts.size(), 0.0);
+    mPortWriteTime.SetSize(mPorts.size(), 0.0);
+    mPortCPUs.resize(mPorts.size(), -1);
+    mStateTableRead->AddData(mPortReadTime, "PortReadTime");
+    mStateTableWrite->AddData(mPortWriteTime, "PortWriteTime");
+    mStateTableRead->AddData(mReadTimeHistogram.Counts(), "ReadTimeHistogram");
+    mStateTableRead->AddData(mWriteWaitHistogram.Counts(), "WriteWaitHistogram");
+    mStateTableWrite->AddData(mWriteTimeHistogram.Counts(), "WriteTimeHistogram");
 
     mtsInterfaceProvided * mainInterface = AddInterfaceProvided("MainInterface");
     if (mainInterface) {
         mainInterface->AddCommandRead(&mtsRobotIO1394::GetNumberOfBoards, this, "GetNumberOfBoards");
+        mainInterface->AddCommandRead(&mtsRobotIO1394::GetBoardIDs, this, "GetBoardIDs");
+        mainInterface->AddCommandRead(&mtsRobotIO1394::GetBoardFirmwareVersions, this, "GetBoardFirmwareVersions");
+        mainInterface->AddCommandRead(&mtsRobotIO1394::GetBoardFPGASerialNumbers, this, "GetBoardFPGASerialNumbers");
+        mainInterface->AddCommandRead(&mtsRobotIO1394::GetBoardQLASerialNumbers, this, "GetBoardQLASerialNumbers");
         mainInterface->AddCommandRead(&mtsRobotIO1394::GetNumberOfRobots, this, "GetNumberOfRobots");
+        mainInterface->AddCommandRead(&mtsRobotIO1394::GetProtocol, this, "GetProtocol");
+        mainInterface->AddCommandRead(&mtsRobotIO1394::GetRealTimeStatus, this, "GetRealTimeStatus");
+        mainInterface->AddCommandRead(&mtsRobotIO1394::GetNumberOfCycleAllocations, this, "GetNumberOfCycleAllocations");
+        mainInterface->AddCommandRead(&mtsRobotIO1394::GetProtocolBenchmark, this, "GetProtocolBenchmark",
+                                      vctDoubleMat(0, BENCHMARK_NUMBER_OF_COLUMNS));
+        // not queued, parsing and checks happen in caller's thread
+        mainInterface->AddCommandWrite(static_cast<void (mtsRobotIO1394::*)(const std::string &)>(&mtsRobotIO1394::StageConfiguration),
+                                       this, "StageConfiguration",
+                                       std::string(), MTS_COMMAND_NOT_QUEUED);
+        mainInterface->AddCommandWrite(&mtsRobotIO1394::StagePortConfiguration, this, "StagePortConfiguration",
+                                       std::vector<std::string>(), MTS_COMMAND_NOT_QUEUED);
+        mainInterface->AddCommandWrite(&mtsRobotIO1394::StageRemoval, this, "StageRemoval",
+                                       std::string(), MTS_COMMAND_NOT_QUEUED);
     } else {
         CMN_LOG_CLASS_INIT_ERROR << "Init: failed to create provided interface \"MainInterface\", method Init should be called only once."
                                  << std::endl;
     }
 
+    mtsInterfaceProvided * diagnosticsInterface = AddInterfaceProvided("Diagnostics");
+    if (diagnosticsInterface) {
+        diagnosticsInterface->AddCommandRead(&mtsRobotIO1394::GetBoardStatistics, this, "GetBoardStatistics",
+                                             vctDoubleMat(0, STATISTICS_NUMBER_OF_COLUMNS));
+        diagnosticsInterface->AddCommandRead(&mtsRobotIO1394::GetBoardReadIntervalHistograms, this,
+                                             "GetBoardReadIntervalHistograms");
+        diagnosticsInterface->AddCommandRead(&mtsRobotIO1394::GetBoardReadIntervalBinWidth, this,
+                                             "GetBoardReadIntervalBinWidth");
+        diagnosticsInterface->AddCommandWrite(&mtsRobotIO1394::SetTracing, this, "SetTracing",
+                                              false, MTS_COMMAND_NOT_QUEUED);
+        diagnosticsInterface->AddCommandWrite(&mtsRobotIO1394::SaveTrace, this, "SaveTrace",
+                                              std::string(), MTS_COMMAND_NOT_QUEUED);
+    } else {
+        CMN_LOG_CLASS_INIT_ERROR << "Init: failed to create provided interface \"Diagnostics\", method Init should be called only once."
+                                 << std::endl;
+    }
+
     // At this stage, the robot interfaces and the digital input interfaces should be ready.
     // Add on Configuration provided interface with functionWrite with vector of strings.
     // Provide names of robot, names of digital inputs, and name of this member.
@@ -221,6 +479,18 @@ void mtsRobotIO1394::Init(const std::string & port)
                                                     "period_statistics_read");
         configurationInterface->AddCommandReadState(*mStateTableWrite, mStateTableWrite->PeriodStats,
                                                     "period_statistics_write");
+        configurationInterface->AddCommandReadState(*mStateTableRead, mPortReadTime,
+                                                    "port_read_time");
+        configurationInterface->AddCommandReadState(*mStateTableWrite, mPortWriteTime,
+                                                    "port_write_time");
+        configurationInterface->AddCommandReadState(*mStateTableRead, mReadTimeHistogram.Counts(),
+                                                    "read_time_histogram");
+        configurationInterface->AddCommandReadState(*mStateTableWrite, mWriteTimeHistogram.Counts(),
+                                                    "write_time_histogram");
+        configurationInterface->AddCommandReadState(*mStateTableRead, mWriteWaitHistogram.Counts(),
+                                                    "write_wait_histogram");
+        configurationInterface->AddCommandRead(&mtsRobotIO1394::GetTimeHistogramBinWidth, this,
+                                               "GetTimeHistogramBinWidth");
     } else {
         CMN_LOG_CLASS_INIT_ERROR << "Configure: unable to create configuration interface." << std::endl;
     }
@@ -239,12 +509,126 @@ void mtsRobotIO1394::SaveConfigurationJSON(const std::string & filename)
     mSaveConfigurationJSON = filename;
 }
 
+void mtsRobotIO1394::UseConfigurationCache(const std::string & directory)
+{
+    mConfigurationCacheDirectory = directory;
+}
+
+bool mtsRobotIO1394::LoadConfiguration(const std::string & filename,
+                                       osaPort1394Configuration & config)
+{
+    // try to use cache first, cache is keyed by file content
+    std::string cacheFilename, sourceHash;
+    bool loadedFromCache = false;
+    if (!mConfigurationCacheDirectory.empty()) {
+        sourceHash = osaCache1394FileHash(filename);
+        const size_t separator = filename.find_last_of("/\\");
+        cacheFilename = mConfigurationCacheDirectory + "/"
+            + ((separator == std::string::npos) ? filename : filename.substr(separator + 1))
+            + ".cache";
+        if (!sourceHash.empty()) {
+            loadedFromCache = osaCache1394LoadPort(cacheFilename, sourceHash, config);
+        }
+    }
+
+    if (!loadedFromCache) {
+        // use file extension to pick the loader, XML by default
+        const std::string jsonExtension = ".json";
+        if ((filename.size() > jsonExtension.size())
+            && (filename.compare(filename.size() - jsonExtension.size(),
+                                 jsonExtension.size(), jsonExtension) == 0)) {
+            if (!osaJSON1394LoadPort(filename, config)) {
+                return false;
+            }
+        } else {
+            if (!osaXML1394LoadPort(filename, config)) {
+                return false;
+            }
+        }
+        if (!sourceHash.empty()) {
+            osaCache1394SavePort(cacheFilename, sourceHash, config);
+        }
+    }
+    return true;
+}
+
+bool mtsRobotIO1394::SetBoardKeys(osaPort1394Configuration & config,
+                                  const size_t portIndex) const
+{
+    if (portIndex >= mPorts.size()) {
+        CMN_LOG_CLASS_INIT_ERROR << "SetBoardKeys: invalid port index " << portIndex
+                                 << ", component has " << mPorts.size() << " port(s)" << std::endl;
+        return false;
+    }
+
+    // Boards are identified by a key, port index * MAX_BOARDS + board Id
+    if (portIndex != 0) {
+        const int offset = static_cast<int>(portIndex * MAX_BOARDS);
+        for (auto & robot : config.Robots) {
+            for (auto & actuator : robot.Actuators) {
+                actuator.BoardID += offset;
+                if (actuator.Brake) {
+                    actuator.Brake->BoardID += offset;
+                }
+            }
+        }
+        for (auto & input : config.DigitalInputs) {
+            input.BoardID += offset;
+        }
+        for (auto & output : config.DigitalOutputs) {
+            output.BoardID += offset;
+        }
+        for (auto & dallas : config.DallasChips) {
+            dallas.BoardID += offset;
+        }
+    }
+    return true;
+}
+
 void mtsRobotIO1394::Configure(const std::string & filename)
 {
-    CMN_LOG_CLASS_INIT_VERBOSE << "Configure: configuring from " << filename << std::endl;
+    Configure(filename, 0);
+}
+
+void mtsRobotIO1394::Configure(const std::string & filename, const size_t portIndex)
+{
+    CMN_LOG_CLASS_INIT_VERBOSE << "Configure: configuring from " << filename
+                               << " for port " << portIndex << std::endl;
 
     osaPort1394Configuration config;
-    osaXML1394ConfigurePort(filename, config);
+    if (!LoadConfiguration(filename, config)) {
+        exit(EXIT_FAILURE);
+    }
+
+    // Save as JSON if needed (used to port older XML file to JSON),
+    // board Ids as found in file, i.e. before adding port offset
+    if (!mSaveConfigurationJSON.empty()) {
+        std::string jsonFilename = mSaveConfigurationJSON;
+        if (portIndex != 0) {
+            // one file per port, e.g. config-port1.json
+            std::stringstream suffix;
+            suffix << "-port" << portIndex;
+            const std::string jsonExtension = ".json";
+            if ((jsonFilename.size() > jsonExtension.size())
+                && (jsonFilename.compare(jsonFilename.size() - jsonExtension.size(),
+                                         jsonExtension.size(), jsonExtension) == 0)) {
+                jsonFilename.insert(jsonFilename.size() - jsonExtension.size(), suffix.str());
+            } else {
+                jsonFilename.append(suffix.str());
+            }
+        }
+        std::ofstream jsonFile;
+        jsonFile.open(jsonFilename);
+        Json::Value jsonConfig;
+        osaJSON1394SerializePort(config, jsonConfig);
+        Json::StyledWriter writer;
+        jsonFile << writer.write(jsonConfig) << std::endl;
+        jsonFile.close();
+    }
+
+    if (!SetBoardKeys(config, portIndex)) {
+        exit(EXIT_FAILURE);
+    }
 
     // Add all the robots
     for (const auto & configRobot : config.Robots) {
@@ -308,140 +692,694 @@ void mtsRobotIO1394::Configure(const std::string & filename)
         }
     }
 
-    // Save as JSON if needed (used to port older XML file to JSON)
-    if (!mSaveConfigurationJSON.empty()) {
-        std::ofstream jsonFile;
-        jsonFile.open(mSaveConfigurationJSON);
-        Json::Value jsonConfig;
-        config.SerializeTextJSON(jsonConfig);
-        Json::StyledWriter writer;
-        jsonFile << writer.write(jsonConfig) << std::endl;
-        jsonFile.close();
-    }
-
     // Check firmware versions used so far
     if (!CheckFirmwareVersions()) {
         exit(EXIT_FAILURE);
     }
 }
 
-bool mtsRobotIO1394::SetupRobot(mtsRobot1394 * robot)
+void mtsRobotIO1394::StageConfiguration(const std::string & filename)
 {
-    mtsStateTable * stateTableRead;
-    mtsStateTable * stateTableWrite;
+    StageConfiguration(filename, 0);
+}
 
-    // Configure StateTable for this Robot
-    if (!robot->SetupStateTables(2000, // hard coded number of elements in state tables
-                                 stateTableRead, stateTableWrite)) {
-        CMN_LOG_CLASS_INIT_ERROR << "SetupRobot: unable to setup state tables" << std::endl;
-        return false;
+void mtsRobotIO1394::StagePortConfiguration(const std::vector<std::string> & filenameAndPort)
+{
+    size_t portIndex = 0;
+    if ((filenameAndPort.size() != 2)
+        || !(std::stringstream(filenameAndPort[1]) >> portIndex)) {
+        std::lock_guard<std::mutex> lock(mStagingMutex);
+        RejectStagedChanges("StagePortConfiguration: expects a file name and a port index");
+        return;
     }
+    StageConfiguration(filenameAndPort[0], portIndex);
+}
 
-    this->AddStateTable(stateTableRead);
-    this->AddStateTable(stateTableWrite);
+void mtsRobotIO1394::StageConfiguration(const std::string & filename, const size_t portIndex)
+{
+    CMN_LOG_CLASS_RUN_VERBOSE << "StageConfiguration: staging " << filename
+                              << " for port " << portIndex << std::endl;
 
-    // Add new InterfaceProvided for this Robot with Name.
-    // Ensure all names from XML Config file are UNIQUE!
-    mtsInterfaceProvided * robotInterface = this->AddInterfaceProvided(robot->Name());
-    if (!robotInterface) {
-        CMN_LOG_CLASS_INIT_ERROR << "SetupRobot: failed to create robot interface \""
-                                 << robot->Name() << "\", do we have multiple robots with the same name?" << std::endl;
-        return false;
+    osaPort1394Configuration config;
+    if (!LoadConfiguration(filename, config)
+        || !SetBoardKeys(config, portIndex)) {
+        std::lock_guard<std::mutex> lock(mStagingMutex);
+        RejectStagedChanges("StageConfiguration: failed to load \"" + filename + "\"");
+        return;
     }
-    // we show statistics for the whole component using the main state table
-    robotInterface->AddCommandReadState(StateTable, StateTable.PeriodStats,
-                                        "period_statistics");
 
-    // Create actuator interface
-    std::string actuatorInterfaceName = robot->Name();
-    actuatorInterfaceName.append("Actuators");
-    mtsInterfaceProvided * actuatorInterface = this->AddInterfaceProvided(actuatorInterfaceName);
-    if (!actuatorInterface) {
-        CMN_LOG_CLASS_INIT_ERROR << "SetupRobot: failed to create robot actuator interface \""
-                                 << actuatorInterfaceName << "\", do we have multiple robots with the same name?" << std::endl;
-        return false;
+    std::unique_lock<std::mutex> lock(mStagingMutex);
+    if (!WaitForStagedChanges(lock)) {
+        RejectStagedChanges("StageConfiguration: \"" + filename + "\" ignored, previous change not applied yet");
+        return;
     }
+    StagedChanges & changes = mStagedChanges;
+    CopyDeviceLists(changes.Lists);
 
-    // Setup the MTS interfaces
-    robot->SetupInterfaces(robotInterface, actuatorInterface);
-
-    return true;
-}
+    // Create all devices in caller's thread, owned by changes until applied
+    std::string error;
+    for (const auto & configRobot : config.Robots) {
+        mtsRobot1394 * robot = new mtsRobot1394(*this, configRobot);
+        changes.AddedRobots.push_back(robot);
+        if (!mSkipConfigurationCheck && !robot->CheckConfiguration()) {
+            error = "error in configuration for robot \"" + robot->Name() + "\"";
+            break;
+        }
+    }
+    for (const auto & configInput : config.DigitalInputs) {
+        changes.AddedDigitalInputs.push_back(new mtsDigitalInput1394(*this, configInput));
+    }
+    for (const auto & configOutput : config.DigitalOutputs) {
+        changes.AddedDigitalOutputs.push_back(new mtsDigitalOutput1394(*this, configOutput));
+    }
+    for (const auto & configDallas : config.DallasChips) {
+        changes.AddedDallasChips.push_back(new mtsDallasChip1394(*this, configDallas));
+    }
 
-bool mtsRobotIO1394::SetupDigitalInput(mtsDigitalInput1394 * digitalInput)
-{
-    // Configure pressed active direction and edge detection
-    digitalInput->SetupStateTable(this->StateTable);
+    // Interfaces of removed devices are kept so names can't be reused
+    std::vector<std::string> names;
+    for (const auto & robot : changes.AddedRobots) {
+        names.push_back(robot->Name());
+        names.push_back(robot->Name() + "Actuators");
+    }
+    for (const auto & input : changes.AddedDigitalInputs) {
+        names.push_back(input->Name());
+    }
+    for (const auto & output : changes.AddedDigitalOutputs) {
+        names.push_back(output->Name());
+    }
+    for (const auto & dallas : changes.AddedDallasChips) {
+        names.push_back(dallas->Name());
+    }
+    for (const auto & name : names) {
+        if (error.empty() && this->GetInterfaceProvided(name)) {
+            error = "name \"" + name + "\" already used";
+        }
+    }
 
-    mtsInterfaceProvided * digitalInInterface = this->AddInterfaceProvided(digitalInput->Name());
+    // Boards and lists used by the IO thread, new boards are added to
+    // their port by the IO thread
+    if (error.empty()) {
+        try {
+            for (auto & robot : changes.AddedRobots) {
+                AddRobot(robot, changes);
+            }
+            for (auto & input : changes.AddedDigitalInputs) {
+                AddDigitalInput(input, changes);
+            }
+            for (auto & output : changes.AddedDigitalOutputs) {
+                AddDigitalOutput(output, changes);
+            }
+            for (auto & dallas : changes.AddedDallasChips) {
+                AddDallasChip(dallas, changes);
+            }
+        } catch (std::exception & stdException) {
+            error = stdException.what();
+        }
+    }
 
-    digitalInput->SetupProvidedInterface(digitalInInterface, this->StateTable);
-    return true;
-}
+    // Firmware versions found by the port's bus scan, a board not
+    // found can't be queried without a bus transaction
+    for (auto & board : changes.AddedBoards) {
+        if (!error.empty()) {
+            break;
+        }
+        board.second->Inventory.FirmwareVersion =
+            mPorts[board.first / MAX_BOARDS]->GetFirmwareVersion(board.first % MAX_BOARDS);
+        board.second->Inventory.FPGASerialNumber = "unknown";
+        board.second->Inventory.QLASerialNumber = "unknown";
+        if (board.second->Inventory.FirmwareVersion == 0) {
+            std::stringstream message;
+            message << "unable to get firmware version for port: " << board.first / MAX_BOARDS
+                    << ", board Id: " << board.first % MAX_BOARDS
+                    << ", board must be connected when the port is created";
+            error = message.str();
+        }
+    }
+    if (error.empty()) {
+        std::map<int, unsigned int> firmwareVersions;
+        for (const auto & board : changes.Lists.Boards) {
+            firmwareVersions[board.first] = board.second->Inventory.FirmwareVersion;
+        }
+        for (auto & robot : changes.AddedRobots) {
+            robot->SetFirmwareVersions(firmwareVersions);
+        }
+    }
 
-bool mtsRobotIO1394::SetupDigitalOutput(mtsDigitalOutput1394 * digitalOutput)
-{
-    // Configure pressed active direction and edge detection
-    digitalOutput->SetupStateTable(this->StateTable);
+    // State tables and interfaces.  Staged state tables are advanced
+    // by Run and not added to the component since the task uses its
+    // list of state tables outside Run
+    if (error.empty()) {
+        for (auto & robot : changes.AddedRobots) {
+            mtsStateTable * stateTableRead;
+            mtsStateTable * stateTableWrite;
+            if (!robot->SetupStateTables(2000, // hard coded number of elements in state tables
+                                         stateTableRead, stateTableWrite)) {
+                error = "unable to setup state tables for robot \"" + robot->Name() + "\"";
+                break;
+            }
+            changes.InterfaceNames.push_back(robot->Name());
+            changes.InterfaceNames.push_back(robot->Name() + "Actuators");
+            if (!SetupRobotInterfaces(robot)) {
+                error = "unable to setup interfaces for robot \"" + robot->Name() + "\"";
+                break;
+            }
+        }
+        // Digital IOs and Dallas chips can't be added to the main
+        // state table while running, they share a new state table
+        if (error.empty()
+            && (!changes.AddedDigitalInputs.empty()
+                || !changes.AddedDigitalOutputs.empty()
+                || !changes.AddedDallasChips.empty())) {
+            std::stringstream stateTableName;
+            stateTableName << this->GetName() << "Staged" << mNumberOfStagedStateTables;
+            mNumberOfStagedStateTables++;
+            changes.StateTable = new mtsStateTable(StateTable.GetHistoryLength(), stateTableName.str());
+            changes.StateTable->SetAutomaticAdvance(false);
+            changes.Lists.StateTables.push_back(changes.StateTable);
+            for (auto & input : changes.AddedDigitalInputs) {
+                input->SetupStateTable(*(changes.StateTable));
+            }
+            for (auto & output : changes.AddedDigitalOutputs) {
+                output->SetupStateTable(*(changes.StateTable));
+            }
+            for (auto & dallas : changes.AddedDallasChips) {
+                dallas->SetupStateTable(*(changes.StateTable));
+            }
+            for (auto & input : changes.AddedDigitalInputs) {
+                mtsInterfaceProvided * interfaceProvided = this->AddInterfaceProvided(input->Name());
+                if (!interfaceProvided) {
+                    error = "unable to create interface for digital input \"" + input->Name() + "\"";
+                    break;
+                }
+                changes.InterfaceNames.push_back(input->Name());
+                input->SetupProvidedInterface(interfaceProvided, *(changes.StateTable));
+            }
+            for (auto & output : changes.AddedDigitalOutputs) {
+                mtsInterfaceProvided * interfaceProvided = error.empty() ? this->AddInterfaceProvided(output->Name()) : 0;
+                if (!interfaceProvided) {
+                    error = "unable to create interface for digital output \"" + output->Name() + "\"";
+                    break;
+                }
+                changes.InterfaceNames.push_back(output->Name());
+                output->SetupProvidedInterface(interfaceProvided, *(changes.StateTable));
+            }
+            for (auto & dallas : changes.AddedDallasChips) {
+                mtsInterfaceProvided * interfaceProvided = error.empty() ? this->AddInterfaceProvided(dallas->Name()) : 0;
+                if (!interfaceProvided) {
+                    error = "unable to create interface for Dallas chip \"" + dallas->Name() + "\"";
+                    break;
+                }
+                changes.InterfaceNames.push_back(dallas->Name());
+                dallas->SetupProvidedInterface(interfaceProvided, *(changes.StateTable));
+            }
+        }
+        // No component could connect to these interfaces yet
+        if (!error.empty()) {
+            for (const auto & name : changes.InterfaceNames) {
+                this->RemoveInterfaceProvided(name);
+            }
+        } else {
+            CollectInterfaces(changes.Lists.Interfaces);
+        }
+    }
 
-    mtsInterfaceProvided * digitalOutInterface = this->AddInterfaceProvided(digitalOutput->Name());
+    if (!error.empty()) {
+        DiscardStagedChanges(changes);
+        RejectStagedChanges("StageConfiguration: \"" + filename + "\" rejected, " + error);
+        return;
+    }
 
-    digitalOutput->SetupProvidedInterface(digitalOutInterface, this->StateTable);
-    return true;
+    // Hand over to Run
+    mStagedChangesPending = true;
 }
 
-bool mtsRobotIO1394::SetupDallasChip(mtsDallasChip1394 * dallasChip)
+void mtsRobotIO1394::StageRemoval(const std::string & name)
 {
-    // Configure pressed active direction and edge detection
-    dallasChip->SetupStateTable(this->StateTable);
+    std::unique_lock<std::mutex> lock(mStagingMutex);
+    if (!WaitForStagedChanges(lock)) {
+        RejectStagedChanges("StageRemoval: \"" + name + "\" not removed, previous change not applied yet");
+        return;
+    }
+    StagedChanges & changes = mStagedChanges;
+    CopyDeviceLists(changes.Lists);
+    if (!RemoveDevice(name, changes)) {
+        DiscardStagedChanges(changes);
+        RejectStagedChanges("StageRemoval: can't remove \"" + name
+                            + "\", no robot, digital input/output or Dallas chip with this name");
+        return;
+    }
 
-    mtsInterfaceProvided * dallasChipInterface = this->AddInterfaceProvided(dallasChip->Name());
+    // Clients might still be connected, interfaces are kept but all
+    // commands are disabled
+    DisableInterface(name);
+    DisableInterface(name + "Actuators");
 
-    dallasChip->SetupProvidedInterface(dallasChipInterface, this->StateTable);
-    return true;
+    // Hand over to Run
+    mStagedChangesPending = true;
 }
 
-void mtsRobotIO1394::Startup(void)
+bool mtsRobotIO1394::RemoveDevice(const std::string & name, StagedChanges & changes)
 {
-    // Use preferred watchdog timeout
-    SetWatchdogPeriod(mWatchdogPeriod);
+    DeviceLists & lists = changes.Lists;
+    auto robot = lists.RobotsByName.find(name);
+    auto input = lists.DigitalInputsByName.find(name);
+    auto output = lists.DigitalOutputsByName.find(name);
+    auto dallas = lists.DallasChipsByName.find(name);
+    if (robot != lists.RobotsByName.end()) {
+        changes.RemovedRobots.push_back(robot->second);
+        lists.Robots.erase(std::find(lists.Robots.begin(), lists.Robots.end(), robot->second));
+        lists.RobotsByName.erase(robot);
+    } else if (input != lists.DigitalInputsByName.end()) {
+        const int boardKey = input->second->Configuration().BoardID;
+        changes.RemovedDigitalInputs.push_back(input->second);
+        lists.DigitalInputs.erase(std::find(lists.DigitalInputs.begin(), lists.DigitalInputs.end(), input->second));
+        lists.DigitalInputsByName.erase(input);
+        RebuildDigitalInputBank(boardKey, changes);
+    } else if (output != lists.DigitalOutputsByName.end()) {
+        changes.RemovedDigitalOutputs.push_back(output->second);
+        lists.DigitalOutputs.erase(std::find(lists.DigitalOutputs.begin(), lists.DigitalOutputs.end(), output->second));
+        lists.DigitalOutputsByName.erase(output);
+    } else if (dallas != lists.DallasChipsByName.end()) {
+        changes.RemovedDallasChips.push_back(dallas->second);
+        lists.DallasChips.erase(std::find(lists.DallasChips.begin(), lists.DallasChips.end(), dallas->second));
+        lists.DallasChipsByName.erase(dallas);
+    } else {
+        return false;
+    }
+    RemoveUnusedBoards(changes);
+    return true;
 }
 
-void mtsRobotIO1394::PreRead(void)
+void mtsRobotIO1394::RemoveUnusedBoards(StagedChanges & changes)
 {
-    mStateTableRead->Start();
-    for (auto & robot : mRobots) {
-        robot->StartReadStateTable();
+    auto board = changes.Lists.Boards.begin();
+    while (board != changes.Lists.Boards.end()) {
+        if (BoardInUse(board->first, changes.Lists)) {
+            ++board;
+        } else {
+            changes.RemovedBoards[board->first] = board->second;
+            board = changes.Lists.Boards.erase(board);
+        }
     }
 }
 
-void mtsRobotIO1394::Read(void)
+bool mtsRobotIO1394::BoardInUse(const int boardKey, const DeviceLists & lists) const
 {
-    // Read from all boards on the port
-    mPort->ReadAllBoards();
-
-    // Poll the state for each robot
-    for (auto & robot : mRobots) {
-        // Poll the board validity
-        robot->PollValidity();
-
-        // Poll this robot's state
-        robot->PollState();
-
-        // Convert bits to usable numbers
-        robot->ConvertState();
+    for (const auto & robot : lists.Robots) {
+        const osaRobot1394Configuration config = robot->GetConfiguration();
+        for (const auto & actuator : config.Actuators) {
+            if ((actuator.BoardID == boardKey)
+                || (actuator.Brake && (actuator.Brake->BoardID == boardKey))) {
+                return true;
+            }
+        }
     }
-    // Poll the state for each digital input
-    for (auto & input : mDigitalInputs) {
-        input->PollState();
+    for (const auto & input : lists.DigitalInputs) {
+        if (input->Configuration().BoardID == boardKey) {
+            return true;
+        }
     }
-    // Poll the state for each digital output
-    for (auto & output : mDigitalOutputs) {
-        output->PollState();
+    for (const auto & output : lists.DigitalOutputs) {
+        if (output->Configuration().BoardID == boardKey) {
+            return true;
+        }
+    }
+    for (const auto & dallas : lists.DallasChips) {
+        if (dallas->Configuration().BoardID == boardKey) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void mtsRobotIO1394::DisableInterface(const std::string & name)
+{
+    mtsInterfaceProvided * interfaceProvided = this->GetInterfaceProvided(name);
+    if (!interfaceProvided) {
+        return;
+    }
+    // read commands still work, i.e. last state and Valid set to false
+    for (const auto & command : interfaceProvided->GetNamesOfCommandsVoid()) {
+        interfaceProvided->GetCommandVoid(command)->Disable();
+    }
+    for (const auto & command : interfaceProvided->GetNamesOfCommandsWrite()) {
+        interfaceProvided->GetCommandWrite(command)->Disable();
+    }
+}
+
+void mtsRobotIO1394::CopyDeviceLists(DeviceLists & lists) const
+{
+    lists.Boards = mBoards;
+    lists.Robots = mRobots;
+    lists.RobotsByName = mRobotsByName;
+    lists.DigitalInputs = mDigitalInputs;
+    lists.DigitalInputsByName = mDigitalInputsByName;
+    lists.DigitalInputBanks = mDigitalInputBanks;
+    lists.DigitalOutputs = mDigitalOutputs;
+    lists.DigitalOutputsByName = mDigitalOutputsByName;
+    lists.DallasChips = mDallasChips;
+    lists.DallasChipsByName = mDallasChipsByName;
+    lists.StateTables = mStagedStateTables;
+    lists.Interfaces = mInterfaces;
+}
+
+void mtsRobotIO1394::SwapDeviceLists(DeviceLists & lists)
+{
+    // swapping containers only exchanges pointers
+    std::swap(mBoards, lists.Boards);
+    std::swap(mRobots, lists.Robots);
+    std::swap(mRobotsByName, lists.RobotsByName);
+    std::swap(mDigitalInputs, lists.DigitalInputs);
+    std::swap(mDigitalInputsByName, lists.DigitalInputsByName);
+    std::swap(mDigitalInputBanks, lists.DigitalInputBanks);
+    std::swap(mDigitalOutputs, lists.DigitalOutputs);
+    std::swap(mDigitalOutputsByName, lists.DigitalOutputsByName);
+    std::swap(mDallasChips, lists.DallasChips);
+    std::swap(mDallasChipsByName, lists.DallasChipsByName);
+    std::swap(mStagedStateTables, lists.StateTables);
+    std::swap(mInterfaces, lists.Interfaces);
+}
+
+void mtsRobotIO1394::CollectInterfaces(std::vector<mtsInterfaceProvided *> & interfaces)
+{
+    interfaces.clear();
+    for (const auto & name : this->GetNamesOfInterfacesProvided()) {
+        mtsInterfaceProvided * interfaceProvided = this->GetInterfaceProvided(name);
+        if (interfaceProvided) {
+            interfaces.push_back(interfaceProvided);
+        }
+    }
+}
+
+void mtsRobotIO1394::ApplyStagedChanges(void)
+{
+    // never block the IO loop, try again next cycle if lock is taken
+    std::unique_lock<std::mutex> lock(mStagingMutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return;
+    }
+    if (mStagedChangesPending) {
+        ApplyStagedChanges(mStagedChanges);
+        mStagedChangesPending = false;
+    }
+    // rejected changes, sent by the IO thread like all robot events
+    if (mStagingErrorsPending) {
+        for (const auto & error : mStagingErrors) {
+            for (auto & robot : mRobots) {
+                robot->mInterface->SendError(error);
+            }
+        }
+        mStagingErrors.clear();
+        mStagingErrorsPending = false;
+    }
+}
+
+void mtsRobotIO1394::ApplyStagedChanges(StagedChanges & changes)
+{
+    // Ports can't be modified during a transfer
+    CompletePendingWrite();
+
+    // Power off removed robots while their boards are still on the port
+    for (auto & robot : changes.RemovedRobots) {
+        if (robot->Valid()) {
+            robot->PowerOffSequence(false /* don't open safety relays */);
+        }
+        robot->Invalidate();
+    }
+    for (auto & board : changes.RemovedBoards) {
+        mPorts[board.first / MAX_BOARDS]->RemoveBoard(board.first % MAX_BOARDS);
+    }
+    for (auto & board : changes.AddedBoards) {
+        mPorts[board.first / MAX_BOARDS]->AddBoard(board.second->Board);
+    }
+
+    // Boards of new robots use the preferred watchdog period before
+    // the robot is used
+    for (auto & robot : changes.AddedRobots) {
+        robot->SetWatchdogPeriod(mWatchdogPeriod);
+    }
+
+    // New banks keep the values and debounce state of the bank they replace
+    for (auto & bank : changes.AddedBanks) {
+        const auto previous = changes.ReplacedBanks.find(bank.first);
+        if (previous != changes.ReplacedBanks.end()) {
+            bank.second->CopyState(*(previous->second));
+        }
+    }
+
+    SwapDeviceLists(changes.Lists);
+}
+
+void mtsRobotIO1394::RetireStagedChanges(StagedChanges & changes)
+{
+    // The IO thread uses the new lists, devices and boards removed are
+    // kept until the destructor since their interfaces are kept
+    mRetiredRobots.insert(mRetiredRobots.end(),
+                          changes.RemovedRobots.begin(), changes.RemovedRobots.end());
+    mRetiredDigitalInputs.insert(mRetiredDigitalInputs.end(),
+                                 changes.RemovedDigitalInputs.begin(), changes.RemovedDigitalInputs.end());
+    mRetiredDigitalOutputs.insert(mRetiredDigitalOutputs.end(),
+                                  changes.RemovedDigitalOutputs.begin(), changes.RemovedDigitalOutputs.end());
+    mRetiredDallasChips.insert(mRetiredDallasChips.end(),
+                               changes.RemovedDallasChips.begin(), changes.RemovedDallasChips.end());
+    for (auto & board : changes.RemovedBoards) {
+        mRetiredBoards.push_back(board.second);
+    }
+    // Banks are only used by the IO thread
+    for (auto & bank : changes.ReplacedBanks) {
+        delete bank.second;
+    }
+    changes = StagedChanges();
+}
+
+void mtsRobotIO1394::DiscardStagedChanges(StagedChanges & changes)
+{
+    // Devices, boards and banks never used by the IO thread
+    for (auto & robot : changes.AddedRobots) {
+        delete robot;
+    }
+    for (auto & input : changes.AddedDigitalInputs) {
+        delete input;
+    }
+    for (auto & output : changes.AddedDigitalOutputs) {
+        delete output;
+    }
+    for (auto & dallas : changes.AddedDallasChips) {
+        delete dallas;
+    }
+    for (auto & bank : changes.AddedBanks) {
+        delete bank.second;
+    }
+    for (auto & board : changes.AddedBoards) {
+        delete board.second->Board;
+        delete board.second;
+    }
+    delete changes.StateTable;
+    changes = StagedChanges();
+}
+
+bool mtsRobotIO1394::WaitForStagedChanges(std::unique_lock<std::mutex> & lock)
+{
+    // One change at a time, the IO thread needs the lock to apply
+    // the previous one
+    const double timeout = osaGetTime() + 1.0 * cmn_s;
+    while (mStagedChangesPending) {
+        if (osaGetTime() > timeout) {
+            return false;
+        }
+        lock.unlock();
+        osaSleep(GetPeriodicity());
+        lock.lock();
+    }
+    // The IO thread no longer uses the previous lists
+    RetireStagedChanges(mStagedChanges);
+    return true;
+}
+
+void mtsRobotIO1394::RejectStagedChanges(const std::string & message)
+{
+    // Caller holds mStagingMutex
+    CMN_LOG_CLASS_RUN_ERROR << message << std::endl;
+    mStagingErrors.push_back(message);
+    mStagingErrorsPending = true;
+}
+
+bool mtsRobotIO1394::SetupRobot(mtsRobot1394 * robot)
+{
+    mtsStateTable * stateTableRead;
+    mtsStateTable * stateTableWrite;
+
+    // Configure StateTable for this Robot
+    if (!robot->SetupStateTables(2000, // hard coded number of elements in state tables
+                                 stateTableRead, stateTableWrite)) {
+        CMN_LOG_CLASS_INIT_ERROR << "SetupRobot: unable to setup state tables" << std::endl;
+        return false;
+    }
+
+    this->AddStateTable(stateTableRead);
+    this->AddStateTable(stateTableWrite);
+
+    return SetupRobotInterfaces(robot);
+}
+
+bool mtsRobotIO1394::SetupRobotInterfaces(mtsRobot1394 * robot)
+{
+    // Add new InterfaceProvided for this Robot with Name.
+    // Ensure all names from XML Config file are UNIQUE!
+    mtsInterfaceProvided * robotInterface = this->AddInterfaceProvided(robot->Name());
+    if (!robotInterface) {
+        CMN_LOG_CLASS_INIT_ERROR << "SetupRobotInterfaces: failed to create robot interface \""
+                                 << robot->Name() << "\", do we have multiple robots with the same name?" << std::endl;
+        return false;
+    }
+    // we show statistics for the whole component using the main state table
+    robotInterface->AddCommandReadState(StateTable, StateTable.PeriodStats,
+                                        "period_statistics");
+
+    // Create actuator interface
+    std::string actuatorInterfaceName = robot->Name();
+    actuatorInterfaceName.append("Actuators");
+    mtsInterfaceProvided * actuatorInterface = this->AddInterfaceProvided(actuatorInterfaceName);
+    if (!actuatorInterface) {
+        CMN_LOG_CLASS_INIT_ERROR << "SetupRobotInterfaces: failed to create robot actuator interface \""
+                                 << actuatorInterfaceName << "\", do we have multiple robots with the same name?" << std::endl;
+        return false;
+    }
+
+    // Setup the MTS interfaces
+    robot->SetupInterfaces(robotInterface, actuatorInterface);
+
+    return true;
+}
+
+bool mtsRobotIO1394::SetupDigitalInput(mtsDigitalInput1394 * digitalInput)
+{
+    // Configure pressed active direction and edge detection
+    digitalInput->SetupStateTable(this->StateTable);
+
+    mtsInterfaceProvided * digitalInInterface = this->AddInterfaceProvided(digitalInput->Name());
+
+    digitalInput->SetupProvidedInterface(digitalInInterface, this->StateTable);
+    return true;
+}
+
+bool mtsRobotIO1394::SetupDigitalOutput(mtsDigitalOutput1394 * digitalOutput)
+{
+    // Configure pressed active direction and edge detection
+    digitalOutput->SetupStateTable(this->StateTable);
+
+    mtsInterfaceProvided * digitalOutInterface = this->AddInterfaceProvided(digitalOutput->Name());
+
+    digitalOutput->SetupProvidedInterface(digitalOutInterface, this->StateTable);
+    return true;
+}
+
+bool mtsRobotIO1394::SetupDallasChip(mtsDallasChip1394 * dallasChip)
+{
+    // Configure pressed active direction and edge detection
+    dallasChip->SetupStateTable(this->StateTable);
+
+    mtsInterfaceProvided * dallasChipInterface = this->AddInterfaceProvided(dallasChip->Name());
+
+    dallasChip->SetupProvidedInterface(dallasChipInterface, this->StateTable);
+    return true;
+}
+
+void mtsRobotIO1394::Startup(void)
+{
+    // Startup runs in the IO thread
+    SetupRealTime();
+    {
+        std::lock_guard<std::mutex> lock(mStagingMutex);
+        CollectInterfaces(mInterfaces);
+    }
+    osaTrace1394::SetThreadName(this->GetName());
+
+    // Make sure all boards have been queried, no-op if already done in Configure
+    DiscoverBoards();
+
+    // One thread per port if we have more than one port
+    StartPortWorkers();
+
+    // Find best protocol with actual boards
+    if (mAutoProtocol) {
+        BenchmarkProtocols();
+    }
+
+    // Use preferred watchdog timeout
+    SetWatchdogPeriod(mWatchdogPeriod);
+}
+
+void mtsRobotIO1394::PreRead(void)
+{
+    mCycle++;
+    mCycleStarted = true;
+    mStateTableRead->Start();
+    for (auto & robot : mRobots) {
+        if (robot->IsScheduled(mCycle)) {
+            robot->StartReadStateTable();
+        }
+    }
+    for (auto & stateTable : mStagedStateTables) {
+        stateTable->Start();
+    }
+}
+
+void mtsRobotIO1394::Read(void)
+{
+    // Read used directly, outside Run
+    if (!mCycleStarted) {
+        mCycle++;
+    }
+    mCycleStarted = false;
+
+    // Make sure the write from previous cycle is done
+    CompletePendingWrite();
+
+    // Read from all boards on all ports
+    TransferAllPorts(PORT_READ);
+    RetryInvalidReads();
+    UpdateBoardClocks();
+    UpdateBoardStatistics();
+
+    // Poll the state for each robot scheduled this cycle
+    for (auto & robot : mRobots) {
+        if (!robot->IsScheduled(mCycle)) {
+            continue;
+        }
+        // Errors for one robot don't affect other robots
+        try {
+            // Poll the board validity
+            robot->PollValidity();
+
+            // Poll this robot's state
+            robot->PollState();
+
+            // Convert bits to usable numbers
+            robot->ConvertState();
+        } catch (std::exception & stdException) {
+            CMN_LOG_CLASS_RUN_ERROR << "Read: " << robot->Name() << ": standard exception \"" << stdException.what() << "\"" << std::endl;
+            robot->mInterface->SendError("IO exception: " + robot->Name() + ", " + stdException.what());
+        }
+    }
+    // Poll the state for all digital inputs, one bank per board
+    for (auto & bank : mDigitalInputBanks) {
+        if (bank.second->IsScheduled(mCycle)) {
+            bank.second->PollState();
+        }
+    }
+    // Poll the state for each digital output
+    for (auto & output : mDigitalOutputs) {
+        if (output->IsScheduled(mCycle)) {
+            output->PollState();
+        }
     }
     // Poll the state for each Dallas chip
     for (auto & dallas: mDallasChips) {
-        dallas->PollState();
+        if (dallas->IsScheduled(mCycle)) {
+            dallas->PollState();
+        }
     }
 }
 
@@ -450,6 +1388,9 @@ void mtsRobotIO1394::PostRead(void)
     mStateTableRead->Advance();
     // Trigger robot events
     for (auto & robot : mRobots) {
+        if (!robot->IsScheduled(mCycle)) {
+            continue;
+        }
         try {
             robot->CheckState();
         } catch (std::exception & stdException) {
@@ -461,15 +1402,25 @@ void mtsRobotIO1394::PostRead(void)
         }
         robot->AdvanceReadStateTable();
     }
-    // Trigger digital input events
-    for (auto & input : mDigitalInputs) {
-        input->CheckState();
+    // Trigger digital input events, only for inputs that changed
+    for (auto & bank : mDigitalInputBanks) {
+        if (bank.second->IsScheduled(mCycle)) {
+            bank.second->CheckState();
+        }
+    }
+    for (auto & stateTable : mStagedStateTables) {
+        stateTable->Advance();
     }
 }
 
 bool mtsRobotIO1394::IsOK(void) const
 {
-    return mPort->IsOK();
+    for (const auto & port : mPorts) {
+        if (!port->IsOK()) {
+            return false;
+        }
+    }
+    return true;
 }
 
 void mtsRobotIO1394::PreWrite(void)
@@ -480,10 +1431,45 @@ void mtsRobotIO1394::PreWrite(void)
     }
 }
 
+void mtsRobotIO1394::WriteDigitalOutputs(void)
+{
+    // Merge changes for all outputs on the same board
+    for (auto & output : mDigitalOutputs) {
+        unsigned int mask, bits;
+        if (output->GetPendingWrite(mask, bits)) {
+            const auto board = mBoards.find(output->Configuration().BoardID);
+            if (board != mBoards.end()) {
+                DigitalOutputBuffer & buffer = board->second->DigitalOutputs;
+                buffer.Mask |= mask;
+                buffer.Bits = (buffer.Bits & ~mask) | (bits & mask);
+            }
+        }
+        output->WritePendingPWM();
+    }
+    // Single masked update per board, sent with WriteAllBoards
+    for (auto & board : mBoards) {
+        DigitalOutputBuffer & buffer = board.second->DigitalOutputs;
+        if (buffer.Mask == 0x0) {
+            continue;
+        }
+        board.second->Board->SetDigitalOutput(static_cast<AmpIO_UInt8>(buffer.Mask),
+                                              static_cast<AmpIO_UInt8>(buffer.Bits));
+        buffer.Mask = 0x0;
+        buffer.Bits = 0x0;
+    }
+}
+
 void mtsRobotIO1394::Write(void)
 {
-    // Write to all boards
-    mPort->WriteAllBoards();
+    // Digital outputs are added to the write buffers
+    WriteDigitalOutputs();
+
+    // Write to all boards on all ports.  In split-phase mode, the
+    // write is completed in the next call to Read
+    StartTransfer(PORT_WRITE);
+    if (!mSplitPhaseWrite) {
+        WaitTransfer();
+    }
 }
 
 void mtsRobotIO1394::PostWrite(void)
@@ -497,11 +1483,24 @@ void mtsRobotIO1394::PostWrite(void)
 
 void mtsRobotIO1394::Run(void)
 {
+    osaTrace1394::Scope trace("Run");
+    mCycleStartTime = osaGetTime();
+
+    // Add or remove devices at cycle boundary
+    if (mStagedChangesPending || mStagingErrorsPending) {
+        ApplyStagedChanges();
+    }
+
     // Read from all boards
     bool gotException = false;
     std::string message;
 
-    PreRead();
+    osaFlightRecorder1394::Cycle cycle;
+    // count heap allocations from here to PostWrite, if compiled in
+    osaAllocationGuard1394::Begin();
+    osaTrace1394::Begin("Read");
+    PreRead(); // increments mCycle
+    SAW_ROBOTIO1394_PROBE1(read_start, mCycle);
     try {
         Read();
     } catch (std::exception & stdException) {
@@ -518,22 +1517,102 @@ void mtsRobotIO1394::Run(void)
             robot->mInterface->SendError(message);
         }
     }
+    SAW_ROBOTIO1394_PROBE1(read_end, mCycle);
+    osaTrace1394::End("Read");
+    const double readEnd = osaGetTime();
+    osaTrace1394::Begin("PostRead");
+    SAW_ROBOTIO1394_PROBE1(post_read_start, mCycle);
     PostRead(); // this performs all state conversions and checks
+    SAW_ROBOTIO1394_PROBE1(post_read_end, mCycle);
+    osaTrace1394::End("PostRead");
+    const double postReadEnd = osaGetTime();
 
     // Invoke connected components (if any)
+    osaTrace1394::Begin("RunEvent");
+    SAW_ROBOTIO1394_PROBE1(run_event_start, mCycle);
     this->RunEvent();
+    SAW_ROBOTIO1394_PROBE1(run_event_end, mCycle);
+    osaTrace1394::End("RunEvent");
 
     // Process queued commands (e.g., to set motor current)
-    this->ProcessQueuedCommands();
+    osaTrace1394::Begin("ProcessQueuedCommands");
+    SAW_ROBOTIO1394_PROBE1(commands_start, mCycle);
+    // Only interfaces from the swapped lists, StageConfiguration
+    // might be adding interfaces to the component in another thread
+    cycle.NumberOfCommands = 0;
+    for (auto & interfaceProvided : mInterfaces) {
+        cycle.NumberOfCommands += interfaceProvided->ProcessMailBoxes();
+    }
+    SAW_ROBOTIO1394_PROBE2(commands_end, mCycle, cycle.NumberOfCommands);
+    osaTrace1394::End("ProcessQueuedCommands");
+    const double commandsEnd = osaGetTime();
 
     // Write to all boards
+    osaTrace1394::Begin("Write");
+    SAW_ROBOTIO1394_PROBE1(write_start, mCycle);
     PreWrite();
     Write();
     PostWrite();
+    osaAllocationGuard1394::End();
+    SAW_ROBOTIO1394_PROBE1(write_end, mCycle);
+    osaTrace1394::End("Write");
+
+    if (mAutoProtocol) {
+        CheckProtocolErrors();
+    }
+
+    if (mFlightRecorder) {
+        const double end = osaGetTime();
+        cycle.StartTime = mCycleStartTime;
+        cycle.ReadTime = readEnd - mCycleStartTime;
+        cycle.PostReadTime = postReadEnd - readEnd;
+        cycle.CommandsTime = commandsEnd - postReadEnd;
+        cycle.WriteTime = end - commandsEnd;
+        cycle.CycleTime = end - mCycleStartTime;
+        cycle.InvalidBoards = 0;
+        for (const auto & board : mBoards) {
+            if (!board.second->Board->ValidRead() && (board.first < 64)) {
+                cycle.InvalidBoards |= 1ULL << board.first;
+            }
+        }
+        mFlightRecorder->Record(cycle);
+        if (cycle.CycleTime > mFlightRecorderThreshold) {
+            DumpFlightRecorder("cycle overrun");
+        }
+    }
+}
+
+void mtsRobotIO1394::UseFlightRecorder(const std::string & filePrefix,
+                                       const size_t numberOfCycles,
+                                       const double threshold)
+{
+    delete mFlightRecorder;
+    mFlightRecorder = new osaFlightRecorder1394(filePrefix, numberOfCycles);
+    mFlightRecorderThreshold = (threshold > 0.0) ? threshold : 2.0 * GetPeriodicity();
+}
+
+void mtsRobotIO1394::DumpFlightRecorder(const char * reason)
+{
+    const double now = osaGetTime();
+    if (!mFlightRecorder
+        || (now < (mFlightRecorderLastDump + 10.0 * cmn_s))) {
+        return;
+    }
+    if (mFlightRecorder->Dump(reason)) {
+        mFlightRecorderLastDump = now;
+    }
 }
 
 void mtsRobotIO1394::Cleanup(void)
 {
+    LogBoardStatistics();
+    if (osaAllocationGuard1394::Count() > 0) {
+        std::stringstream stackTraces;
+        osaAllocationGuard1394::LogStackTraces(stackTraces);
+        CMN_LOG_CLASS_INIT_WARNING << "Cleanup: " << osaAllocationGuard1394::Count()
+                                   << " heap allocation(s) during IO cycles" << std::endl
+                                   << stackTraces.str();
+    }
     for (size_t i = 0; i < mRobots.size(); i++) {
         if (mRobots[i]->Valid()) {
             mRobots[i]->PowerOffSequence(true /* open safety relays */);
@@ -541,25 +1620,562 @@ void mtsRobotIO1394::Cleanup(void)
     }
     // Write to all boards
     Write();
+    CompletePendingWrite();
+    StopPortWorkers();
+}
+
+void mtsRobotIO1394::SetPortCPUAffinity(const size_t portIndex, const int cpu)
+{
+    mPortCPUs.at(portIndex) = cpu;
+}
+
+void mtsRobotIO1394::StartPortWorkers(void)
+{
+    // threads are needed for multiple ports or split-phase write
+    if (((mPorts.size() < 2) && !mSplitPhaseWrite) || !mPortWorkers.empty()) {
+        return;
+    }
+    for (size_t index = 0; index < mPorts.size(); ++index) {
+        PortWorker * worker = new PortWorker;
+        worker->Index = index;
+        worker->Port = mPorts.at(index);
+        worker->Operation = PORT_IDLE;
+        worker->CPU = mPortCPUs.at(index);
+        std::stringstream name;
+        name << "IO1394Port" << index;
+        mPortWorkers.push_back(worker);
+        worker->Thread.Create<mtsRobotIO1394, PortWorker *>(this, &mtsRobotIO1394::PortWorkerLoop,
+                                                            worker, name.str().c_str());
+    }
+}
+
+void mtsRobotIO1394::StopPortWorkers(void)
+{
+    for (auto & worker : mPortWorkers) {
+        worker->Operation = PORT_STOP;
+        worker->Start.Raise();
+        worker->Thread.Wait();
+        delete worker;
+    }
+    mPortWorkers.clear();
+}
+
+void * mtsRobotIO1394::PortWorkerLoop(PortWorker * worker)
+{
+    if (worker->CPU >= NumberOfAffinityCPUs()) {
+        CMN_LOG_CLASS_INIT_ERROR << "PortWorkerLoop: invalid cpu " << worker->CPU
+                                 << " for port " << worker->Index << ", only "
+                                 << NumberOfAffinityCPUs() << " available, affinity not set" << std::endl;
+    } else if (worker->CPU >= 0) {
+        osaCPUSetAffinity(static_cast<osaCPUMask>(1) << worker->CPU);
+    }
+    osaTrace1394::SetThreadName("IO1394Port" + std::to_string(worker->Index));
+    while (true) {
+        worker->Start.Wait();
+        if (worker->Operation == PORT_STOP) {
+            break;
+        }
+        worker->Error.clear();
+        worker->Ok = true;
+        const double start = osaGetTime();
+        worker->StartTime = start;
+        try {
+            if (worker->Operation == PORT_READ) {
+                osaTrace1394::Scope trace("ReadAllBoards");
+                worker->Ok = worker->Port->ReadAllBoards();
+            } else if (worker->Operation == PORT_WRITE) {
+                osaTrace1394::Scope trace("WriteAllBoards");
+                worker->Ok = worker->Port->WriteAllBoards();
+            }
+        } catch (std::exception & stdException) {
+            worker->Error = stdException.what();
+        } catch (...) {
+            worker->Error = "unknown exception";
+        }
+        worker->Duration = osaGetTime() - start;
+        worker->Done.Raise();
+    }
+    return 0;
+}
+
+void mtsRobotIO1394::StartTransfer(const PortOperation operation)
+{
+    // one transfer at a time
+    WaitTransfer();
+    mPendingOperation = operation;
+
+    // no thread, do it in this thread
+    if (mPortWorkers.empty()) {
+        vctDoubleVec & portTime = (operation == PORT_READ) ? mPortReadTime : mPortWriteTime;
+        for (size_t index = 0; index < mPorts.size(); ++index) {
+            const double start = osaGetTime();
+            bool ok;
+            if (operation == PORT_READ) {
+                mPortReadStart[index] = start;
+                ok = mPorts[index]->ReadAllBoards();
+            } else {
+                ok = mPorts[index]->WriteAllBoards();
+            }
+            portTime[index] = osaGetTime() - start;
+            if (!ok) {
+                mTransferErrors++;
+            }
+        }
+        return;
+    }
+
+    // start all ports, use WaitTransfer to wait for all
+    for (auto & worker : mPortWorkers) {
+        worker->Operation = operation;
+        worker->Start.Raise();
+    }
+}
+
+void mtsRobotIO1394::WaitTransfer(void)
+{
+    if (mPendingOperation == PORT_IDLE) {
+        return;
+    }
+    const PortOperation operation = mPendingOperation;
+    mPendingOperation = PORT_IDLE;
+    vctDoubleVec & portTime = (operation == PORT_READ) ? mPortReadTime : mPortWriteTime;
+
+    // wait for all ports, i.e. barrier
+    std::string errors;
+    for (auto & worker : mPortWorkers) {
+        worker->Done.Wait();
+        portTime[worker->Index] = worker->Duration;
+        if (operation == PORT_READ) {
+            mPortReadStart[worker->Index] = worker->StartTime;
+        }
+        if (!worker->Ok) {
+            mTransferErrors++;
+        }
+        if (!worker->Error.empty()) {
+            std::stringstream error;
+            error << "port " << worker->Index << ": " << worker->Error << " ";
+            errors.append(error.str());
+        }
+    }
+
+    // slowest port
+    if (operation == PORT_READ) {
+        mReadTimeHistogram.Add(portTime.MaxElement());
+    } else {
+        mWriteTimeHistogram.Add(portTime.MaxElement());
+    }
+
+    if (!errors.empty()) {
+        cmnThrow(errors);
+    }
+}
+
+void mtsRobotIO1394::TransferAllPorts(const PortOperation operation)
+{
+    StartTransfer(operation);
+    WaitTransfer();
+}
+
+void mtsRobotIO1394::CompletePendingWrite(void)
+{
+    if (mPendingOperation != PORT_WRITE) {
+        return;
+    }
+    const double start = osaGetTime();
+    try {
+        WaitTransfer();
+    } catch (std::exception & stdException) {
+        CMN_LOG_CLASS_RUN_ERROR << "CompletePendingWrite: " << stdException.what() << std::endl;
+    }
+    mWriteWaitHistogram.Add(osaGetTime() - start);
+}
+
+void mtsRobotIO1394::UseSplitPhaseWrite(const bool splitPhase)
+{
+    mSplitPhaseWrite = splitPhase;
 }
 
 void mtsRobotIO1394::GetNumberOfDigitalInputs(int & placeHolder) const
 {
+    std::lock_guard<std::mutex> lock(mStagingMutex);
     placeHolder = mDigitalInputs.size();
 }
 
 void mtsRobotIO1394::GetNumberOfDigitalOutputs(int & placeHolder) const
 {
+    std::lock_guard<std::mutex> lock(mStagingMutex);
     placeHolder = mDigitalOutputs.size();
 }
 
 void mtsRobotIO1394::GetNumberOfBoards(int & placeHolder) const
 {
+    std::lock_guard<std::mutex> lock(mStagingMutex);
     placeHolder = mBoards.size();
 }
 
+void mtsRobotIO1394::GetBoardIDs(vctIntVec & placeHolder) const
+{
+    std::lock_guard<std::mutex> lock(mStagingMutex);
+    placeHolder.SetSize(mBoards.size());
+    size_t index = 0;
+    for (const auto & board : mBoards) {
+        placeHolder[index] = board.first;
+        ++index;
+    }
+}
+
+void mtsRobotIO1394::GetBoardFirmwareVersions(vctIntVec & placeHolder) const
+{
+    std::lock_guard<std::mutex> lock(mStagingMutex);
+    placeHolder.SetSize(mBoards.size());
+    size_t index = 0;
+    for (const auto & board : mBoards) {
+        placeHolder[index] = board.second->Inventory.FirmwareVersion;
+        ++index;
+    }
+}
+
+void mtsRobotIO1394::GetBoardFPGASerialNumbers(std::vector<std::string> & placeHolder) const
+{
+    std::lock_guard<std::mutex> lock(mStagingMutex);
+    placeHolder.clear();
+    for (const auto & board : mBoards) {
+        placeHolder.push_back(board.second->Inventory.FPGASerialNumber);
+    }
+}
+
+void mtsRobotIO1394::GetBoardQLASerialNumbers(std::vector<std::string> & placeHolder) const
+{
+    std::lock_guard<std::mutex> lock(mStagingMutex);
+    placeHolder.clear();
+    for (const auto & board : mBoards) {
+        placeHolder.push_back(board.second->Inventory.QLASerialNumber);
+    }
+}
+
+void mtsRobotIO1394::UseDiagnosticsLog(const std::string & filename,
+                                       const size_t numberOfStreaks)
+{
+    mDiagnosticsLog.open(filename.c_str(), std::ios::out | std::ios::app);
+    if (!mDiagnosticsLog.is_open()) {
+        CMN_LOG_CLASS_INIT_ERROR << "UseDiagnosticsLog: can't open file \"" << filename << "\"" << std::endl;
+        return;
+    }
+    mDiagnosticsLog << "# " << this->GetName() << " started at " << osaGetTime() << std::endl;
+    mRecoveredStreaks.resize(numberOfStreaks);
+    mNumberOfRecoveredStreaks = 0;
+}
+
+void mtsRobotIO1394::UpdateBoardClocks(void)
+{
+    // decode timestamps once per board, shared by all devices on the board
+    for (auto & board : mBoards) {
+        if (board.second->Board->ValidRead()) {
+            board.second->Clock.Update(board.second->Board->GetTimestamp(),
+                                       mPortReadStart[board.first / MAX_BOARDS]);
+        } else {
+            board.second->Clock.Invalidate();
+        }
+    }
+}
+
+void mtsRobotIO1394::UpdateBoardStatistics(void)
+{
+    for (auto & board : mBoards) {
+        BoardStatistics & statistics = board.second->Statistics;
+        statistics.Reads++;
+        if (board.second->Board->ValidRead()) {
+            if (statistics.InvalidStreak > 0) {
+                // no file IO in the IO thread, see LogBoardStatistics
+                if (!mRecoveredStreaks.empty()) {
+                    RecoveredStreak & streak =
+                        mRecoveredStreaks[mNumberOfRecoveredStreaks % mRecoveredStreaks.size()];
+                    streak.Time = mCycleStartTime;
+                    streak.Board = board.first;
+                    streak.InvalidStreak = statistics.InvalidStreak;
+                    mNumberOfRecoveredStreaks++;
+                }
+                statistics.InvalidStreak = 0;
+            }
+            statistics.ReadInterval.Add(board.second->Clock.Elapsed());
+        } else {
+            statistics.InvalidReads++;
+            statistics.InvalidStreak++;
+            if (statistics.InvalidStreak > statistics.LongestInvalidStreak) {
+                statistics.LongestInvalidStreak = statistics.InvalidStreak;
+            }
+        }
+    }
+    // copy for diagnostics interface about once per second based on
+    // the task period, skip if a reader holds the lock
+    mBoardStatisticsUpdates++;
+    const double period = GetPeriodicity();
+    const size_t updatesPerSecond = (period > 0.0) ? static_cast<size_t>(1.0 * cmn_s / period) : 1;
+    if (mBoardStatisticsUpdates >= updatesPerSecond) {
+        SnapshotBoardStatistics();
+        mBoardStatisticsUpdates = 0;
+    }
+}
+
+void mtsRobotIO1394::SetReadRetryBudget(const double share)
+{
+    mReadRetryShare = share;
+}
+
+void mtsRobotIO1394::RetryInvalidReads(void)
+{
+    if (mReadRetryShare <= 0.0) {
+        return;
+    }
+    for (size_t portIndex = 0; portIndex < mPorts.size(); ++portIndex) {
+        // boards on this port, keys are sorted by port
+        const board_iterator first = mBoards.lower_bound(portIndex * MAX_BOARDS);
+        const board_iterator last = mBoards.lower_bound((portIndex + 1) * MAX_BOARDS);
+        // ReadAllBoards can't read a single board, re-reading the
+        // port could replace valid reads by invalid ones so only retry
+        // if no board is valid.  Invalid boards next to valid ones are
+        // counted so they show in the diagnostics
+        bool anyValid = (first == last);
+        for (board_iterator board = first; board != last; ++board) {
+            if (board->second->Board->ValidRead()) {
+                anyValid = true;
+                break;
+            }
+        }
+        if (anyValid) {
+            for (board_iterator board = first; board != last; ++board) {
+                if (!board->second->Board->ValidRead()) {
+                    board->second->Statistics.UnretriedReads++;
+                }
+            }
+            continue;
+        }
+        const double now = osaGetTime();
+        const double deadline = now + mReadRetryShare * (GetPeriodicity() - (now - mCycleStartTime));
+        double readTime = mPortReadTime[portIndex];
+        size_t retries = 0;
+        while (!anyValid
+               && (retries < MaximumReadRetries)
+               && ((osaGetTime() + readTime) < deadline)) {
+            // timestamps of the next valid reads are relative to this
+            // request, used by UpdateBoardClocks
+            const double start = osaGetTime();
+            mPortReadStart[portIndex] = start;
+            mPorts[portIndex]->ReadAllBoards();
+            readTime = osaGetTime() - start;
+            retries++;
+            for (board_iterator board = first; board != last; ++board) {
+                BoardStatistics & statistics = board->second->Statistics;
+                statistics.Retries++;
+                if (board->second->Board->ValidRead()) {
+                    statistics.RecoveredReads++;
+                    anyValid = true;
+                }
+            }
+        }
+    }
+}
+
+void mtsRobotIO1394::SnapshotBoardStatistics(void)
+{
+    std::unique_lock<std::mutex> lock(mDiagnosticsMutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return;
+    }
+    const size_t numberOfBins = mBoards.empty() ? 0 : mBoards.begin()->second->Statistics.ReadInterval.Counts().size();
+    mBoardStatisticsSnapshot.SetSize(mBoards.size(), STATISTICS_NUMBER_OF_COLUMNS);
+    mBoardReadIntervalSnapshot.SetSize(mBoards.size(), numberOfBins);
+    size_t row = 0;
+    for (const auto & board : mBoards) {
+        const BoardStatistics & statistics = board.second->Statistics;
+        vctDoubleMat::RowRefType values = mBoardStatisticsSnapshot.Row(row);
+        values[STATISTICS_BOARD] = board.first;
+        values[STATISTICS_READS] = statistics.Reads;
+        values[STATISTICS_INVALID_READS] = statistics.InvalidReads;
+        values[STATISTICS_INVALID_STREAK] = statistics.InvalidStreak;
+        values[STATISTICS_LONGEST_INVALID_STREAK] = statistics.LongestInvalidStreak;
+        values[STATISTICS_RETRIES] = statistics.Retries;
+        values[STATISTICS_RECOVERED_READS] = statistics.RecoveredReads;
+        values[STATISTICS_UNRETRIED_READS] = statistics.UnretriedReads;
+        const osaBoardClock1394 & clock = board.second->Clock;
+        values[STATISTICS_CLOCK_RATE] = clock.Rate();
+        values[STATISTICS_CLOCK_RESYNCHRONIZATIONS] = clock.Resynchronizations();
+        mBoardReadIntervalSnapshot.Row(row).Assign(statistics.ReadInterval.Counts());
+        row++;
+    }
+}
+
+void mtsRobotIO1394::LogBoardStatistics(void)
+{
+    if (!mDiagnosticsLog.is_open()) {
+        return;
+    }
+    // oldest first
+    const size_t size = mRecoveredStreaks.size();
+    if (mNumberOfRecoveredStreaks > size) {
+        mDiagnosticsLog << "# " << (mNumberOfRecoveredStreaks - size)
+                        << " older end(s) of invalid read streaks not logged" << std::endl;
+    }
+    const size_t first = (mNumberOfRecoveredStreaks > size) ? (mNumberOfRecoveredStreaks - size) : 0;
+    for (size_t index = first; index < mNumberOfRecoveredStreaks; ++index) {
+        const RecoveredStreak & streak = mRecoveredStreaks[index % size];
+        mDiagnosticsLog << streak.Time << " board " << streak.Board
+                        << " recovered after " << streak.InvalidStreak
+                        << " invalid read(s)\n";
+    }
+    mDiagnosticsLog << "# board, reads, invalid reads, current invalid streak, longest invalid streak, retries, recovered reads, unretried reads, clock rate, clock resynchronizations" << std::endl;
+    for (const auto & board : mBoards) {
+        const BoardStatistics & statistics = board.second->Statistics;
+        mDiagnosticsLog << board.first << ", "
+                        << statistics.Reads << ", "
+                        << statistics.InvalidReads << ", "
+                        << statistics.InvalidStreak << ", "
+                        << statistics.LongestInvalidStreak << ", "
+                        << statistics.Retries << ", "
+                        << statistics.RecoveredReads << ", "
+                        << statistics.UnretriedReads << ", "
+                        << board.second->Clock.Rate() << ", "
+                        << board.second->Clock.Resynchronizations() << std::endl;
+        mDiagnosticsLog << "# board " << board.first << " read intervals" << std::endl;
+        statistics.ReadInterval.ToStream(mDiagnosticsLog);
+    }
+}
+
+void mtsRobotIO1394::GetBoardStatistics(vctDoubleMat & placeHolder) const
+{
+    std::lock_guard<std::mutex> lock(mDiagnosticsMutex);
+    placeHolder.ForceAssign(mBoardStatisticsSnapshot);
+}
+
+void mtsRobotIO1394::GetBoardReadIntervalHistograms(vctIntMat & placeHolder) const
+{
+    std::lock_guard<std::mutex> lock(mDiagnosticsMutex);
+    placeHolder.ForceAssign(mBoardReadIntervalSnapshot);
+}
+
+void mtsRobotIO1394::GetBoardReadIntervalBinWidth(double & placeHolder) const
+{
+    placeHolder = BoardReadIntervalBinWidth;
+}
+
+void mtsRobotIO1394::SetTracing(const bool & enable)
+{
+    osaTrace1394::Enable(enable);
+}
+
+void mtsRobotIO1394::SaveTrace(const std::string & filename)
+{
+    if (!osaTrace1394::Save(filename)) {
+        CMN_LOG_CLASS_RUN_ERROR << "SaveTrace: failed to save trace in \"" << filename << "\"" << std::endl;
+    }
+}
+
+void mtsRobotIO1394::SetRealTimeCPU(const int cpu)
+{
+    mRealTimeCPU = cpu;
+}
+
+void mtsRobotIO1394::SetRealTimePriority(const int priority)
+{
+    mRealTimePriority = priority;
+}
+
+void mtsRobotIO1394::SetRealTimeLockMemory(const bool lock)
+{
+    mRealTimeLockMemory = lock;
+}
+
+void mtsRobotIO1394::SetupRealTime(void)
+{
+    std::stringstream status;
+    bool ok = true;
+
+    if (mRealTimeCPU >= NumberOfAffinityCPUs()) {
+        ok = false;
+        status << "invalid cpu " << mRealTimeCPU << ", only " << NumberOfAffinityCPUs() << " available";
+        CMN_LOG_CLASS_INIT_ERROR << "SetupRealTime: invalid cpu " << mRealTimeCPU << ", only "
+                                 << NumberOfAffinityCPUs() << " available, affinity not set" << std::endl;
+    } else if (mRealTimeCPU >= 0) {
+        osaCPUSetAffinity(static_cast<osaCPUMask>(1) << mRealTimeCPU);
+        status << "cpu " << mRealTimeCPU;
+    } else {
+        status << "cpu any";
+    }
+
+#if (CISST_OS == CISST_LINUX)
+    if (mRealTimePriority > 0) {
+        struct sched_param param;
+        param.sched_priority = mRealTimePriority;
+        const int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (result == 0) {
+            status << ", SCHED_FIFO priority " << mRealTimePriority;
+        } else {
+            ok = false;
+            status << ", failed to set SCHED_FIFO priority " << mRealTimePriority
+                   << " (" << strerror(result) << ")";
+        }
+    } else {
+        status << ", default scheduling";
+    }
+
+    if (mRealTimeLockMemory) {
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0) {
+            // touch stack pages so they are mapped and locked before Run
+            volatile char stack[128 * 1024];
+            for (size_t index = 0; index < sizeof(stack); index += 1024) {
+                stack[index] = 0;
+            }
+            status << ", memory locked";
+        } else {
+            ok = false;
+            status << ", failed to lock memory (" << strerror(errno) << ")";
+        }
+    } else {
+        status << ", memory not locked";
+    }
+#else
+    if ((mRealTimePriority > 0) || mRealTimeLockMemory) {
+        ok = false;
+        status << ", real-time priority and memory locking not supported on this OS";
+    }
+#endif
+
+    mRealTimeStatus = status.str();
+    if (ok) {
+        CMN_LOG_CLASS_INIT_VERBOSE << "SetupRealTime: " << mRealTimeStatus << std::endl;
+    } else {
+        CMN_LOG_CLASS_INIT_WARNING << "SetupRealTime: " << mRealTimeStatus << std::endl;
+    }
+}
+
+void mtsRobotIO1394::GetRealTimeStatus(std::string & placeHolder) const
+{
+    placeHolder = mRealTimeStatus;
+}
+
+void mtsRobotIO1394::GetNumberOfCycleAllocations(int & placeHolder) const
+{
+    placeHolder = static_cast<int>(osaAllocationGuard1394::Count());
+}
+
+void mtsRobotIO1394::GetProtocol(int & placeHolder) const
+{
+    placeHolder = mProtocol;
+}
+
+void mtsRobotIO1394::GetProtocolBenchmark(vctDoubleMat & placeHolder) const
+{
+    placeHolder.ForceAssign(mProtocolBenchmark);
+}
+
+void mtsRobotIO1394::GetTimeHistogramBinWidth(double & placeHolder) const
+{
+    placeHolder = mReadTimeHistogram.BinWidth();
+}
+
 void mtsRobotIO1394::GetNumberOfRobots(int & placeHolder) const
 {
+    std::lock_guard<std::mutex> lock(mStagingMutex);
     placeHolder = mRobots.size();
 }
 
@@ -580,6 +2196,7 @@ const mtsRobot1394 * mtsRobotIO1394::Robot(const size_t index) const
 
 void mtsRobotIO1394::GetNumberOfActuatorsPerRobot(vctIntVec & placeHolder) const
 {
+    std::lock_guard<std::mutex> lock(mStagingMutex);
     size_t numRobots = mRobots.size();
     placeHolder.resize(numRobots);
     for (size_t i = 0; i < numRobots; i++) {
@@ -589,6 +2206,7 @@ void mtsRobotIO1394::GetNumberOfActuatorsPerRobot(vctIntVec & placeHolder) const
 
 void mtsRobotIO1394::GetNumberOfBrakesPerRobot(vctIntVec & placeHolder) const
 {
+    std::lock_guard<std::mutex> lock(mStagingMutex);
     size_t numRobots = mRobots.size();
     placeHolder.resize(numRobots);
     for (size_t i = 0; i < numRobots; i++) {
@@ -597,6 +2215,23 @@ void mtsRobotIO1394::GetNumberOfBrakesPerRobot(vctIntVec & placeHolder) const
 }
 
 void mtsRobotIO1394::AddRobot(mtsRobot1394 * robot)
+{
+    // Same as changes staged at runtime but applied immediately
+    StagedChanges changes;
+    CopyDeviceLists(changes.Lists);
+    CollectInterfaces(changes.Lists.Interfaces);
+    try {
+        AddRobot(robot, changes);
+    } catch (...) {
+        DiscardStagedChanges(changes);
+        throw;
+    }
+    // Watchdog period is set for all robots in Startup
+    ApplyStagedChanges(changes);
+    RetireStagedChanges(changes);
+}
+
+void mtsRobotIO1394::AddRobot(mtsRobot1394 * robot, StagedChanges & changes)
 {
     if (robot == 0) {
         cmnThrow("mtsRobotIO1394::AddRobot: Robot pointer is null.");
@@ -605,7 +2240,7 @@ void mtsRobotIO1394::AddRobot(mtsRobot1394 * robot)
     const osaRobot1394Configuration & config = robot->GetConfiguration();
 
     // Check to make sure this robot isn't already added
-    if (mRobotsByName.count(config.Name) > 0) {
+    if (changes.Lists.RobotsByName.count(config.Name) > 0) {
         cmnThrow(robot->Name() + ": robot name is not unique.");
     }
 
@@ -619,14 +2254,10 @@ void mtsRobotIO1394::AddRobot(mtsRobot1394 * robot)
         // Board for the actuator
         int boardId = config.Actuators[i].BoardID;
 
-        // If the board hasn't been created, construct it and add it to the port
-        if (mBoards.count(boardId) == 0) {
-            mBoards[boardId] = new AmpIO(boardId);
-            mPort->AddBoard(mBoards[boardId]);
-        }
-
         // Add the board to the list of boards relevant to this robot
-        actuatorBoards[i].Board = mBoards[boardId];
+        BoardData * board = Board(boardId, changes);
+        actuatorBoards[i].Board = board->Board;
+        actuatorBoards[i].Clock = &(board->Clock);
         actuatorBoards[i].BoardID = boardId;
         actuatorBoards[i].Axis = config.Actuators[i].AxisID;
 
@@ -636,14 +2267,10 @@ void mtsRobotIO1394::AddRobot(mtsRobot1394 * robot)
             // Board for the brake
             boardId = brake->BoardID;
 
-            // If the board hasn't been created, construct it and add it to the port
-            if (mBoards.count(boardId) == 0) {
-                mBoards[boardId] = new AmpIO(boardId);
-                mPort->AddBoard(mBoards[boardId]);
-            }
-
             // Add the board to the list of boards relevant to this robot
-            brakeBoards[currentBrake].Board = mBoards[boardId];
+            board = Board(boardId, changes);
+            brakeBoards[currentBrake].Board = board->Board;
+            brakeBoards[currentBrake].Clock = &(board->Clock);
             brakeBoards[currentBrake].BoardID = boardId;
             brakeBoards[currentBrake].Axis = brake->AxisID;
             currentBrake++;
@@ -653,12 +2280,30 @@ void mtsRobotIO1394::AddRobot(mtsRobot1394 * robot)
     // Set the robot boards
     robot->SetBoards(actuatorBoards, brakeBoards);
 
+    // Spread devices with the same rate across cycles
+    robot->SetRatePhase(NextRatePhase(robot->RateDivisor()));
+
     // Store the robot by name
-    mRobots.push_back(robot);
-    mRobotsByName[config.Name] = robot;
+    changes.Lists.Robots.push_back(robot);
+    changes.Lists.RobotsByName[config.Name] = robot;
 }
 
 void mtsRobotIO1394::AddDigitalInput(mtsDigitalInput1394 * digitalInput)
+{
+    StagedChanges changes;
+    CopyDeviceLists(changes.Lists);
+    CollectInterfaces(changes.Lists.Interfaces);
+    try {
+        AddDigitalInput(digitalInput, changes);
+    } catch (...) {
+        DiscardStagedChanges(changes);
+        throw;
+    }
+    ApplyStagedChanges(changes);
+    RetireStagedChanges(changes);
+}
+
+void mtsRobotIO1394::AddDigitalInput(mtsDigitalInput1394 * digitalInput, StagedChanges & changes)
 {
     if (digitalInput == 0) {
         cmnThrow("mtsRobotIO1394::AddDigitalInput: digital input pointer is null.");
@@ -667,28 +2312,77 @@ void mtsRobotIO1394::AddDigitalInput(mtsDigitalInput1394 * digitalInput)
     const osaDigitalInput1394Configuration & config = digitalInput->Configuration();
 
     // Check to make sure this digital input isn't already added
-    if (mDigitalInputsByName.count(config.Name) > 0) {
+    if (changes.Lists.DigitalInputsByName.count(config.Name) > 0) {
         cmnThrow(digitalInput->Name() + ": digital input name is not unique.");
     }
 
-    // Construct a vector of boards relevant to this digital input
-    int boardID = config.BoardID;
+    // Store the digital input by name
+    changes.Lists.DigitalInputs.push_back(digitalInput);
+    changes.Lists.DigitalInputsByName[config.Name] = digitalInput;
+
+    // Add to the inputs for this board, the bank reads the board
+    RebuildDigitalInputBank(config.BoardID, changes);
+}
 
-    // If the board hasn't been created, construct it and add it to the port
-    if (mBoards.count(boardID) == 0) {
-        mBoards[boardID] = new AmpIO(boardID);
-        mPort->AddBoard(mBoards[boardID]);
+void mtsRobotIO1394::RebuildDigitalInputBank(const int boardKey, StagedChanges & changes)
+{
+    // Banks used by the IO thread are never modified, a new bank is
+    // created with all the inputs on this board
+    const auto current = changes.Lists.DigitalInputBanks.find(boardKey);
+    if (current != changes.Lists.DigitalInputBanks.end()) {
+        const auto added = changes.AddedBanks.find(boardKey);
+        if (added != changes.AddedBanks.end()) {
+            // not used yet
+            delete added->second;
+            changes.AddedBanks.erase(added);
+        } else {
+            changes.ReplacedBanks[boardKey] = current->second;
+        }
+        changes.Lists.DigitalInputBanks.erase(current);
+    }
+    mtsDigitalInputBank1394 * bank = 0;
+    try {
+        for (auto & input : changes.Lists.DigitalInputs) {
+            if (input->Configuration().BoardID != boardKey) {
+                continue;
+            }
+            if (!bank) {
+                BoardData * board = Board(boardKey, changes);
+                bank = new mtsDigitalInputBank1394(board->Board, &(board->Clock));
+            }
+            bank->AddInput(input);
+        }
+    } catch (...) {
+        delete bank;
+        throw;
+    }
+    if (!bank) {
+        return;
     }
 
-    // Assign the board to the digital input
-    digitalInput->SetBoard(mBoards[boardID]);
+    // Spread devices with the same rate across cycles
+    bank->SetRatePhase(NextRatePhase(bank->RateDivisor()));
 
-    // Store the digital input by name
-    mDigitalInputs.push_back(digitalInput);
-    mDigitalInputsByName[config.Name] = digitalInput;
+    changes.Lists.DigitalInputBanks[boardKey] = bank;
+    changes.AddedBanks[boardKey] = bank;
 }
 
 void mtsRobotIO1394::AddDigitalOutput(mtsDigitalOutput1394 * digitalOutput)
+{
+    StagedChanges changes;
+    CopyDeviceLists(changes.Lists);
+    CollectInterfaces(changes.Lists.Interfaces);
+    try {
+        AddDigitalOutput(digitalOutput, changes);
+    } catch (...) {
+        DiscardStagedChanges(changes);
+        throw;
+    }
+    ApplyStagedChanges(changes);
+    RetireStagedChanges(changes);
+}
+
+void mtsRobotIO1394::AddDigitalOutput(mtsDigitalOutput1394 * digitalOutput, StagedChanges & changes)
 {
     if (digitalOutput == 0) {
         cmnThrow("mtsRobotIO1394::AddDigitalOutput: digital output pointer is null.");
@@ -697,28 +2391,40 @@ void mtsRobotIO1394::AddDigitalOutput(mtsDigitalOutput1394 * digitalOutput)
     const osaDigitalOutput1394Configuration & config = digitalOutput->Configuration();
 
     // Check to make sure this digital output isn't already added
-    if (mDigitalOutputsByName.count(config.Name) > 0) {
+    if (changes.Lists.DigitalOutputsByName.count(config.Name) > 0) {
         cmnThrow(digitalOutput->Name() + ": digital output name is not unique.");
     }
 
     // Construct a vector of boards relevant to this digital output
     int boardID = config.BoardID;
 
-    // If the board hasn't been created, construct it and add it to the port
-    if (mBoards.count(boardID) == 0) {
-        mBoards[boardID] = new AmpIO(boardID);
-        mPort->AddBoard(mBoards[boardID]);
-    }
-
     // Assign the board to the digital output
-    digitalOutput->SetBoard(mBoards[boardID]);
+    digitalOutput->SetBoard(Board(boardID, changes)->Board);
+
+    // Spread devices with the same rate across cycles
+    digitalOutput->SetRatePhase(NextRatePhase(digitalOutput->RateDivisor()));
 
     // Store the digital output by name
-    mDigitalOutputs.push_back(digitalOutput);
-    mDigitalOutputsByName[config.Name] = digitalOutput;
+    changes.Lists.DigitalOutputs.push_back(digitalOutput);
+    changes.Lists.DigitalOutputsByName[config.Name] = digitalOutput;
 }
 
 void mtsRobotIO1394::AddDallasChip(mtsDallasChip1394 * dallasChip)
+{
+    StagedChanges changes;
+    CopyDeviceLists(changes.Lists);
+    CollectInterfaces(changes.Lists.Interfaces);
+    try {
+        AddDallasChip(dallasChip, changes);
+    } catch (...) {
+        DiscardStagedChanges(changes);
+        throw;
+    }
+    ApplyStagedChanges(changes);
+    RetireStagedChanges(changes);
+}
+
+void mtsRobotIO1394::AddDallasChip(mtsDallasChip1394 * dallasChip, StagedChanges & changes)
 {
     if (dallasChip == 0) {
         cmnThrow("mtsRobotIO1394::AddDallasChip: Dallas chip pointer is null.");
@@ -727,29 +2433,118 @@ void mtsRobotIO1394::AddDallasChip(mtsDallasChip1394 * dallasChip)
     const osaDallasChip1394Configuration & config = dallasChip->Configuration();
 
     // Check to make sure this Dallas chip isn't already added
-    if (mDallasChipsByName.count(config.Name) > 0) {
+    if (changes.Lists.DallasChipsByName.count(config.Name) > 0) {
         cmnThrow(dallasChip->Name() + ": Dallas chip name is not unique.");
     }
 
     // Construct a vector of boards relevant to this Dallas chip
     int boardID = config.BoardID;
 
-    // If the board hasn't been created, construct it and add it to the port
-    if (mBoards.count(boardID) == 0) {
-        mBoards[boardID] = new AmpIO(boardID);
-        mPort->AddBoard(mBoards[boardID]);
-    }
-
     // Assign the board to the Dallas chip
-    dallasChip->SetBoard(mBoards[boardID]);
+    dallasChip->SetBoard(Board(boardID, changes)->Board);
+
+    // Spread devices with the same rate across cycles
+    dallasChip->SetRatePhase(NextRatePhase(dallasChip->RateDivisor()));
 
     // Store the digital output by name
-    mDallasChips.push_back(dallasChip);
-    mDallasChipsByName[config.Name] = dallasChip;
+    changes.Lists.DallasChips.push_back(dallasChip);
+    changes.Lists.DallasChipsByName[config.Name] = dallasChip;
+}
+
+size_t mtsRobotIO1394::NextRatePhase(const size_t rateDivisor)
+{
+    if (rateDivisor <= 1) {
+        return 0;
+    }
+    size_t & counter = mRatePhaseCounters[rateDivisor];
+    const size_t phase = counter % rateDivisor;
+    counter++;
+    return phase;
+}
+
+mtsRobotIO1394::BoardData * mtsRobotIO1394::Board(const int boardKey, StagedChanges & changes)
+{
+    // If the board hasn't been created, construct it, it is added to
+    // its port when the changes are applied
+    const auto board = changes.Lists.Boards.find(boardKey);
+    if (board != changes.Lists.Boards.end()) {
+        return board->second;
+    }
+    const size_t portIndex = boardKey / MAX_BOARDS;
+    if ((boardKey < 0) || (portIndex >= mPorts.size())) {
+        std::stringstream message;
+        message << "mtsRobotIO1394::Board: invalid board " << boardKey
+                << ", component has " << mPorts.size() << " port(s)";
+        cmnThrow(message.str());
+    }
+    BoardData * newBoard = new BoardData(new AmpIO(boardKey % MAX_BOARDS));
+    newBoard->Clock.Reset();
+    changes.Lists.Boards[boardKey] = newBoard;
+    changes.AddedBoards[boardKey] = newBoard;
+    return newBoard;
+}
+
+void mtsRobotIO1394::DiscoverBoards(const bool querySerialNumbers)
+{
+    std::lock_guard<std::mutex> lock(mStagingMutex);
+
+    // Query each physical board once, even if shared between robots
+    // and IOs.  All transactions go through the same port so queries
+    // are sequential.
+    const double startTime = osaGetTime();
+    size_t newBoards = 0;
+    for (auto & board : mBoards) {
+        BoardInventory & inventory = board.second->Inventory;
+        if (inventory.FirmwareVersion != 0) {
+            continue;
+        }
+        inventory.FirmwareVersion = board.second->Board->GetFirmwareVersion();
+        if (inventory.FirmwareVersion == 0) {
+            CMN_LOG_CLASS_INIT_ERROR << "DiscoverBoards: unable to get firmware version for port: "
+                                     << board.first / MAX_BOARDS
+                                     << ", board Id: " << board.first % MAX_BOARDS
+                                     << ".  Make sure the controller is powered and connected" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        if (querySerialNumbers) {
+            inventory.FPGASerialNumber = board.second->Board->GetFPGASerialNumber();
+            inventory.QLASerialNumber = board.second->Board->GetQLASerialNumber();
+        }
+        if (inventory.FPGASerialNumber.empty()) {
+            inventory.FPGASerialNumber = "unknown";
+        }
+        if (inventory.QLASerialNumber.empty()) {
+            inventory.QLASerialNumber = "unknown";
+        }
+        ++newBoards;
+        CMN_LOG_CLASS_INIT_WARNING << "DiscoverBoards: port: " << board.first / MAX_BOARDS
+                                   << ", board Id: " << board.first % MAX_BOARDS
+                                   << ", firmware: " << inventory.FirmwareVersion
+                                   << ", FPGA serial: " << inventory.FPGASerialNumber
+                                   << ", QLA serial: " << inventory.QLASerialNumber
+                                   << std::endl;
+    }
+    if (newBoards == 0) {
+        return;
+    }
+    CMN_LOG_CLASS_INIT_VERBOSE << "DiscoverBoards: queried " << newBoards << " board(s) in "
+                               << (osaGetTime() - startTime) * 1000.0 << " ms" << std::endl;
+
+    // Update firmware range for all robots
+    std::map<int, unsigned int> firmwareVersions;
+    for (const auto & board : mBoards) {
+        firmwareVersions[board.first] = board.second->Inventory.FirmwareVersion;
+    }
+    for (auto & robot : mRobots) {
+        robot->SetFirmwareVersions(firmwareVersions);
+    }
 }
 
 bool mtsRobotIO1394::CheckFirmwareVersions(void)
 {
+    // Make sure we have the firmware versions for all boards
+    DiscoverBoards();
+
     unsigned int lowest = 99999;
     unsigned int highest = 0;
     for (const auto & robot : mRobots) {
@@ -830,6 +2625,7 @@ bool mtsRobotIO1394::CheckFirmwareVersions(void)
 
 void mtsRobotIO1394::GetRobotNames(std::vector<std::string> & names) const
 {
+    std::lock_guard<std::mutex> lock(mStagingMutex);
     names.clear();
     for (const auto & robot : mRobots) {
         names.push_back(robot->Name());
@@ -838,6 +2634,7 @@ void mtsRobotIO1394::GetRobotNames(std::vector<std::string> & names) const
 
 void mtsRobotIO1394::GetDigitalInputNames(std::vector<std::string> & names) const
 {
+    std::lock_guard<std::mutex> lock(mStagingMutex);
     names.clear();
     for (const auto & input : mDigitalInputs) {
         names.push_back(input->Name());
@@ -846,6 +2643,7 @@ void mtsRobotIO1394::GetDigitalInputNames(std::vector<std::string> & names) cons
 
 void mtsRobotIO1394::GetDigitalOutputNames(std::vector<std::string> & names) const
 {
+    std::lock_guard<std::mutex> lock(mStagingMutex);
     names.clear();
     for (const auto & output : mDigitalOutputs) {
         names.push_back(output->Name());
@@ -877,6 +2675,7 @@ void mtsRobotIO1394::IntervalStatisticsCallback(void)
         message << "average period (" << cmnInternalTo_ms(StateTable.PeriodStats.PeriodAvg())
                 << " ms) exceeded " << sawRobotIO1394::TimingMaxRatio << " time expected period ("
                 << cmnInternalTo_ms(expectedPeriod) << " ms)";
+        DumpFlightRecorder("average period exceeded");
     }
 
     // check load
@@ -0,0 +1,182 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  Author(s):  Anton Deguet
+  Created on: 2021-07-26
+
+  (C) Copyright 2021 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <cisstCommon/cmnPortability.h>
+#include <sawRobotIO1394/osaAllocationGuard1394.h>
+
+#if defined(sawRobotIO1394_HAS_ALLOCATION_GUARD) && !defined(NDEBUG) && ((CISST_OS == CISST_LINUX) || (CISST_OS == CISST_DARWIN))
+#define sawRobotIO1394_ALLOCATION_STACK_TRACES
+#include <execinfo.h>
+#endif
+
+using namespace sawRobotIO1394;
+
+#ifdef sawRobotIO1394_HAS_ALLOCATION_GUARD
+
+namespace {
+    thread_local bool Guarded = false;
+    std::atomic<size_t> Allocations(0);
+
+#ifdef sawRobotIO1394_ALLOCATION_STACK_TRACES
+    struct StackTrace {
+        void * Frames[osaAllocationGuard1394::MAX_STACK_DEPTH];
+        int Depth;
+    };
+    StackTrace StackTraces[osaAllocationGuard1394::MAX_STACK_TRACES];
+    std::atomic<size_t> NumberOfStackTraces(0);
+#endif
+
+    inline void GuardedAllocation(void)
+    {
+        Allocations.fetch_add(1, std::memory_order_relaxed);
+#ifdef sawRobotIO1394_ALLOCATION_STACK_TRACES
+        const size_t index = NumberOfStackTraces.fetch_add(1);
+        if (index < osaAllocationGuard1394::MAX_STACK_TRACES) {
+            // backtrace might allocate the first time it's called
+            Guarded = false;
+            StackTraces[index].Depth = backtrace(StackTraces[index].Frames,
+                                                 osaAllocationGuard1394::MAX_STACK_DEPTH);
+            Guarded = true;
+        }
+#endif
+    }
+
+    inline void * Allocate(std::size_t size)
+    {
+        if (Guarded) {
+            GuardedAllocation();
+        }
+        return std::malloc(size ? size : 1);
+    }
+}
+
+void * operator new(std::size_t size)
+{
+    void * pointer = Allocate(size);
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void * operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void * operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return Allocate(size);
+}
+
+void * operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return Allocate(size);
+}
+
+void operator delete(void * pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void * pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void * pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void * pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+bool osaAllocationGuard1394::Available(void)
+{
+    return true;
+}
+
+void osaAllocationGuard1394::Begin(void)
+{
+    Guarded = true;
+}
+
+void osaAllocationGuard1394::End(void)
+{
+    Guarded = false;
+}
+
+size_t osaAllocationGuard1394::Count(void)
+{
+    return Allocations.load(std::memory_order_relaxed);
+}
+
+void osaAllocationGuard1394::LogStackTraces(std::ostream & outputStream)
+{
+#ifdef sawRobotIO1394_ALLOCATION_STACK_TRACES
+    size_t numberOfStackTraces = NumberOfStackTraces;
+    if (numberOfStackTraces > MAX_STACK_TRACES) {
+        numberOfStackTraces = MAX_STACK_TRACES;
+    }
+    for (size_t index = 0; index < numberOfStackTraces; ++index) {
+        outputStream << "allocation " << index << ":" << std::endl;
+        char ** symbols = backtrace_symbols(StackTraces[index].Frames, StackTraces[index].Depth);
+        if (symbols) {
+            for (int frame = 0; frame < StackTraces[index].Depth; ++frame) {
+                outputStream << "  " << symbols[frame] << std::endl;
+            }
+            std::free(symbols);
+        }
+    }
+#else
+    outputStream << "allocation stack traces are only available in debug builds" << std::endl;
+#endif
+}
+
+#else // sawRobotIO1394_HAS_ALLOCATION_GUARD
+
+bool osaAllocationGuard1394::Available(void)
+{
+    return false;
+}
+
+void osaAllocationGuard1394::Begin(void)
+{
+}
+
+void osaAllocationGuard1394::End(void)
+{
+}
+
+size_t osaAllocationGuard1394::Count(void)
+{
+    return 0;
+}
+
+void osaAllocationGuard1394::LogStackTraces(std::ostream & CMN_UNUSED(outputStream))
+{
+}
+
+#endif // sawRobotIO1394_HAS_ALLOCATION_GUARD
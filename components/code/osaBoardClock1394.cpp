@@ -0,0 +1,86 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  Author(s):  Anton Deguet
+  Created on: 2021-07-28
+
+  (C) Copyright 2021 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#include <cmath>
+
+#include <cisstCommon/cmnConstants.h>
+#include <sawRobotIO1394/osaBoardClock1394.h>
+
+using namespace sawRobotIO1394;
+
+void osaBoardClock1394::Reset(void)
+{
+    mNumberOfUpdates = 0;
+    mResynchronizations = 0;
+    mGap = false;
+    mElapsed = 0.0;
+    mTime = 0.0;
+    mSampleTime = 0.0;
+    mRate = 1.0;
+}
+
+void osaBoardClock1394::Update(const unsigned int ticks, const double hostTime)
+{
+    mElapsed = TicksToSeconds(ticks);
+
+    // first timestamp is relative to an unknown previous read
+    if (mNumberOfUpdates == 0) {
+        mNumberOfUpdates = 1;
+        mElapsed = 0.0;
+        mSampleTime = hostTime;
+        return;
+    }
+    mNumberOfUpdates++;
+
+    // invalid read(s) since last update, accumulate host time, drift
+    // corrected, and don't update the filter
+    if (mGap) {
+        mGap = false;
+        mElapsed = (hostTime - mSampleTime) / mRate;
+        mTime += mElapsed;
+        mSampleTime = hostTime;
+        return;
+    }
+
+    mTime += mElapsed;
+
+    // predict using current rate
+    mSampleTime += mRate * mElapsed;
+    const double error = hostTime - mSampleTime;
+
+    // IO loop stalled, host clock changed...  start from host time
+    // and keep the rate
+    if (std::fabs(error) > BoardClockMaximumError) {
+        mSampleTime = hostTime;
+        mResynchronizations++;
+        return;
+    }
+
+    // alpha-beta filter with host time as position and rate as
+    // velocity, critically damped with poles set by the bandwidth
+    const double pole = std::exp(-2.0 * cmnPI * BoardClockBandwidth * mElapsed);
+    mSampleTime += (1.0 - pole * pole) * error;
+    if (mElapsed > 0.0) {
+        mRate += (1.0 - pole) * (1.0 - pole) * error / mElapsed;
+        if (mRate > 1.0 + BoardClockMaximumDrift) {
+            mRate = 1.0 + BoardClockMaximumDrift;
+        } else if (mRate < 1.0 - BoardClockMaximumDrift) {
+            mRate = 1.0 - BoardClockMaximumDrift;
+        }
+    }
+}
@@ -0,0 +1,158 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  Author(s):  Anton Deguet
+  Created on: 2021-06-25
+
+  (C) Copyright 2021 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include <cisstCommon/cmnDataFunctions.h>
+#include <sawRobotIO1394/osaCache1394.h>
+
+namespace sawRobotIO1394 {
+
+    // increment when the cache layout or osaConfiguration1394.cdg changes
+    const int osaCache1394FormatVersion = 4;
+    const std::string osaCache1394Magic = "sawRobotIO1394-configuration-cache";
+
+    // identifies the configuration file content and the code that parsed it
+    static std::string osaCache1394Key(const std::string & sourceHash)
+    {
+        std::ostringstream key;
+        key << sourceHash << '-' << sawRobotIO1394_VERSION
+            << '-' << osaCache1394FormatVersion
+            << '-' << sizeof(size_t);
+        return key.str();
+    }
+
+    std::string osaCache1394FileHash(const std::string & filename)
+    {
+        std::ifstream file(filename.c_str(), std::ios::binary);
+        if (!file.good()) {
+            return "";
+        }
+        unsigned long long hash = 14695981039346656037ULL;
+        char buffer[4096];
+        while (file) {
+            file.read(buffer, sizeof(buffer));
+            const std::streamsize count = file.gcount();
+            for (std::streamsize index = 0; index < count; ++index) {
+                hash ^= static_cast<unsigned char>(buffer[index]);
+                hash *= 1099511628211ULL;
+            }
+        }
+        std::ostringstream result;
+        result << std::hex << std::setw(16) << std::setfill('0') << hash;
+        return result.str();
+    }
+
+    bool osaCache1394LoadPort(const std::string & cacheFilename,
+                              const std::string & sourceHash,
+                              osaPort1394Configuration & config)
+    {
+        std::ifstream cacheFile(cacheFilename.c_str(), std::ios::binary);
+        if (!cacheFile.good()) {
+            CMN_LOG_INIT_VERBOSE << "osaCache1394LoadPort: no cache file \""
+                                 << cacheFilename << "\"" << std::endl;
+            return false;
+        }
+        // local and remote formats are the same, cache files are not portable
+        const cmnDataFormat format;
+        osaPort1394Configuration cached;
+        try {
+            std::string magic, key;
+            cmnData<std::string>::DeSerializeBinary(magic, cacheFile, format, format);
+            if (magic != osaCache1394Magic) {
+                CMN_LOG_INIT_WARNING << "osaCache1394LoadPort: \"" << cacheFilename
+                                     << "\" is not a configuration cache file" << std::endl;
+                return false;
+            }
+            cmnData<std::string>::DeSerializeBinary(key, cacheFile, format, format);
+            if (key != osaCache1394Key(sourceHash)) {
+                CMN_LOG_INIT_VERBOSE << "osaCache1394LoadPort: cache file \""
+                                     << cacheFilename << "\" is out of date" << std::endl;
+                return false;
+            }
+            cmnData<osaPort1394Configuration>::DeSerializeBinary(cached, cacheFile, format, format);
+            // brakes are pointers and not serialized with the configuration
+            for (auto & robot : cached.Robots) {
+                for (auto & actuator : robot.Actuators) {
+                    bool hasBrake;
+                    cmnData<bool>::DeSerializeBinary(hasBrake, cacheFile, format, format);
+                    actuator.Brake = 0;
+                    if (hasBrake) {
+                        actuator.Brake = new osaAnalogBrake1394Configuration;
+                        cmnData<osaAnalogBrake1394Configuration>::DeSerializeBinary(*(actuator.Brake),
+                                                                                   cacheFile, format, format);
+                    }
+                }
+            }
+        } catch (std::exception & e) {
+            CMN_LOG_INIT_WARNING << "osaCache1394LoadPort: failed to read cache file \""
+                                 << cacheFilename << "\": " << e.what() << std::endl;
+            return false;
+        }
+        config = cached;
+        CMN_LOG_INIT_VERBOSE << "osaCache1394LoadPort: loaded configuration from cache file \""
+                             << cacheFilename << "\"" << std::endl;
+        return true;
+    }
+
+    bool osaCache1394SavePort(const std::string & cacheFilename,
+                              const std::string & sourceHash,
+                              const osaPort1394Configuration & config)
+    {
+        // write to temporary file and rename so readers never see a partial cache
+        const std::string temporaryFilename = cacheFilename + ".tmp";
+        std::ofstream cacheFile(temporaryFilename.c_str(), std::ios::binary | std::ios::trunc);
+        if (!cacheFile.good()) {
+            CMN_LOG_INIT_WARNING << "osaCache1394SavePort: failed to create cache file \""
+                                 << temporaryFilename << "\"" << std::endl;
+            return false;
+        }
+        try {
+            cmnData<std::string>::SerializeBinary(osaCache1394Magic, cacheFile);
+            cmnData<std::string>::SerializeBinary(osaCache1394Key(sourceHash), cacheFile);
+            cmnData<osaPort1394Configuration>::SerializeBinary(config, cacheFile);
+            for (const auto & robot : config.Robots) {
+                for (const auto & actuator : robot.Actuators) {
+                    const bool hasBrake = (actuator.Brake != 0);
+                    cmnData<bool>::SerializeBinary(hasBrake, cacheFile);
+                    if (hasBrake) {
+                        cmnData<osaAnalogBrake1394Configuration>::SerializeBinary(*(actuator.Brake), cacheFile);
+                    }
+                }
+            }
+        } catch (std::exception & e) {
+            CMN_LOG_INIT_WARNING << "osaCache1394SavePort: failed to write cache file \""
+                                 << temporaryFilename << "\": " << e.what() << std::endl;
+            cacheFile.close();
+            std::remove(temporaryFilename.c_str());
+            return false;
+        }
+        cacheFile.close();
+        if (!cacheFile || (std::rename(temporaryFilename.c_str(), cacheFilename.c_str()) != 0)) {
+            CMN_LOG_INIT_WARNING << "osaCache1394SavePort: failed to save cache file \""
+                                 << cacheFilename << "\"" << std::endl;
+            std::remove(temporaryFilename.c_str());
+            return false;
+        }
+        return true;
+    }
+
+} // namespace sawRobotIO1394
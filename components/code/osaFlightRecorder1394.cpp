@@ -0,0 +1,110 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  Author(s):  Anton Deguet
+  Created on: 2021-07-19
+
+  (C) Copyright 2021 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+#include <cisstCommon/cmnLogger.h>
+#include <sawRobotIO1394/osaFlightRecorder1394.h>
+
+using namespace sawRobotIO1394;
+
+osaFlightRecorder1394::osaFlightRecorder1394(const std::string & filePrefix,
+                                             const size_t numberOfCycles):
+    mFilePrefix(filePrefix),
+    mCycles(numberOfCycles > 0 ? numberOfCycles : 1),
+    mSnapshot(numberOfCycles > 0 ? numberOfCycles : 1),
+    mDumping(false),
+    mRunning(true),
+    mNumberOfDumps(0)
+{
+    mThread.Create<osaFlightRecorder1394, int>(this, &osaFlightRecorder1394::WriterLoop,
+                                               0, "IO1394Recorder");
+}
+
+osaFlightRecorder1394::~osaFlightRecorder1394()
+{
+    mRunning = false;
+    mSignal.Raise();
+    mThread.Wait();
+}
+
+bool osaFlightRecorder1394::Dump(const char * reason)
+{
+    if (mDumping) {
+        return false;
+    }
+    // copy oldest first
+    const size_t size = mCycles.size();
+    const size_t first = (mCount < size) ? 0 : mNext;
+    for (size_t index = 0; index < mCount; ++index) {
+        mSnapshot[index] = mCycles[(first + index) % size];
+    }
+    mSnapshotCount = mCount;
+    mReason = reason;
+    mDumping = true;
+    mSignal.Raise();
+    return true;
+}
+
+void * osaFlightRecorder1394::WriterLoop(int CMN_UNUSED(dummy))
+{
+    while (true) {
+        mSignal.Wait();
+        if (!mRunning) {
+            break;
+        }
+        if (!mDumping) {
+            continue;
+        }
+        const size_t dumpIndex = ++mNumberOfDumps;
+        std::stringstream fileName;
+        fileName << mFilePrefix << "-" << dumpIndex << ".csv";
+        const std::string temporaryFileName = fileName.str() + ".tmp";
+        std::ofstream file(temporaryFileName.c_str());
+        if (file.is_open()) {
+            file << "# " << mReason << std::endl
+                 << "start-time,read-time,post-read-time,commands-time,write-time,cycle-time,invalid-boards,commands" << std::endl
+                 << std::setprecision(9);
+            for (size_t index = 0; index < mSnapshotCount; ++index) {
+                const Cycle & cycle = mSnapshot[index];
+                file << std::fixed << cycle.StartTime << ","
+                     << cycle.ReadTime << ","
+                     << cycle.PostReadTime << ","
+                     << cycle.CommandsTime << ","
+                     << cycle.WriteTime << ","
+                     << cycle.CycleTime << ","
+                     << std::hex << "0x" << cycle.InvalidBoards << std::dec << ","
+                     << cycle.NumberOfCommands << std::endl;
+            }
+            file.close();
+            if (std::rename(temporaryFileName.c_str(), fileName.str().c_str()) == 0) {
+                CMN_LOG_INIT_WARNING << "osaFlightRecorder1394: " << mReason << ", saved last "
+                                     << mSnapshotCount << " cycles in \"" << fileName.str() << "\"" << std::endl;
+            } else {
+                CMN_LOG_INIT_ERROR << "osaFlightRecorder1394: failed to rename \"" << temporaryFileName << "\"" << std::endl;
+            }
+        } else {
+            CMN_LOG_INIT_ERROR << "osaFlightRecorder1394: failed to open \"" << temporaryFileName << "\"" << std::endl;
+        }
+        mDumping = false;
+    }
+    return 0;
+}
@@ -0,0 +1,837 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  Author(s):  Anton Deguet
+  Created on: 2021-06-21
+
+  (C) Copyright 2021 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+#include <sawRobotIO1394/osaJSON1394.h>
+#include <cisstNumerical/nmrInverse.h>
+
+namespace sawRobotIO1394 {
+
+    // Helper class to validate a JSON document and report errors
+    // with file:line:column and the path of the value in the document
+    class osaJSON1394Reader
+    {
+    public:
+        osaJSON1394Reader(const std::string & filename, const std::string & document):
+            mFilename(filename),
+            mNumberOfErrors(0)
+        {
+            // offset of the first character of each line, to convert offsets to line/column
+            mLineStarts.push_back(0);
+            for (size_t index = 0; index < document.size(); ++index) {
+                if (document[index] == '\n') {
+                    mLineStarts.push_back(index + 1);
+                }
+            }
+        }
+
+        inline size_t NumberOfErrors(void) const {
+            return mNumberOfErrors;
+        }
+
+        std::string Location(const Json::Value & value) const {
+            std::ostringstream location;
+            location << mFilename;
+            const ptrdiff_t offset = value.getOffsetStart();
+            if (offset >= 0) {
+                const size_t line = std::upper_bound(mLineStarts.begin(), mLineStarts.end(),
+                                                     static_cast<size_t>(offset)) - mLineStarts.begin();
+                location << ':' << line << ':' << (offset - mLineStarts[line - 1] + 1);
+            }
+            return location.str();
+        }
+
+        void Error(const Json::Value & value, const std::string & path, const std::string & message) {
+            CMN_LOG_INIT_ERROR << "osaJSON1394ConfigurePort: " << Location(value) << ": "
+                               << (path.empty() ? "<root>" : path) << ": " << message << std::endl;
+            ++mNumberOfErrors;
+        }
+
+        void Warning(const Json::Value & value, const std::string & path, const std::string & message) const {
+            CMN_LOG_INIT_WARNING << "osaJSON1394ConfigurePort: " << Location(value) << ": "
+                                 << (path.empty() ? "<root>" : path) << ": " << message << std::endl;
+        }
+
+        void RateDivisor(const Json::Value & object, const std::string & path, int & rateDivisor) {
+            rateDivisor = 1;
+            if (Get(object, path, "RateDivisor", rateDivisor, false) && (rateDivisor < 1)) {
+                Error(object["RateDivisor"], Path(path, "RateDivisor"), "must be 1 or greater");
+            }
+        }
+
+        inline static std::string Path(const std::string & path, const char * key) {
+            return path.empty() ? std::string(key) : path + '.' + key;
+        }
+
+        inline static std::string Path(const std::string & path, const size_t index) {
+            std::ostringstream result;
+            result << path << '[' << index << ']';
+            return result.str();
+        }
+
+        // warn about unknown members, most likely typos
+        void CheckMembers(const Json::Value & object, const std::string & path,
+                          const std::vector<std::string> & known) const {
+            for (const auto & name : object.getMemberNames()) {
+                if (std::find(known.begin(), known.end(), name) == known.end()) {
+                    Warning(object[name], Path(path, name.c_str()), "unknown member, ignored");
+                }
+            }
+        }
+
+        bool IsObject(const Json::Value & value, const std::string & path) {
+            if (!value.isObject()) {
+                Error(value, path, "must be an object");
+                return false;
+            }
+            return true;
+        }
+
+        bool IsArray(const Json::Value & value, const std::string & path) {
+            if (!value.isArray()) {
+                Error(value, path, "must be an array");
+                return false;
+            }
+            return true;
+        }
+
+        // returns 0 if missing
+        const Json::Value * Member(const Json::Value & object, const std::string & path,
+                                   const char * key, const bool required) {
+            if (!object.isMember(key) || object[key].isNull()) {
+                if (required) {
+                    Error(object, path, std::string("\"") + key + "\" is required but not found");
+                }
+                return 0;
+            }
+            return &(object[key]);
+        }
+
+        bool Get(const Json::Value & object, const std::string & path, const char * key,
+                 int & value, const bool required = true) {
+            const Json::Value * member = Member(object, path, key, required);
+            if (!member) {
+                return false;
+            }
+            if (!member->isInt()) {
+                Error(*member, Path(path, key), "must be an integer");
+                return false;
+            }
+            value = member->asInt();
+            return true;
+        }
+
+        bool Get(const Json::Value & object, const std::string & path, const char * key,
+                 double & value, const bool required = true) {
+            const Json::Value * member = Member(object, path, key, required);
+            if (!member) {
+                return false;
+            }
+            if (!member->isNumeric()) {
+                Error(*member, Path(path, key), "must be a number");
+                return false;
+            }
+            value = member->asDouble();
+            return true;
+        }
+
+        bool Get(const Json::Value & object, const std::string & path, const char * key,
+                 bool & value, const bool required = true) {
+            const Json::Value * member = Member(object, path, key, required);
+            if (!member) {
+                return false;
+            }
+            if (!member->isBool()) {
+                Error(*member, Path(path, key), "must be a boolean (true or false)");
+                return false;
+            }
+            value = member->asBool();
+            return true;
+        }
+
+        bool Get(const Json::Value & object, const std::string & path, const char * key,
+                 std::string & value, const bool required = true) {
+            const Json::Value * member = Member(object, path, key, required);
+            if (!member) {
+                return false;
+            }
+            if (!member->isString()) {
+                Error(*member, Path(path, key), "must be a string");
+                return false;
+            }
+            value = member->asString();
+            return true;
+        }
+
+        bool GetIndex(const Json::Value & object, const std::string & path, const char * key,
+                      int & value, const int maximum) {
+            if (!Get(object, path, key, value)) {
+                return false;
+            }
+            if ((value < 0) || (value >= maximum)) {
+                std::ostringstream message;
+                message << "must be between 0 and " << maximum - 1 << ", found " << value;
+                Error(object[key], Path(path, key), message.str());
+                return false;
+            }
+            return true;
+        }
+
+        void LinearFunction(const Json::Value & object, const std::string & path, const char * key,
+                            osaLinearFunction & function, const bool required) {
+            const Json::Value * member = Member(object, path, key, required);
+            if (!member) {
+                return;
+            }
+            const std::string functionPath = Path(path, key);
+            if (!IsObject(*member, functionPath)) {
+                return;
+            }
+            CheckMembers(*member, functionPath, {"Scale", "Offset", "Unit"});
+            Get(*member, functionPath, "Scale", function.Scale);
+            Get(*member, functionPath, "Offset", function.Offset, false);
+            Get(*member, functionPath, "Unit", function.Unit, false);
+        }
+
+        void Unit(const Json::Value & object, const std::string & path, const char * key,
+                  const osaLinearFunction & function, const prmJointType jointType) {
+            if (jointType == PRM_JOINT_REVOLUTE) {
+                if (!osaUnitIsDistanceRevolute(function.Unit)) {
+                    Error(object.isMember(key) ? object[key] : object, Path(path, key),
+                          "invalid unit, must be rad or deg but found \"" + function.Unit + "\"");
+                }
+            } else if (jointType == PRM_JOINT_PRISMATIC) {
+                if (!osaUnitIsDistancePrismatic(function.Unit)) {
+                    Error(object.isMember(key) ? object[key] : object, Path(path, key),
+                          "invalid unit, must be mm, cm or m but found \"" + function.Unit + "\"");
+                }
+            }
+        }
+
+        void Matrix(const Json::Value & object, const std::string & path, const char * key,
+                    const size_t rows, const size_t cols, vctDoubleMat & matrix) {
+            // missing matrix is fine, size is set to 0, 0
+            matrix.SetSize(0, 0);
+            const Json::Value * member = Member(object, path, key, false);
+            if (!member) {
+                return;
+            }
+            const std::string matrixPath = Path(path, key);
+            if (!IsArray(*member, matrixPath)) {
+                return;
+            }
+            if (member->size() != rows) {
+                std::ostringstream message;
+                message << "must have " << rows << " rows, found " << member->size();
+                Error(*member, matrixPath, message.str());
+                return;
+            }
+            matrix.SetSize(rows, cols, 0.0);
+            for (Json::ArrayIndex row = 0; row < rows; ++row) {
+                const Json::Value & jsonRow = (*member)[row];
+                const std::string rowPath = Path(matrixPath, row);
+                if (!IsArray(jsonRow, rowPath)) {
+                    continue;
+                }
+                if (jsonRow.size() != cols) {
+                    std::ostringstream message;
+                    message << "must have " << cols << " columns, found " << jsonRow.size();
+                    Error(jsonRow, rowPath, message.str());
+                    continue;
+                }
+                for (Json::ArrayIndex col = 0; col < cols; ++col) {
+                    if (!jsonRow[col].isNumeric()) {
+                        Error(jsonRow[col], Path(rowPath, col), "must be a number");
+                        continue;
+                    }
+                    matrix.Element(row, col) = jsonRow[col].asDouble();
+                }
+            }
+        }
+
+        void JointType(const Json::Value & object, const std::string & path, prmJointType & jointType) {
+            const Json::Value * member = Member(object, path, "JointType", false);
+            if (!member) {
+                Warning(object, path, "no \"JointType\" specified, set to revolute by default");
+                jointType = PRM_JOINT_REVOLUTE;
+                return;
+            }
+            // format used by cisst serialization first
+            try {
+                cmnDataJSON<prmJointType>::DeSerializeText(jointType, *member);
+                if ((jointType == PRM_JOINT_REVOLUTE) || (jointType == PRM_JOINT_PRISMATIC)) {
+                    return;
+                }
+            } catch (...) {
+            }
+            // then names used in XML files
+            if (member->isString()) {
+                std::string name = member->asString();
+                std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+                if (name.find("REVOLUTE") != std::string::npos) {
+                    jointType = PRM_JOINT_REVOLUTE;
+                    return;
+                }
+                if (name.find("PRISMATIC") != std::string::npos) {
+                    jointType = PRM_JOINT_PRISMATIC;
+                    return;
+                }
+            }
+            Error(*member, Path(path, "JointType"), "must be revolute or prismatic");
+        }
+
+        void PotLocation(const Json::Value & object, const std::string & path,
+                         osaPot1394Location::Type & location) {
+            location = osaPot1394Location::POTENTIOMETER_UNDEFINED;
+            const Json::Value * member = Member(object, path, "PotLocation", false);
+            if (!member) {
+                return;
+            }
+            // format used by cisst serialization first
+            try {
+                cmnDataJSON<osaPot1394Location::Type>::DeSerializeText(location, *member);
+                return;
+            } catch (...) {
+            }
+            // then names used in XML files
+            if (member->isString()) {
+                if (member->asString() == "Actuators") {
+                    location = osaPot1394Location::POTENTIOMETER_ON_ACTUATORS;
+                    return;
+                }
+                if (member->asString() == "Joints") {
+                    location = osaPot1394Location::POTENTIOMETER_ON_JOINTS;
+                    return;
+                }
+            }
+            Error(*member, Path(path, "PotLocation"), "must be either Actuators, Joints or undefined");
+        }
+
+        void VelocityEstimator(const Json::Value & object, const std::string & path,
+                               osaVelocityEstimator1394::Type & estimator) {
+            const Json::Value * member = Member(object, path, "Estimator", false);
+            if (!member) {
+                return;
+            }
+            // format used by cisst serialization first
+            try {
+                cmnDataJSON<osaVelocityEstimator1394::Type>::DeSerializeText(estimator, *member);
+                return;
+            } catch (...) {
+            }
+            // then names used in XML files
+            if (member->isString()) {
+                const std::string name = member->asString();
+                if (name == "FPGA") {
+                    estimator = osaVelocityEstimator1394::VELOCITY_FPGA;
+                    return;
+                }
+                if (name == "FiniteDifference") {
+                    estimator = osaVelocityEstimator1394::VELOCITY_FINITE_DIFFERENCE;
+                    return;
+                }
+                if (name == "LeastSquares") {
+                    estimator = osaVelocityEstimator1394::VELOCITY_LEAST_SQUARES;
+                    return;
+                }
+                if (name == "Observer") {
+                    estimator = osaVelocityEstimator1394::VELOCITY_OBSERVER;
+                    return;
+                }
+            }
+            Error(*member, Path(path, "Estimator"), "must be FPGA, FiniteDifference, LeastSquares or Observer");
+        }
+
+    protected:
+        std::string mFilename;
+        std::vector<size_t> mLineStarts;
+        size_t mNumberOfErrors;
+    };
+
+
+    static void osaJSON1394ConfigureDrive(osaJSON1394Reader & reader,
+                                          const Json::Value & drive, const std::string & path,
+                                          osaDrive1394Configuration & result,
+                                          const bool effortRequired)
+    {
+        reader.CheckMembers(drive, path, {"EffortToCurrent", "CurrentToBits", "BitsToCurrent",
+                    "EffortCommandLimit", "CurrentCommandLimit"});
+        reader.LinearFunction(drive, path, "EffortToCurrent", result.EffortToCurrent, effortRequired);
+        reader.LinearFunction(drive, path, "CurrentToBits", result.CurrentToBits, true);
+        reader.LinearFunction(drive, path, "BitsToCurrent", result.BitsToCurrent, true);
+        result.EffortCommandLimit = 0.0;
+        reader.Get(drive, path, "EffortCommandLimit", result.EffortCommandLimit, false);
+        reader.Get(drive, path, "CurrentCommandLimit", result.CurrentCommandLimit);
+    }
+
+
+    static void osaJSON1394ConfigureBrake(osaJSON1394Reader & reader,
+                                          const Json::Value & brake, const std::string & path,
+                                          osaAnalogBrake1394Configuration & result)
+    {
+        reader.CheckMembers(brake, path, {"BoardID", "AxisID", "Drive", "ReleaseCurrent",
+                    "ReleaseTime", "ReleasedCurrent", "EngagedCurrent"});
+        reader.GetIndex(brake, path, "BoardID", result.BoardID, MAX_BOARDS);
+        reader.GetIndex(brake, path, "AxisID", result.AxisID, MAX_AXES);
+        const Json::Value * drive = reader.Member(brake, path, "Drive", true);
+        if (drive && reader.IsObject(*drive, reader.Path(path, "Drive"))) {
+            osaJSON1394ConfigureDrive(reader, *drive, reader.Path(path, "Drive"), result.Drive, false);
+        }
+        reader.Get(brake, path, "ReleaseCurrent", result.ReleaseCurrent);
+        reader.Get(brake, path, "ReleaseTime", result.ReleaseTime);
+        reader.Get(brake, path, "ReleasedCurrent", result.ReleasedCurrent);
+        reader.Get(brake, path, "EngagedCurrent", result.EngagedCurrent);
+    }
+
+
+    static void osaJSON1394ConfigureActuator(osaJSON1394Reader & reader,
+                                             const Json::Value & actuator, const std::string & path,
+                                             const bool onlyIO,
+                                             osaActuator1394Configuration & result)
+    {
+        reader.CheckMembers(actuator, path, {"BoardID", "AxisID", "JointType",
+                    "Drive", "Encoder", "Pot", "Brake"});
+        reader.GetIndex(actuator, path, "BoardID", result.BoardID, MAX_BOARDS);
+        reader.GetIndex(actuator, path, "AxisID", result.AxisID, MAX_AXES);
+        reader.JointType(actuator, path, result.JointType);
+
+        // drive
+        const std::string drivePath = reader.Path(path, "Drive");
+        const Json::Value * drive = reader.Member(actuator, path, "Drive", true);
+        if (drive && reader.IsObject(*drive, drivePath)) {
+            osaJSON1394ConfigureDrive(reader, *drive, drivePath, result.Drive, !onlyIO);
+        }
+
+        // encoder
+        const std::string encoderPath = reader.Path(path, "Encoder");
+        const Json::Value * encoder = reader.Member(actuator, path, "Encoder", !onlyIO);
+        if (encoder && reader.IsObject(*encoder, encoderPath)) {
+            reader.CheckMembers(*encoder, encoderPath, {"BitsToPosition", "Velocity"});
+            reader.LinearFunction(*encoder, encoderPath, "BitsToPosition",
+                                  result.Encoder.BitsToPosition, !onlyIO);
+            if (!onlyIO) {
+                reader.Unit(*encoder, encoderPath, "BitsToPosition",
+                            result.Encoder.BitsToPosition, result.JointType);
+            }
+            // software velocity estimation, optional
+            const std::string velocityPath = reader.Path(encoderPath, "Velocity");
+            const Json::Value * velocity = reader.Member(*encoder, encoderPath, "Velocity", false);
+            if (velocity && reader.IsObject(*velocity, velocityPath)) {
+                reader.CheckMembers(*velocity, velocityPath, {"Estimator", "Window", "Bandwidth"});
+                reader.VelocityEstimator(*velocity, velocityPath, result.Encoder.VelocityEstimator);
+                if (reader.Get(*velocity, velocityPath, "Window", result.Encoder.VelocityWindow, false)
+                    && ((result.Encoder.VelocityWindow < 2)
+                        || (result.Encoder.VelocityWindow > MAX_VELOCITY_WINDOW))) {
+                    reader.Error((*velocity)["Window"], reader.Path(velocityPath, "Window"),
+                                 "must be between 2 and " + std::to_string(MAX_VELOCITY_WINDOW));
+                }
+                if (reader.Get(*velocity, velocityPath, "Bandwidth", result.Encoder.VelocityBandwidth, false)
+                    && (result.Encoder.VelocityBandwidth <= 0.0)) {
+                    reader.Error((*velocity)["Bandwidth"], reader.Path(velocityPath, "Bandwidth"),
+                                 "must be positive");
+                }
+            }
+        }
+        if (onlyIO) {
+            result.Encoder.BitsToPosition.Scale = 0.0;
+        }
+
+        // potentiometer
+        const std::string potPath = reader.Path(path, "Pot");
+        const Json::Value * pot = reader.Member(actuator, path, "Pot", true);
+        if (pot && reader.IsObject(*pot, potPath)) {
+            reader.CheckMembers(*pot, potPath, {"BitsToVoltage", "VoltageToPosition"});
+            reader.LinearFunction(*pot, potPath, "BitsToVoltage",
+                                  result.Pot.BitsToVoltage, true);
+            reader.LinearFunction(*pot, potPath, "VoltageToPosition",
+                                  result.Pot.VoltageToPosition, !onlyIO);
+            if (!onlyIO) {
+                reader.Unit(*pot, potPath, "VoltageToPosition",
+                            result.Pot.VoltageToPosition, result.JointType);
+            }
+        }
+
+        // brake, optional
+        result.Brake = 0;
+        const Json::Value * brake = reader.Member(actuator, path, "Brake", false);
+        const std::string brakePath = reader.Path(path, "Brake");
+        if (brake && reader.IsObject(*brake, brakePath)) {
+            result.Brake = new osaAnalogBrake1394Configuration;
+            osaJSON1394ConfigureBrake(reader, *brake, brakePath, *(result.Brake));
+        }
+    }
+
+
+    static void osaJSON1394ConfigureCoupling(osaJSON1394Reader & reader,
+                                             const Json::Value & robot, const std::string & path,
+                                             osaRobot1394Configuration & result)
+    {
+        const size_t nbActuators = result.NumberOfActuators;
+        const size_t nbJoints = result.NumberOfJoints;
+        prmActuatorJointCoupling & coupling = result.Coupling;
+        const Json::Value * jsonCoupling = reader.Member(robot, path, "Coupling", result.HasActuatorToJointCoupling);
+        if (!jsonCoupling) {
+            return;
+        }
+        const std::string couplingPath = reader.Path(path, "Coupling");
+        if (!reader.IsObject(*jsonCoupling, couplingPath)) {
+            return;
+        }
+        const size_t numberOfErrors = reader.NumberOfErrors();
+        reader.Matrix(*jsonCoupling, couplingPath, "ActuatorToJointPosition",
+                      nbJoints, nbActuators, coupling.ActuatorToJointPosition());
+        reader.Matrix(*jsonCoupling, couplingPath, "JointToActuatorPosition",
+                      nbActuators, nbJoints, coupling.JointToActuatorPosition());
+        reader.Matrix(*jsonCoupling, couplingPath, "ActuatorToJointEffort",
+                      nbJoints, nbActuators, coupling.ActuatorToJointEffort());
+        reader.Matrix(*jsonCoupling, couplingPath, "JointToActuatorEffort",
+                      nbActuators, nbJoints, coupling.JointToActuatorEffort());
+        if (!result.HasActuatorToJointCoupling
+            || (reader.NumberOfErrors() != numberOfErrors)) {
+            return;
+        }
+
+        // same rules as XML, compute missing matrices
+        if (coupling.ActuatorToJointPosition().size() == 0) {
+            reader.Error(*jsonCoupling, couplingPath, "\"ActuatorToJointPosition\" is required when HasActuatorToJointCoupling is true");
+            return;
+        }
+        if (coupling.JointToActuatorPosition().size() == 0) {
+            coupling.JointToActuatorPosition().ForceAssign(coupling.ActuatorToJointPosition());
+            nmrInverse(coupling.JointToActuatorPosition());
+        }
+        if (coupling.ActuatorToJointEffort().size() == 0) {
+            coupling.ActuatorToJointEffort().ForceAssign(coupling.JointToActuatorPosition().Transpose());
+        }
+        if (coupling.JointToActuatorEffort().size() == 0) {
+            coupling.JointToActuatorEffort().ForceAssign(coupling.ActuatorToJointEffort());
+            nmrInverse(coupling.JointToActuatorEffort());
+        }
+
+        // make sure the coupling matrices make sense
+        vctDoubleMat product, identity;
+        identity.ForceAssign(vctDoubleMat::Eye(nbActuators));
+        product.SetSize(nbActuators, nbActuators);
+        product.ProductOf(coupling.ActuatorToJointPosition(), coupling.JointToActuatorPosition());
+        if (!product.AlmostEqual(identity, 0.001)) {
+            reader.Error(*jsonCoupling, couplingPath, "product of position coupling matrices not identity");
+        }
+        product.ProductOf(coupling.ActuatorToJointEffort(), coupling.JointToActuatorEffort());
+        if (!product.AlmostEqual(identity, 0.001)) {
+            reader.Error(*jsonCoupling, couplingPath, "product of torque coupling matrices not identity");
+        }
+    }
+
+
+    static void osaJSON1394ConfigureRobot(osaJSON1394Reader & reader,
+                                          const Json::Value & robot, const std::string & path,
+                                          osaRobot1394Configuration & result)
+    {
+        reader.CheckMembers(robot, path, {"Name", "NumberOfActuators", "NumberOfJoints", "SerialNumber",
+                    "NumberOfBrakes", "OnlyIO", "HasActuatorToJointCoupling",
+                    "PotLocation", "PotTolerances", "Actuators", "Coupling", "RateDivisor",
+                    "AccelerationCompensatedVelocity"});
+        reader.Get(robot, path, "Name", result.Name);
+        reader.Get(robot, path, "NumberOfActuators", result.NumberOfActuators);
+        reader.Get(robot, path, "NumberOfJoints", result.NumberOfJoints);
+        result.SerialNumber = 0;
+        reader.Get(robot, path, "SerialNumber", result.SerialNumber, false);
+        result.OnlyIO = false;
+        reader.Get(robot, path, "OnlyIO", result.OnlyIO, false);
+        result.HasActuatorToJointCoupling = false;
+        reader.Get(robot, path, "HasActuatorToJointCoupling", result.HasActuatorToJointCoupling, false);
+        reader.RateDivisor(robot, path, result.RateDivisor);
+        if ((result.RateDivisor > 1) && !result.OnlyIO) {
+            // safety checks (encoder/pot, currents, watchdog) must run every cycle
+            reader.Error(robot["RateDivisor"], reader.Path(path, "RateDivisor"), "can only be greater than 1 for OnlyIO robots");
+        }
+        result.AccelerationCompensatedVelocity = false;
+        reader.Get(robot, path, "AccelerationCompensatedVelocity", result.AccelerationCompensatedVelocity, false);
+
+        if ((result.NumberOfActuators < 0) || (result.NumberOfJoints < 0)) {
+            reader.Error(robot, path, "number of actuators and joints can't be negative");
+            return;
+        }
+
+        // actuators
+        const std::string actuatorsPath = reader.Path(path, "Actuators");
+        const Json::Value * actuators = reader.Member(robot, path, "Actuators", true);
+        if (actuators && reader.IsArray(*actuators, actuatorsPath)) {
+            if (actuators->size() != static_cast<Json::ArrayIndex>(result.NumberOfActuators)) {
+                std::ostringstream message;
+                message << "must have NumberOfActuators (" << result.NumberOfActuators
+                        << ") elements, found " << actuators->size();
+                reader.Error(*actuators, actuatorsPath, message.str());
+            }
+            for (Json::ArrayIndex index = 0; index < actuators->size(); ++index) {
+                const std::string actuatorPath = reader.Path(actuatorsPath, index);
+                if (!reader.IsObject((*actuators)[index], actuatorPath)) {
+                    continue;
+                }
+                osaActuator1394Configuration actuator;
+                osaJSON1394ConfigureActuator(reader, (*actuators)[index], actuatorPath,
+                                             result.OnlyIO, actuator);
+                result.Actuators.push_back(actuator);
+            }
+        }
+
+        // number of brakes is always computed
+        result.NumberOfBrakes = 0;
+        for (const auto & actuator : result.Actuators) {
+            if (actuator.Brake) {
+                result.NumberOfBrakes++;
+            }
+        }
+        int numberOfBrakes;
+        if (reader.Get(robot, path, "NumberOfBrakes", numberOfBrakes, false)
+            && (numberOfBrakes != result.NumberOfBrakes)) {
+            std::ostringstream message;
+            message << "found " << result.NumberOfBrakes << " actuator(s) with a Brake";
+            reader.Error(robot["NumberOfBrakes"], reader.Path(path, "NumberOfBrakes"), message.str());
+        }
+
+        // verify that all amps offsets are different from each other
+        if (result.Actuators.size() > 2) {
+            bool allEqual = true;
+            const double defaultOffset = result.Actuators[0].Drive.CurrentToBits.Offset;
+            for (size_t index = 1; index < result.Actuators.size(); ++index) {
+                if (result.Actuators[index].Drive.CurrentToBits.Offset != defaultOffset) {
+                    allEqual = false;
+                }
+            }
+            if (allEqual) {
+                CMN_LOG_INIT_ERROR << "All offsets equal, it is very unlikely that the current calibration has been performed for this arm:"
+                                   << "  " << result.Name << std::endl;
+            }
+        }
+
+        // potentiometers
+        reader.PotLocation(robot, path, result.PotLocation);
+        if ((result.PotLocation == osaPot1394Location::POTENTIOMETER_ON_ACTUATORS)
+            || (result.PotLocation == osaPot1394Location::POTENTIOMETER_ON_JOINTS)) {
+            const size_t numberOfPots =
+                (result.PotLocation == osaPot1394Location::POTENTIOMETER_ON_ACTUATORS) ?
+                result.NumberOfActuators : result.NumberOfJoints;
+            const std::string tolerancesPath = reader.Path(path, "PotTolerances");
+            const Json::Value * tolerances = reader.Member(robot, path, "PotTolerances", true);
+            if (tolerances && reader.IsArray(*tolerances, tolerancesPath)) {
+                if (tolerances->size() != numberOfPots) {
+                    std::ostringstream message;
+                    message << "must have " << numberOfPots << " elements, found " << tolerances->size();
+                    reader.Error(*tolerances, tolerancesPath, message.str());
+                }
+                for (Json::ArrayIndex index = 0; index < tolerances->size(); ++index) {
+                    const Json::Value & tolerance = (*tolerances)[index];
+                    const std::string tolerancePath = reader.Path(tolerancesPath, index);
+                    if (!reader.IsObject(tolerance, tolerancePath)) {
+                        continue;
+                    }
+                    reader.CheckMembers(tolerance, tolerancePath, {"AxisID", "Distance", "Latency"});
+                    osaPotTolerance1394Configuration pot;
+                    pot.AxisID = index;
+                    pot.Distance = 0.0;
+                    pot.Latency = 0.0;
+                    reader.Get(tolerance, tolerancePath, "Distance", pot.Distance, false);
+                    reader.Get(tolerance, tolerancePath, "Latency", pot.Latency, false);
+                    if ((pot.Distance == 0.0) || (pot.Latency == 0.0)) {
+                        reader.Warning(tolerance, tolerancePath,
+                                       "potentiometer to encoder latency and/or distance set to zero, safety check is DISABLED");
+                    } else {
+                        // tolerances must be provided in order
+                        reader.Get(tolerance, tolerancePath, "AxisID", pot.AxisID);
+                        if (pot.AxisID != static_cast<int>(index)) {
+                            reader.Error(tolerance, reader.Path(tolerancePath, "AxisID"),
+                                         "tolerances must be provided in order, AxisID doesn't match index");
+                        }
+                    }
+                    result.PotTolerances.push_back(pot);
+                }
+            }
+        }
+
+        // coupling
+        osaJSON1394ConfigureCoupling(reader, robot, path, result);
+    }
+
+
+    static void osaJSON1394ConfigureDigitalInput(osaJSON1394Reader & reader,
+                                                 const Json::Value & input, const std::string & path,
+                                                 osaDigitalInput1394Configuration & result)
+    {
+        reader.CheckMembers(input, path, {"Name", "BoardID", "BitID", "TriggerWhenPressed",
+                    "TriggerWhenReleased", "PressedValue", "DebounceThreshold",
+                    "DebounceThresholdClick", "RateDivisor"});
+        reader.Get(input, path, "Name", result.Name);
+        reader.GetIndex(input, path, "BoardID", result.BoardID, MAX_BOARDS);
+        reader.Get(input, path, "BitID", result.BitID);
+        result.TriggerWhenPressed = false;
+        reader.Get(input, path, "TriggerWhenPressed", result.TriggerWhenPressed, false);
+        result.TriggerWhenReleased = false;
+        reader.Get(input, path, "TriggerWhenReleased", result.TriggerWhenReleased, false);
+        result.PressedValue = false;
+        reader.Get(input, path, "PressedValue", result.PressedValue, false);
+        result.DebounceThreshold = 0.0;
+        if (reader.Get(input, path, "DebounceThreshold", result.DebounceThreshold, false)
+            && (result.DebounceThreshold < 0.0)) {
+            reader.Error(input["DebounceThreshold"], reader.Path(path, "DebounceThreshold"),
+                         "can't be negative");
+        }
+        result.DebounceThresholdClick = 0.0;
+        if (reader.Get(input, path, "DebounceThresholdClick", result.DebounceThresholdClick, false)
+            && ((result.DebounceThresholdClick < 0.0)
+                || (result.DebounceThresholdClick > result.DebounceThreshold))) {
+            reader.Error(input["DebounceThresholdClick"], reader.Path(path, "DebounceThresholdClick"),
+                         "can't be negative or greater than DebounceThreshold");
+        }
+        reader.RateDivisor(input, path, result.RateDivisor);
+    }
+
+
+    static void osaJSON1394ConfigureDigitalOutput(osaJSON1394Reader & reader,
+                                                  const Json::Value & output, const std::string & path,
+                                                  osaDigitalOutput1394Configuration & result)
+    {
+        reader.CheckMembers(output, path, {"Name", "BoardID", "BitID", "HighDuration",
+                    "LowDuration", "IsPWM", "PWMFrequency", "RateDivisor"});
+        reader.Get(output, path, "Name", result.Name);
+        reader.GetIndex(output, path, "BoardID", result.BoardID, MAX_BOARDS);
+        reader.Get(output, path, "BitID", result.BitID);
+        result.HighDuration = 0.0;
+        reader.Get(output, path, "HighDuration", result.HighDuration, false);
+        result.LowDuration = 0.0;
+        reader.Get(output, path, "LowDuration", result.LowDuration, false);
+        result.IsPWM = false;
+        reader.Get(output, path, "IsPWM", result.IsPWM, false);
+        result.PWMFrequency = 0.0;
+        reader.Get(output, path, "PWMFrequency", result.PWMFrequency, result.IsPWM);
+        reader.RateDivisor(output, path, result.RateDivisor);
+    }
+
+
+    static void osaJSON1394ConfigureDallasChip(osaJSON1394Reader & reader,
+                                               const Json::Value & dallas, const std::string & path,
+                                               osaDallasChip1394Configuration & result)
+    {
+        reader.CheckMembers(dallas, path, {"Name", "BoardID", "RateDivisor"});
+        reader.Get(dallas, path, "Name", result.Name);
+        reader.GetIndex(dallas, path, "BoardID", result.BoardID, MAX_BOARDS);
+        reader.RateDivisor(dallas, path, result.RateDivisor);
+    }
+
+
+    // call configure method for each element of an array
+    template <typename _elementType, typename _method>
+    static void osaJSON1394ConfigureArray(osaJSON1394Reader & reader,
+                                          const Json::Value & jsonConfig, const char * key,
+                                          _method method, std::vector<_elementType> & result)
+    {
+        const Json::Value * elements = reader.Member(jsonConfig, "", key, false);
+        if (!elements || !reader.IsArray(*elements, key)) {
+            return;
+        }
+        for (Json::ArrayIndex index = 0; index < elements->size(); ++index) {
+            const std::string path = reader.Path(key, index);
+            if (!reader.IsObject((*elements)[index], path)) {
+                continue;
+            }
+            _elementType element;
+            method(reader, (*elements)[index], path, element);
+            result.push_back(element);
+        }
+    }
+
+
+    bool osaJSON1394LoadPort(const std::string & filename,
+                             osaPort1394Configuration & config)
+    {
+        std::ifstream jsonStream(filename.c_str());
+        if (!jsonStream.good()) {
+            CMN_LOG_INIT_ERROR << "osaJSON1394LoadPort: failed to open file \""
+                               << filename << "\"" << std::endl;
+            return false;
+        }
+        std::stringstream buffer;
+        buffer << jsonStream.rdbuf();
+        const std::string document = buffer.str();
+
+        // parse, syntax errors include line and column
+        Json::Value jsonConfig;
+        Json::Reader jsonReader;
+        if (!jsonReader.parse(document, jsonConfig, false)) {
+            CMN_LOG_INIT_ERROR << "osaJSON1394LoadPort: failed to parse file \""
+                               << filename << "\"" << std::endl
+                               << jsonReader.getFormattedErrorMessages();
+            return false;
+        }
+
+        // validate and convert
+        osaJSON1394Reader reader(filename, document);
+        if (reader.IsObject(jsonConfig, "")) {
+            reader.CheckMembers(jsonConfig, "", {"Robots", "DigitalInputs", "DigitalOutputs", "DallasChips"});
+            osaJSON1394ConfigureArray(reader, jsonConfig, "Robots",
+                                      osaJSON1394ConfigureRobot, config.Robots);
+            osaJSON1394ConfigureArray(reader, jsonConfig, "DigitalInputs",
+                                      osaJSON1394ConfigureDigitalInput, config.DigitalInputs);
+            osaJSON1394ConfigureArray(reader, jsonConfig, "DigitalOutputs",
+                                      osaJSON1394ConfigureDigitalOutput, config.DigitalOutputs);
+            osaJSON1394ConfigureArray(reader, jsonConfig, "DallasChips",
+                                      osaJSON1394ConfigureDallasChip, config.DallasChips);
+            if ((config.Robots.size() + config.DigitalInputs.size()
+                 + config.DigitalOutputs.size() + config.DallasChips.size()) == 0) {
+                reader.Error(jsonConfig, "", "doesn't contain any Robots, DigitalInputs, DigitalOutputs or DallasChips");
+            }
+        }
+
+        if (reader.NumberOfErrors() != 0) {
+            CMN_LOG_INIT_ERROR << "osaJSON1394LoadPort: found " << reader.NumberOfErrors()
+                               << " error(s) in file \"" << filename << "\"" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void osaJSON1394ConfigurePort(const std::string & filename,
+                                  osaPort1394Configuration & config)
+    {
+        if (!osaJSON1394LoadPort(filename, config)) {
+            exit(EXIT_FAILURE);
+        }
+    }
+
+
+    void osaJSON1394SerializePort(const osaPort1394Configuration & config,
+                                  Json::Value & jsonConfig)
+    {
+        config.SerializeTextJSON(jsonConfig);
+        // add brakes
+        for (Json::ArrayIndex robotIndex = 0; robotIndex < config.Robots.size(); ++robotIndex) {
+            const osaRobot1394Configuration & robot = config.Robots.at(robotIndex);
+            for (Json::ArrayIndex actuatorIndex = 0; actuatorIndex < robot.Actuators.size(); ++actuatorIndex) {
+                const osaAnalogBrake1394Configuration * brake = robot.Actuators.at(actuatorIndex).Brake;
+                if (brake) {
+                    brake->SerializeTextJSON(jsonConfig["Robots"][robotIndex]["Actuators"][actuatorIndex]["Brake"]);
+                }
+            }
+        }
+    }
+
+} // namespace sawRobotIO1394
@@ -0,0 +1,56 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  Author(s):  Anton Deguet
+  Created on: 2021-07-06
+
+  (C) Copyright 2021 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#include <sawRobotIO1394/osaTimeHistogram1394.h>
+
+using namespace sawRobotIO1394;
+
+osaTimeHistogram1394::osaTimeHistogram1394(const double binWidth,
+                                           const size_t numberOfBins)
+{
+    SetBins(binWidth, numberOfBins);
+}
+
+void osaTimeHistogram1394::SetBins(const double binWidth, const size_t numberOfBins)
+{
+    mBinWidth = binWidth;
+    mRange = binWidth * numberOfBins;
+    mOverflowBin = numberOfBins;
+    mCounts.SetSize(numberOfBins + 1);
+    Reset();
+}
+
+void osaTimeHistogram1394::Reset(void)
+{
+    mCounts.SetAll(0);
+}
+
+void osaTimeHistogram1394::ToStream(std::ostream & outputStream) const
+{
+    for (size_t bin = 0; bin < mOverflowBin; ++bin) {
+        if (mCounts.Element(bin) != 0) {
+            outputStream << "[" << bin * mBinWidth * 1000.0 << ", "
+                         << (bin + 1) * mBinWidth * 1000.0 << "[ ms: "
+                         << mCounts.Element(bin) << std::endl;
+        }
+    }
+    if (mCounts.Element(mOverflowBin) != 0) {
+        outputStream << ">= " << mRange * 1000.0 << " ms: "
+                     << mCounts.Element(mOverflowBin) << std::endl;
+    }
+}
@@ -0,0 +1,220 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  Author(s):  Anton Deguet
+  Created on: 2021-07-21
+
+  (C) Copyright 2021 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <cisstCommon/cmnLogger.h>
+#include <cisstOSAbstraction/osaGetTime.h>
+#include <sawRobotIO1394/osaTrace1394.h>
+
+using namespace sawRobotIO1394;
+
+std::atomic<bool> osaTrace1394::mEnabled(false);
+
+namespace {
+
+    struct Event {
+        const char * Name;
+        double Time;
+        char Phase;
+    };
+
+    // written by a single thread, read by Save.  Events are only
+    // allocated once tracing is enabled
+    struct Buffer {
+        Buffer(const size_t id):
+            Id(id),
+            Head(0),
+            Start(0)
+        {}
+        void Allocate(void) {
+            if (Events.empty()) {
+                Events.resize(osaTrace1394::BUFFER_SIZE);
+            }
+        }
+        size_t Id;
+        std::string Name;
+        std::vector<Event> Events;
+        std::atomic<size_t> Head;  // total number of events written
+        std::atomic<size_t> Start; // first event to save, set by Clear
+    };
+
+    // buffers are never released so events of threads already
+    // stopped can still be saved
+    std::mutex BuffersMutex;
+    std::vector<std::unique_ptr<Buffer> > Buffers;
+    thread_local Buffer * ThreadBuffer = nullptr;
+
+    // BuffersMutex must be locked
+    Buffer * RegisterThread(void)
+    {
+        if (!ThreadBuffer) {
+            Buffers.emplace_back(new Buffer(Buffers.size() + 1));
+            ThreadBuffer = Buffers.back().get();
+            ThreadBuffer->Name = "thread " + std::to_string(ThreadBuffer->Id);
+        }
+        return ThreadBuffer;
+    }
+
+    // copy of a thread events, used to write the file without
+    // holding BuffersMutex
+    struct Snapshot {
+        size_t Id;
+        std::string Name;
+        std::vector<Event> Events;
+    };
+
+    void WriteString(std::ostream & output, const std::string & value)
+    {
+        output << '"';
+        for (const char c : value) {
+            if ((c == '"') || (c == '\\')) {
+                output << '\\';
+            }
+            output << c;
+        }
+        output << '"';
+    }
+}
+
+void osaTrace1394::Enable(const bool enable)
+{
+    // allocate buffers of known threads before any of them can add
+    // events
+    std::lock_guard<std::mutex> lock(BuffersMutex);
+    if (enable) {
+        for (auto & buffer : Buffers) {
+            buffer->Allocate();
+        }
+    }
+    mEnabled.store(enable, std::memory_order_release);
+}
+
+void osaTrace1394::SetThreadName(const std::string & name)
+{
+    std::lock_guard<std::mutex> lock(BuffersMutex);
+    Buffer * buffer = RegisterThread();
+    buffer->Name = name;
+    if (Enabled()) {
+        buffer->Allocate();
+    }
+}
+
+void osaTrace1394::Add(const char * name, const char phase)
+{
+    Buffer * buffer = ThreadBuffer;
+    if (!buffer) {
+        std::lock_guard<std::mutex> lock(BuffersMutex);
+        buffer = RegisterThread();
+        buffer->Allocate();
+    }
+    const size_t head = buffer->Head.load(std::memory_order_relaxed);
+    Event & event = buffer->Events[head % BUFFER_SIZE];
+    event.Name = name;
+    event.Time = osaGetTime();
+    event.Phase = phase;
+    buffer->Head.store(head + 1, std::memory_order_release);
+}
+
+void osaTrace1394::Clear(void)
+{
+    std::lock_guard<std::mutex> lock(BuffersMutex);
+    for (auto & buffer : Buffers) {
+        buffer->Start = buffer->Head.load(std::memory_order_acquire);
+    }
+}
+
+bool osaTrace1394::Save(const std::string & fileName)
+{
+    std::ofstream file(fileName.c_str());
+    if (!file.is_open()) {
+        CMN_LOG_RUN_ERROR << "osaTrace1394::Save: failed to open \"" << fileName << "\"" << std::endl;
+        return false;
+    }
+
+    // copy events under lock, then write the file without blocking
+    // threads starting or setting their names
+    std::vector<Snapshot> snapshots;
+    {
+        std::lock_guard<std::mutex> lock(BuffersMutex);
+        snapshots.resize(Buffers.size());
+        for (size_t bufferIndex = 0; bufferIndex < Buffers.size(); ++bufferIndex) {
+            const Buffer & buffer = *(Buffers[bufferIndex]);
+            Snapshot & snapshot = snapshots[bufferIndex];
+            snapshot.Id = buffer.Id;
+            snapshot.Name = buffer.Name;
+            if (buffer.Events.empty()) {
+                continue;
+            }
+            // copy events, then drop the ones the thread might have
+            // overwritten during the copy
+            const size_t head = buffer.Head.load(std::memory_order_acquire);
+            size_t begin = buffer.Start;
+            if (head - begin > BUFFER_SIZE) {
+                begin = head - BUFFER_SIZE;
+            }
+            snapshot.Events.reserve(head - begin);
+            for (size_t index = begin; index < head; ++index) {
+                snapshot.Events.push_back(buffer.Events[index % BUFFER_SIZE]);
+            }
+            const size_t newHead = buffer.Head.load(std::memory_order_acquire);
+            const size_t firstValid = (newHead - begin >= BUFFER_SIZE) ? (newHead - BUFFER_SIZE + 1) : begin;
+            if (firstValid > begin) {
+                snapshot.Events.erase(snapshot.Events.begin(),
+                                      snapshot.Events.begin() + std::min(firstValid - begin, head - begin));
+            }
+        }
+    }
+
+    size_t numberOfEvents = 0;
+    bool first = true;
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl
+         << std::fixed << std::setprecision(3);
+    for (const auto & snapshot : snapshots) {
+        // thread name
+        if (!first) {
+            file << "," << std::endl;
+        }
+        first = false;
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << snapshot.Id
+             << ",\"args\":{\"name\":";
+        WriteString(file, snapshot.Name);
+        file << "}}";
+
+        for (const auto & event : snapshot.Events) {
+            file << "," << std::endl
+                 << "{\"name\":";
+            WriteString(file, event.Name);
+            file << ",\"ph\":\"" << event.Phase
+                 << "\",\"pid\":1,\"tid\":" << snapshot.Id
+                 << ",\"ts\":" << event.Time * 1.0e6 << "}";
+            numberOfEvents++;
+        }
+    }
+    file << std::endl << "]}" << std::endl;
+    file.close();
+
+    CMN_LOG_RUN_VERBOSE << "osaTrace1394::Save: saved " << numberOfEvents << " events in \""
+                        << fileName << "\"" << std::endl;
+    return true;
+}
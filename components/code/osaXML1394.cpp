@@ -21,140 +21,395 @@ http://www.cisst.org/cisst/license.txt.
 #include <cisstCommon/cmnUnits.h>
 #include <cisstNumerical/nmrInverse.h>
 
+#include <cstdlib>
+#include <sstream>
+
+#ifdef sawRobotIO1394_HAS_LIBXML2
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+#endif
+
 namespace sawRobotIO1394 {
 
-    void osaXML1394ConfigurePort(const std::string & filename, osaPort1394Configuration & config)
+    // The parsing code below is written once against a "node" type.
+    // Two node types are provided:
+    // - osaXML1394XPathNode uses cmnXMLPath, i.e. a new XPath query for each value
+    // - osaXML1394DOMNode walks the libxml2 tree directly, the document is parsed once
+    // Both keep track of the XPath-like path so error messages are the same.
+
+    class osaXML1394XPathNode
     {
-        cmnXMLPath xmlConfig;
-        xmlConfig.SetInputSource(filename);
+    public:
+        osaXML1394XPathNode(cmnXMLPath & xmlConfig, const std::string & path = ""):
+            mXMLConfig(&xmlConfig),
+            mPath(path)
+        {}
+
+        inline osaXML1394XPathNode Child(const char * name) const {
+            return osaXML1394XPathNode(*mXMLConfig, Join(name));
+        }
 
-        // get an check version number
-        int version;
-        bool versionFound = osaXML1394GetValue(xmlConfig, "Config", "@Version", version);
-        if (!versionFound) {
-            CMN_LOG_INIT_ERROR << "Configure: Config/Version is missing in file: "
-                               << filename << std::endl
-                               << "Make sure you generate your XML files with the latest config generator." << std::endl;
-            exit(EXIT_FAILURE);
-            return;
-        } else {
-            const int minimumVersion = 4; // backward compatibility
-            if (version < minimumVersion) {
-                CMN_LOG_INIT_ERROR << "Configure: Config/Version must be at least " << minimumVersion
-                                   << ", version found is " << version << std::endl
-                                   << "File: " << filename << std::endl
-                                   << "Make sure you generate your XML files with the latest config generator." << std::endl;
-                exit(EXIT_FAILURE);
-                return;
-            }
-            const int currentVersion = 4;
-            if (version > currentVersion) {
-                CMN_LOG_INIT_ERROR << "Configure: current Config/Version is " << currentVersion
-                                   << ", version found is " << version << ", you might want to upgrade your code" << std::endl
-                                   << "File: " << filename << std::endl
-                                   << "Make sure you generate your XML files with the latest config generator." << std::endl;
+        inline osaXML1394XPathNode Child(const char * name, const int index) const {
+            std::ostringstream path;
+            path << Join(name) << '[' << index << ']';
+            return osaXML1394XPathNode(*mXMLConfig, path.str());
+        }
+
+        inline int Count(const char * name) const {
+            int count = 0;
+            mXMLConfig->GetXMLValue("", ("count(/Config/" + Join(name) + ")").c_str(), count);
+            return count;
+        }
+
+        inline bool Exists(void) const {
+            return mXMLConfig->Exists("Config/" + mPath);
+        }
+
+        template <typename _elementType>
+        inline bool Get(const char * attribute, _elementType & value) const {
+            return mXMLConfig->GetXMLValue("Config", AttributePath(attribute).c_str(), value);
+        }
+
+        inline std::string AttributePath(const char * attribute) const {
+            return Join(std::string("@") + attribute);
+        }
+
+        inline const std::string & Path(void) const {
+            return mPath;
+        }
+
+    protected:
+        inline std::string Join(const std::string & name) const {
+            return mPath.empty() ? name : mPath + '/' + name;
+        }
+
+        cmnXMLPath * mXMLConfig;
+        std::string mPath;
+    };
+
+
+#ifdef sawRobotIO1394_HAS_LIBXML2
+    class osaXML1394DOMNode
+    {
+    public:
+        osaXML1394DOMNode(xmlNode * node, const std::string & path = ""):
+            mNode(node),
+            mPath(path)
+        {}
+
+        inline osaXML1394DOMNode Child(const char * name) const {
+            return osaXML1394DOMNode(FindChild(name, 1), Join(name));
+        }
+
+        inline osaXML1394DOMNode Child(const char * name, const int index) const {
+            std::ostringstream path;
+            path << Join(name) << '[' << index << ']';
+            return osaXML1394DOMNode(FindChild(name, index), path.str());
+        }
+
+        inline int Count(const char * name) const {
+            int count = 0;
+            if (mNode) {
+                for (xmlNode * child = mNode->children; child; child = child->next) {
+                    if (Is(child, name)) {
+                        ++count;
+                    }
+                }
             }
+            return count;
         }
 
-        // Get the number of robot elements
-        int numRobots = 0;
-        xmlConfig.GetXMLValue("", "count(/Config/Robot)", numRobots);
+        inline bool Exists(void) const {
+            return (mNode != 0);
+        }
 
-        for (int i = 0; i < numRobots; i++) {
-            osaRobot1394Configuration robot;
+        bool Get(const char * attribute, std::string & value) const {
+            if (!mNode) {
+                return false;
+            }
+            xmlChar * text = xmlGetProp(mNode, reinterpret_cast<const xmlChar *>(attribute));
+            if (!text) {
+                return false;
+            }
+            value = reinterpret_cast<const char *>(text);
+            xmlFree(text);
+            return true;
+        }
 
-            // Store the robot in the config if it's succesfully parsed
-            if (osaXML1394ConfigureRobot(xmlConfig, i + 1, robot)) {
-                config.Robots.push_back(robot);
-            } else {
-                CMN_LOG_INIT_WARNING << "ConfigurePort: failed to configure robot from file \""
-                                     << filename << "\"" << std::endl;
-                exit(EXIT_FAILURE);
+        bool Get(const char * attribute, int & value) const {
+            std::string text;
+            if (!Get(attribute, text)) {
+                return false;
+            }
+            char * end;
+            const long result = strtol(text.c_str(), &end, 10);
+            if (!IsValidNumber(text, end)) {
+                CMN_LOG_INIT_ERROR << "osaXML1394GetValue: " << AttributePath(attribute)
+                                   << " in context Config is not a valid integer: \"" << text << "\"" << std::endl;
+                return false;
             }
+            value = static_cast<int>(result);
+            return true;
         }
 
-        // Get the number of digital input elements
-        int numDigitalInputs = 0;
-        xmlConfig.GetXMLValue("", "count(/Config/DigitalIn)", numDigitalInputs);
+        bool Get(const char * attribute, double & value) const {
+            std::string text;
+            if (!Get(attribute, text)) {
+                return false;
+            }
+            char * end;
+            const double result = strtod(text.c_str(), &end);
+            if (!IsValidNumber(text, end)) {
+                CMN_LOG_INIT_ERROR << "osaXML1394GetValue: " << AttributePath(attribute)
+                                   << " in context Config is not a valid number: \"" << text << "\"" << std::endl;
+                return false;
+            }
+            value = result;
+            return true;
+        }
 
-        for (int i = 0; i < numDigitalInputs; i++) {
-            osaDigitalInput1394Configuration digitalInput;
+        inline std::string AttributePath(const char * attribute) const {
+            return Join(std::string("@") + attribute);
+        }
 
-            // Store the digitalInput in the config if it's succesfully parsed
-            if (osaXML1394ConfigureDigitalInput(xmlConfig, i + 1, digitalInput)) {
-                config.DigitalInputs.push_back(digitalInput);
-            } else {
-                CMN_LOG_INIT_WARNING << "ConfigurePort: failed to configure digital input from file \""
-                                     << filename << "\"" << std::endl;
-                exit(EXIT_FAILURE);
+        inline const std::string & Path(void) const {
+            return mPath;
+        }
+
+    protected:
+        inline static bool Is(const xmlNode * node, const char * name) {
+            return (node->type == XML_ELEMENT_NODE)
+                && (xmlStrcmp(node->name, reinterpret_cast<const xmlChar *>(name)) == 0);
+        }
+
+        inline static bool IsValidNumber(const std::string & text, const char * end) {
+            if (end == text.c_str()) {
+                return false;
             }
+            // allow trailing spaces
+            while (*end == ' ' || *end == '\t' || *end == '\n' || *end == '\r') {
+                ++end;
+            }
+            return (*end == '\0');
         }
 
-        // Get the number of digital output elements
-        int numDigitalOutputs = 0;
-        xmlConfig.GetXMLValue("", "count(/Config/DigitalOut)", numDigitalOutputs);
+        xmlNode * FindChild(const char * name, int index) const {
+            if (!mNode) {
+                return 0;
+            }
+            for (xmlNode * child = mNode->children; child; child = child->next) {
+                if (Is(child, name)) {
+                    --index;
+                    if (index == 0) {
+                        return child;
+                    }
+                }
+            }
+            return 0;
+        }
 
-        for (int i = 0; i < numDigitalOutputs; i++) {
-            osaDigitalOutput1394Configuration digitalOutput;
+        inline std::string Join(const std::string & name) const {
+            return mPath.empty() ? name : mPath + '/' + name;
+        }
 
-            // Store the digitalOutput in the config if it's succesfully parsed
-            if (osaXML1394ConfigureDigitalOutput(xmlConfig, i + 1, digitalOutput)) {
-                config.DigitalOutputs.push_back(digitalOutput);
-            } else {
-                CMN_LOG_INIT_WARNING << "ConfigurePort: failed to configure digital output from file \""
-                                     << filename << "\"" << std::endl;
-                exit(EXIT_FAILURE);
+        xmlNode * mNode;
+        std::string mPath;
+    };
+#endif
+
+
+    template <typename _node, typename _elementType>
+    bool osaXML1394GetNodeValue(const _node & node, const char * attribute,
+                                _elementType & value, bool required = true) {
+        bool found = node.Get(attribute, value);
+        if (required && !found) {
+            CMN_LOG_INIT_ERROR << "osaXML1394GetValue: " << node.AttributePath(attribute)
+                               << " in context Config is required but not found" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+
+    template <typename _node>
+    bool osaXML1394ConfigureCouplingMatrixNode(const _node & couplingNode,
+                                               const char * couplingString,
+                                               int numRows,
+                                               int numCols,
+                                               vctDoubleMat & resultMatrix)
+    {
+        const _node matrixNode = couplingNode.Child(couplingString);
+
+        // if it doesn't exist, parsing is fine, matrix is set to size 0, 0
+        if (!matrixNode.Exists()) {
+            resultMatrix.SetSize(0.0, 0.0, 0.0);
+            return true;
+        }
+
+        resultMatrix.SetSize(numRows, numCols, 0.0);
+        vctDoubleVec row;
+        row.SetSize(numCols);
+        for (int i = 0; i < numRows; i++) {
+            const _node rowNode = matrixNode.Child("Row", i + 1);
+
+            // Get the matrix row text
+            std::string rowAsString = "";
+            rowNode.Get("Val", rowAsString);
+
+            // Convert the text to a cisstVector row
+            std::stringstream rowAsStringStream;
+            rowAsStringStream.str(rowAsString);
+
+            if (!row.FromStreamRaw(rowAsStringStream)) {
+                CMN_LOG_INIT_ERROR << "Row vector Assign failed on row " << i << ", path: " << rowNode.AttributePath("Val") << std::endl;
+                return false;
             }
+            resultMatrix.Row(i).Assign(row);
         }
+        return true;
+    }
 
-        // Get the number of Dallas chip elements
-        int numDallasChips = 0;
-        xmlConfig.GetXMLValue("", "count(/Config/DallasChip)", numDallasChips);
 
-        for (int i = 0; i < numDallasChips; i++) {
-            osaDallasChip1394Configuration dallasChip;
+    template <typename _node>
+    bool osaXML1394ConfigureCouplingNode(const _node & robotNode,
+                                         osaRobot1394Configuration & robot)
+    {
+        const _node couplingNode = robotNode.Child("Coupling");
+        //The Coupling Value must be equal to 1 for this configuration to work.
+        int coupling = 0;
+        couplingNode.Get("Value", coupling);
+        robot.HasActuatorToJointCoupling = (coupling == 1);
 
-            // Store the dallasChip in the config if it's succesfully parsed
-            if (osaXML1394ConfigureDallasChip(xmlConfig, i + 1, dallasChip)) {
-                config.DallasChips.push_back(dallasChip);
-            } else {
-                CMN_LOG_INIT_WARNING << "ConfigurePort: failed to configure Dallas chip from file \""
-                                     << filename << "\"" << std::endl;
-                exit(EXIT_FAILURE);
+        if (robot.HasActuatorToJointCoupling) {
+            bool parse_success = true;
+            parse_success &= osaXML1394ConfigureCouplingMatrixNode(couplingNode, "ActuatorToJointPosition",
+                                                                   robot.NumberOfJoints, robot.NumberOfActuators,
+                                                                   robot.Coupling.ActuatorToJointPosition());
+
+            parse_success &= osaXML1394ConfigureCouplingMatrixNode(couplingNode, "JointToActuatorPosition",
+                                                                   robot.NumberOfActuators, robot.NumberOfJoints,
+                                                                   robot.Coupling.JointToActuatorPosition());
+            if (robot.Coupling.JointToActuatorPosition().size() == 0) {
+                robot.Coupling.JointToActuatorPosition()
+                    .ForceAssign(robot.Coupling.ActuatorToJointPosition());
+                nmrInverse(robot.Coupling.JointToActuatorPosition());
+            }
+
+            parse_success &= osaXML1394ConfigureCouplingMatrixNode(couplingNode, "ActuatorToJointTorque",
+                                                                   robot.NumberOfJoints, robot.NumberOfActuators,
+                                                                   robot.Coupling.ActuatorToJointEffort());
+            if (robot.Coupling.ActuatorToJointEffort().size() == 0) {
+                robot.Coupling.ActuatorToJointEffort()
+                    .ForceAssign(robot.Coupling.JointToActuatorPosition().Transpose());
+            }
+
+            parse_success &= osaXML1394ConfigureCouplingMatrixNode(couplingNode, "JointToActuatorTorque",
+                                                                   robot.NumberOfActuators, robot.NumberOfJoints,
+                                                                   robot.Coupling.JointToActuatorEffort());
+            if (robot.Coupling.JointToActuatorEffort().size() == 0) {
+                robot.Coupling.JointToActuatorEffort()
+                    .ForceAssign(robot.Coupling.ActuatorToJointEffort());
+                nmrInverse(robot.Coupling.JointToActuatorEffort());
+            }
+
+            if (!parse_success) {
+                return false;
+            }
+
+            // make sure the coupling matrices make sense
+            vctDoubleMat product, identity;
+            identity.ForceAssign(vctDoubleMat::Eye(robot.NumberOfActuators));
+            product.SetSize(robot.NumberOfActuators, robot.NumberOfActuators);
+
+            product.ProductOf(robot.Coupling.ActuatorToJointPosition(),
+                              robot.Coupling.JointToActuatorPosition());
+
+            if (!product.AlmostEqual(identity, 0.001)) {
+                CMN_LOG_INIT_ERROR << "ConfigureCoupling: product of position coupling matrices not identity:"
+                                   << std::endl << product << std::endl;
+                return false;
+            }
+
+            product.ProductOf(robot.Coupling.ActuatorToJointEffort(),
+                              robot.Coupling.JointToActuatorEffort());
+            if (!product.AlmostEqual(identity, 0.001)) {
+                CMN_LOG_INIT_ERROR << "ConfigureCoupling: product of torque coupling matrices not identity:"
+                                   << std::endl << product << std::endl;
+                return false;
             }
+        } // has actuator coupling
+        return true;
+    }
+
+
+    // optional, device is updated every RateDivisor cycles
+    template <typename _node>
+    bool osaXML1394GetRateDivisor(const _node & node, int & rateDivisor)
+    {
+        rateDivisor = 1;
+        node.Get("RateDivisor", rateDivisor);
+        if (rateDivisor < 1) {
+            CMN_LOG_INIT_ERROR << "Configuration for " << node.AttributePath("RateDivisor")
+                               << " failed, rate divisor must be 1 or greater" << std::endl;
+            return false;
         }
+        return true;
+    }
 
-        // Check to make sure something was found
-        if ((numRobots + numDigitalInputs + numDigitalOutputs + numDallasChips) == 0) {
-            CMN_LOG_INIT_ERROR << "osaXML1394ConfigurePort: file " << filename
-                               << " doesn't contain any Config/Robot, Config/DigitalIn, Config/DigitalOut or Config/DallasChip" << std::endl;
-            exit(EXIT_FAILURE);
+
+    // optional, <Velocity Estimator="FPGA" Window="8" Bandwidth="100"/>
+    template <typename _node>
+    bool osaXML1394GetVelocityEstimator(const _node & node, osaEncoder1394Configuration & encoder)
+    {
+        std::string estimator;
+        if (node.Get("Estimator", estimator)) {
+            if (estimator == "FPGA") {
+                encoder.VelocityEstimator = osaVelocityEstimator1394::VELOCITY_FPGA;
+            } else if (estimator == "FiniteDifference") {
+                encoder.VelocityEstimator = osaVelocityEstimator1394::VELOCITY_FINITE_DIFFERENCE;
+            } else if (estimator == "LeastSquares") {
+                encoder.VelocityEstimator = osaVelocityEstimator1394::VELOCITY_LEAST_SQUARES;
+            } else if (estimator == "Observer") {
+                encoder.VelocityEstimator = osaVelocityEstimator1394::VELOCITY_OBSERVER;
+            } else {
+                CMN_LOG_INIT_ERROR << "Configuration for " << node.AttributePath("Estimator")
+                                   << " failed, must be FPGA, FiniteDifference, LeastSquares or Observer but found \""
+                                   << estimator << "\"" << std::endl;
+                return false;
+            }
         }
+        node.Get("Window", encoder.VelocityWindow);
+        if ((encoder.VelocityWindow < 2) || (encoder.VelocityWindow > MAX_VELOCITY_WINDOW)) {
+            CMN_LOG_INIT_ERROR << "Configuration for " << node.AttributePath("Window")
+                               << " failed, window must be between 2 and " << MAX_VELOCITY_WINDOW << std::endl;
+            return false;
+        }
+        node.Get("Bandwidth", encoder.VelocityBandwidth);
+        if (encoder.VelocityBandwidth <= 0.0) {
+            CMN_LOG_INIT_ERROR << "Configuration for " << node.AttributePath("Bandwidth")
+                               << " failed, bandwidth must be positive" << std::endl;
+            return false;
+        }
+        return true;
     }
 
-    bool osaXML1394ConfigureRobot(cmnXMLPath & xmlConfig,
-                                  const int robotIndex,
-                                  osaRobot1394Configuration & robot)
+
+    template <typename _node>
+    bool osaXML1394ConfigureRobotNode(const _node & robotNode,
+                                      const int robotIndex,
+                                      osaRobot1394Configuration & robot)
     {
         bool good = true;
         std::string unit;
-        char path[256];
-        const char * context = "Config";
 
         robot.NumberOfBrakes = 0;
 
-        sprintf(path, "Robot[%d]/@Name", robotIndex);
-        good &= osaXML1394GetValue(xmlConfig, context, path, robot.Name);
-
-        sprintf(path, "Robot[%d]/@NumOfActuator", robotIndex);
-        good &= osaXML1394GetValue(xmlConfig, context, path, robot.NumberOfActuators);
-
-        sprintf(path, "Robot[%d]/@NumOfJoint", robotIndex);
-        good &= osaXML1394GetValue(xmlConfig, context, path, robot.NumberOfJoints);
+        good &= osaXML1394GetNodeValue(robotNode, "Name", robot.Name);
+        good &= osaXML1394GetNodeValue(robotNode, "NumOfActuator", robot.NumberOfActuators);
+        good &= osaXML1394GetNodeValue(robotNode, "NumOfJoint", robot.NumberOfJoints);
 
         std::string type;
-        sprintf(path, "Robot[%d]/@Type", robotIndex);
-        if (xmlConfig.GetXMLValue(context, path, type)) {
+        if (robotNode.Get("Type", type)) {
             if (type == std::string("io-only")) {
                 robot.OnlyIO = true;
             } else if (type == std::string("robot")) {
@@ -169,24 +424,42 @@ namespace sawRobotIO1394 {
             robot.OnlyIO = false;
         }
 
-        sprintf(path, "Robot[%d]/@SN", robotIndex);
         robot.SerialNumber = 0;
-        good &= osaXML1394GetValue(xmlConfig, context, path, robot.SerialNumber, false); // not required
+        good &= osaXML1394GetNodeValue(robotNode, "SN", robot.SerialNumber, false); // not required
+
+        good &= osaXML1394GetRateDivisor(robotNode, robot.RateDivisor);
+        // safety checks (encoder/pot, currents, watchdog) must run every cycle
+        if ((robot.RateDivisor > 1) && !robot.OnlyIO) {
+            CMN_LOG_INIT_ERROR << "osaXML1394ConfigureRobot: " << robotNode.AttributePath("RateDivisor")
+                               << " can only be greater than 1 for io-only robots" << std::endl;
+            good = false;
+        }
+
+        // optional, requires firmware rev 6+
+        std::string accelerationCompensated;
+        robot.AccelerationCompensatedVelocity = false;
+        if (robotNode.Get("AccelerationCompensatedVelocity", accelerationCompensated)) {
+            if (accelerationCompensated == "true") {
+                robot.AccelerationCompensatedVelocity = true;
+            } else if (accelerationCompensated != "false") {
+                CMN_LOG_INIT_ERROR << "osaXML1394ConfigureRobot: " << robotNode.AttributePath("AccelerationCompensatedVelocity")
+                                   << " must be \"true\" or \"false\", not " << accelerationCompensated << std::endl;
+                good = false;
+            }
+        }
 
         for (int i = 0; i < robot.NumberOfActuators; i++) {
             osaActuator1394Configuration actuator;
-            int actuatorIndex = i + 1;
+            const _node actuatorNode = robotNode.Child("Actuator", i + 1);
 
-            sprintf(path, "Robot[%d]/Actuator[%d]/@BoardID", robotIndex, actuatorIndex);
-            good &= osaXML1394GetValue(xmlConfig, context, path, actuator.BoardID);
+            good &= osaXML1394GetNodeValue(actuatorNode, "BoardID", actuator.BoardID);
             if ((actuator.BoardID < 0) || (actuator.BoardID >= (int)MAX_BOARDS)) {
                 CMN_LOG_INIT_ERROR << "Configure: invalid board number " << actuator.BoardID
                                    << " for board " << i << std::endl;
                 return false;
             }
 
-            sprintf(path, "Robot[%d]/Actuator[%d]/@AxisID", robotIndex, actuatorIndex);
-            good &= osaXML1394GetValue(xmlConfig, context, path, actuator.AxisID);
+            good &= osaXML1394GetNodeValue(actuatorNode, "AxisID", actuator.AxisID);
             if ((actuator.AxisID < 0) || (actuator.AxisID >= (int)MAX_AXES)) {
                 CMN_LOG_INIT_ERROR << "Configure: invalid axis number " << actuator.AxisID
                                    << " for actuator " << i << std::endl;
@@ -194,8 +467,7 @@ namespace sawRobotIO1394 {
             }
 
             std::string actuatorType = "";
-            sprintf(path, "Robot[%d]/Actuator[%d]/@Type", robotIndex, actuatorIndex);
-            xmlConfig.GetXMLValue(context, path, actuatorType);
+            actuatorNode.Get("Type", actuatorType);
             if (actuatorType == "") {
                 CMN_LOG_INIT_WARNING << "Configure: no actuator type specified " << actuator.AxisID
                                      << " for actuator " << i << " set to Revolute by default" << std::endl;
@@ -208,119 +480,84 @@ namespace sawRobotIO1394 {
                 actuator.JointType = PRM_JOINT_PRISMATIC;
             }
 
-            sprintf(path, "Robot[%i]/Actuator[%d]/Drive/AmpsToBits/@Scale", robotIndex, actuatorIndex);
-            good &= osaXML1394GetValue(xmlConfig, context, path, actuator.Drive.CurrentToBits.Scale);
-
-            sprintf(path, "Robot[%i]/Actuator[%d]/Drive/AmpsToBits/@Offset", robotIndex, actuatorIndex);
-            good &= osaXML1394GetValue(xmlConfig, context, path, actuator.Drive.CurrentToBits.Offset);
-
-            sprintf(path, "Robot[%i]/Actuator[%d]/Drive/BitsToFeedbackAmps/@Scale", robotIndex, actuatorIndex);
-            good &= osaXML1394GetValue(xmlConfig, context, path, actuator.Drive.BitsToCurrent.Scale);
-
-            sprintf(path, "Robot[%i]/Actuator[%d]/Drive/BitsToFeedbackAmps/@Offset", robotIndex, actuatorIndex);
-            good &= osaXML1394GetValue(xmlConfig, context, path, actuator.Drive.BitsToCurrent.Offset);
-
-            sprintf(path, "Robot[%i]/Actuator[%d]/Drive/NmToAmps/@Scale", robotIndex, actuatorIndex);
-            good &= osaXML1394GetValue(xmlConfig, context, path, actuator.Drive.EffortToCurrent.Scale, !robot.OnlyIO);
-
-            sprintf(path, "Robot[%i]/Actuator[%d]/Drive/MaxCurrent/@Value", robotIndex, actuatorIndex);
-            good &= osaXML1394GetValue(xmlConfig, context, path, actuator.Drive.CurrentCommandLimit);
+            const _node driveNode = actuatorNode.Child("Drive");
+            good &= osaXML1394GetNodeValue(driveNode.Child("AmpsToBits"), "Scale", actuator.Drive.CurrentToBits.Scale);
+            good &= osaXML1394GetNodeValue(driveNode.Child("AmpsToBits"), "Offset", actuator.Drive.CurrentToBits.Offset);
+            good &= osaXML1394GetNodeValue(driveNode.Child("BitsToFeedbackAmps"), "Scale", actuator.Drive.BitsToCurrent.Scale);
+            good &= osaXML1394GetNodeValue(driveNode.Child("BitsToFeedbackAmps"), "Offset", actuator.Drive.BitsToCurrent.Offset);
+            good &= osaXML1394GetNodeValue(driveNode.Child("NmToAmps"), "Scale", actuator.Drive.EffortToCurrent.Scale, !robot.OnlyIO);
+            good &= osaXML1394GetNodeValue(driveNode.Child("MaxCurrent"), "Value", actuator.Drive.CurrentCommandLimit);
 
             // looking for brakes
-            sprintf(path, "Robot[%i]/Actuator[%d]/AnalogBrake", robotIndex, actuatorIndex);
-            int analogBrake;
-            xmlConfig.GetXMLValue(context, path, analogBrake, -1);
-            if (analogBrake != -1) {
+            const _node brakeNode = actuatorNode.Child("AnalogBrake");
+            if (brakeNode.Exists()) {
                 osaAnalogBrake1394Configuration * brake = new osaAnalogBrake1394Configuration;
                 actuator.Brake = brake;
                 robot.NumberOfBrakes++;
 
-                sprintf(path, "Robot[%i]/Actuator[%d]/AnalogBrake/@BoardID", robotIndex, actuatorIndex);
-                good &= osaXML1394GetValue(xmlConfig, context, path, actuator.Brake->BoardID);
-
-                sprintf(path, "Robot[%i]/Actuator[%d]/AnalogBrake/@AxisID", robotIndex, actuatorIndex);
-                good &= osaXML1394GetValue(xmlConfig, context, path, actuator.Brake->AxisID);
-
-                sprintf(path, "Robot[%i]/Actuator[%d]/AnalogBrake/AmpsToBits/@Scale", robotIndex, actuatorIndex);
-                good &= osaXML1394GetValue(xmlConfig, context, path, actuator.Brake->Drive.CurrentToBits.Scale);
-
-                sprintf(path, "Robot[%i]/Actuator[%d]/AnalogBrake/AmpsToBits/@Offset", robotIndex, actuatorIndex);
-                good &= osaXML1394GetValue(xmlConfig, context, path, actuator.Brake->Drive.CurrentToBits.Offset);
-
-                sprintf(path, "Robot[%i]/Actuator[%d]/AnalogBrake/BitsToFeedbackAmps/@Scale", robotIndex, actuatorIndex);
-                good &= osaXML1394GetValue(xmlConfig, context, path, actuator.Brake->Drive.BitsToCurrent.Scale);
-
-                sprintf(path, "Robot[%i]/Actuator[%d]/AnalogBrake/BitsToFeedbackAmps/@Offset", robotIndex, actuatorIndex);
-                good &= osaXML1394GetValue(xmlConfig, context, path, actuator.Brake->Drive.BitsToCurrent.Offset);
-
-                sprintf(path, "Robot[%i]/Actuator[%d]/AnalogBrake/MaxCurrent/@Value", robotIndex, actuatorIndex);
-                good &= osaXML1394GetValue(xmlConfig, context, path, actuator.Brake->Drive.CurrentCommandLimit);
-
-                sprintf(path, "Robot[%i]/Actuator[%d]/AnalogBrake/ReleaseCurrent/@Value", robotIndex, actuatorIndex);
-                good &= osaXML1394GetValue(xmlConfig, context, path, actuator.Brake->ReleaseCurrent);
-
-                sprintf(path, "Robot[%i]/Actuator[%d]/AnalogBrake/ReleaseTime/@Value", robotIndex, actuatorIndex);
-                good &= osaXML1394GetValue(xmlConfig, context, path, actuator.Brake->ReleaseTime);
-
-                sprintf(path, "Robot[%i]/Actuator[%d]/AnalogBrake/ReleasedCurrent/@Value", robotIndex, actuatorIndex);
-                good &= osaXML1394GetValue(xmlConfig, context, path, actuator.Brake->ReleasedCurrent);
-
-                sprintf(path, "Robot[%i]/Actuator[%d]/AnalogBrake/EngagedCurrent/@Value", robotIndex, actuatorIndex);
-                good &= osaXML1394GetValue(xmlConfig, context, path, actuator.Brake->EngagedCurrent);
-
+                good &= osaXML1394GetNodeValue(brakeNode, "BoardID", actuator.Brake->BoardID);
+                good &= osaXML1394GetNodeValue(brakeNode, "AxisID", actuator.Brake->AxisID);
+                good &= osaXML1394GetNodeValue(brakeNode.Child("AmpsToBits"), "Scale", actuator.Brake->Drive.CurrentToBits.Scale);
+                good &= osaXML1394GetNodeValue(brakeNode.Child("AmpsToBits"), "Offset", actuator.Brake->Drive.CurrentToBits.Offset);
+                good &= osaXML1394GetNodeValue(brakeNode.Child("BitsToFeedbackAmps"), "Scale", actuator.Brake->Drive.BitsToCurrent.Scale);
+                good &= osaXML1394GetNodeValue(brakeNode.Child("BitsToFeedbackAmps"), "Offset", actuator.Brake->Drive.BitsToCurrent.Offset);
+                good &= osaXML1394GetNodeValue(brakeNode.Child("MaxCurrent"), "Value", actuator.Brake->Drive.CurrentCommandLimit);
+                good &= osaXML1394GetNodeValue(brakeNode.Child("ReleaseCurrent"), "Value", actuator.Brake->ReleaseCurrent);
+                good &= osaXML1394GetNodeValue(brakeNode.Child("ReleaseTime"), "Value", actuator.Brake->ReleaseTime);
+                good &= osaXML1394GetNodeValue(brakeNode.Child("ReleasedCurrent"), "Value", actuator.Brake->ReleasedCurrent);
+                good &= osaXML1394GetNodeValue(brakeNode.Child("EngagedCurrent"), "Value", actuator.Brake->EngagedCurrent);
             } else {
                 // no brake found
                 actuator.Brake = 0;
             }
 
-            sprintf(path, "Robot[%i]/Actuator[%d]/Encoder/BitsToPosSI/@Scale", robotIndex, actuatorIndex);
-            good &= osaXML1394GetValue(xmlConfig, context, path, actuator.Encoder.BitsToPosition.Scale, !robot.OnlyIO);
+            const _node encoderNode = actuatorNode.Child("Encoder").Child("BitsToPosSI");
+            good &= osaXML1394GetNodeValue(encoderNode, "Scale", actuator.Encoder.BitsToPosition.Scale, !robot.OnlyIO);
             if (robot.OnlyIO) {
                 actuator.Encoder.BitsToPosition.Scale = 0.0;
             }
 
-            sprintf(path, "Robot[%i]/Actuator[%d]/Encoder/BitsToPosSI/@Unit", robotIndex, actuatorIndex);
             unit = "none";
-            good &= osaXML1394GetValue(xmlConfig, context, path, unit, !robot.OnlyIO);
+            good &= osaXML1394GetNodeValue(encoderNode, "Unit", unit, !robot.OnlyIO);
             if (actuator.JointType == PRM_JOINT_REVOLUTE) {
                 if (!osaUnitIsDistanceRevolute(unit) && !robot.OnlyIO) {
-                    CMN_LOG_INIT_ERROR << "Configure: invalid unit for \"" << path
+                    CMN_LOG_INIT_ERROR << "Configure: invalid unit for \"" << encoderNode.AttributePath("Unit")
                                        << "\", must be rad or deg but found \"" << unit << "\"" << std::endl;
                     good = false;
                 }
             } else if (actuator.JointType == PRM_JOINT_PRISMATIC) {
                 if (!osaUnitIsDistancePrismatic(unit) && !robot.OnlyIO) {
-                    CMN_LOG_INIT_ERROR << "Configure: invalid unit for \"" << path
+                    CMN_LOG_INIT_ERROR << "Configure: invalid unit for \"" << encoderNode.AttributePath("Unit")
                                        << "\", must be mm, cm or m but found \"" << unit << "\"" << std::endl;
                     good = false;
                 }
             }
             actuator.Encoder.BitsToPosition.Unit = unit;
 
-            sprintf(path, "Robot[%i]/Actuator[%d]/AnalogIn/BitsToVolts/@Scale", robotIndex, actuatorIndex);
-            good &= osaXML1394GetValue(xmlConfig, context, path, actuator.Pot.BitsToVoltage.Scale);
-
-            sprintf(path, "Robot[%i]/Actuator[%d]/AnalogIn/BitsToVolts/@Offset", robotIndex, actuatorIndex);
-            good &= osaXML1394GetValue(xmlConfig, context, path, actuator.Pot.BitsToVoltage.Offset);
+            // optional, software velocity estimation
+            const _node velocityNode = actuatorNode.Child("Encoder").Child("Velocity");
+            good &= osaXML1394GetVelocityEstimator(velocityNode, actuator.Encoder);
 
-            sprintf(path, "Robot[%i]/Actuator[%d]/AnalogIn/VoltsToPosSI/@Scale", robotIndex, actuatorIndex);
-            good &= osaXML1394GetValue(xmlConfig, context, path, actuator.Pot.VoltageToPosition.Scale, !robot.OnlyIO);
+            const _node analogInNode = actuatorNode.Child("AnalogIn");
+            const _node bitsToVoltsNode = analogInNode.Child("BitsToVolts");
+            good &= osaXML1394GetNodeValue(bitsToVoltsNode, "Scale", actuator.Pot.BitsToVoltage.Scale);
+            good &= osaXML1394GetNodeValue(bitsToVoltsNode, "Offset", actuator.Pot.BitsToVoltage.Offset);
 
-            sprintf(path, "Robot[%i]/Actuator[%d]/AnalogIn/VoltsToPosSI/@Offset", robotIndex, actuatorIndex);
-            good &= osaXML1394GetValue(xmlConfig, context, path, actuator.Pot. VoltageToPosition.Offset, !robot.OnlyIO);
+            const _node voltsToPosNode = analogInNode.Child("VoltsToPosSI");
+            good &= osaXML1394GetNodeValue(voltsToPosNode, "Scale", actuator.Pot.VoltageToPosition.Scale, !robot.OnlyIO);
+            good &= osaXML1394GetNodeValue(voltsToPosNode, "Offset", actuator.Pot.VoltageToPosition.Offset, !robot.OnlyIO);
 
-            sprintf(path, "Robot[%i]/Actuator[%d]/AnalogIn/VoltsToPosSI/@Unit", robotIndex, actuatorIndex);
             unit = "none";
-            good &= osaXML1394GetValue(xmlConfig, context, path, unit, !robot.OnlyIO);
+            good &= osaXML1394GetNodeValue(voltsToPosNode, "Unit", unit, !robot.OnlyIO);
             if (actuator.JointType == PRM_JOINT_REVOLUTE) {
                 if (!osaUnitIsDistanceRevolute(unit) && !robot.OnlyIO) {
-                    CMN_LOG_INIT_ERROR << "Configure: invalid unit for \"" << path
+                    CMN_LOG_INIT_ERROR << "Configure: invalid unit for \"" << voltsToPosNode.AttributePath("Unit")
                                        << "\", must be rad or deg but found \"" << unit << "\"" << std::endl;
                     good = false;
                 }
             } else if (actuator.JointType == PRM_JOINT_PRISMATIC) {
                 if (!osaUnitIsDistancePrismatic(unit) && !robot.OnlyIO) {
-                    CMN_LOG_INIT_ERROR << "Configure: invalid unit for \"" << path
+                    CMN_LOG_INIT_ERROR << "Configure: invalid unit for \"" << voltsToPosNode.AttributePath("Unit")
                                        << "\", must be mm, cm or m but found \"" << unit << "\"" << std::endl;
                     good = false;
                 }
@@ -349,10 +586,10 @@ namespace sawRobotIO1394 {
         }
 
         // look for potentiometers position, if any
+        const _node potentiometersNode = robotNode.Child("Potentiometers");
         std::string potentiometerPosition;
         robot.PotLocation = osaPot1394Location::POTENTIOMETER_UNDEFINED;
-        sprintf(path,"Robot[%d]/Potentiometers/@Position", robotIndex);
-        if (xmlConfig.GetXMLValue(context, path, potentiometerPosition)) {
+        if (potentiometersNode.Get("Position", potentiometerPosition)) {
             if (potentiometerPosition == "Actuators") {
                 robot.PotLocation = osaPot1394Location::POTENTIOMETER_ON_ACTUATORS;
             } else if (potentiometerPosition == "Joints") {
@@ -376,11 +613,10 @@ namespace sawRobotIO1394 {
             }
             for (int potIndex = 0; potIndex < numberOfPots; ++potIndex) {
                 osaPotTolerance1394Configuration pot;
-                int xmlPotIndex = potIndex + 1;
+                const _node toleranceNode = potentiometersNode.Child("Tolerance", potIndex + 1);
                 // check that axis index is valid
                 int axis = -12345;
-                sprintf(path, "Robot[%i]/Potentiometers/Tolerance[%d]/@Axis", robotIndex, xmlPotIndex);
-                good &= osaXML1394GetValue(xmlConfig, context, path, axis, false);
+                good &= osaXML1394GetNodeValue(toleranceNode, "Axis", axis, false);
                 // if set to -12345, no value found and disables check
                 if (axis == -12345) {
                     pot.Latency = 0.0;
@@ -395,13 +631,10 @@ namespace sawRobotIO1394 {
                     }
                     pot.AxisID = axis;
                     // get data
-                    sprintf(path, "Robot[%i]/Potentiometers/Tolerance[%d]/@Distance", robotIndex, xmlPotIndex);
-                    good &= osaXML1394GetValue(xmlConfig, context, path, pot.Distance);
-                    sprintf(path, "Robot[%i]/Potentiometers/Tolerance[%d]/@Latency", robotIndex, xmlPotIndex);
-                    good &= osaXML1394GetValue(xmlConfig, context, path, pot.Latency);
+                    good &= osaXML1394GetNodeValue(toleranceNode, "Distance", pot.Distance);
+                    good &= osaXML1394GetNodeValue(toleranceNode, "Latency", pot.Latency);
                     // convert to proper units
-                    sprintf(path, "Robot[%i]/Potentiometers/Tolerance[%d]/@Unit", robotIndex, xmlPotIndex);
-                    good &= osaXML1394GetValue(xmlConfig, context, path, unit);
+                    good &= osaXML1394GetNodeValue(toleranceNode, "Unit", unit);
                     if (osaUnitIsDistance(unit)) {
                         pot.Distance *= osaUnitToSIFactor(unit);
                     } else {
@@ -424,160 +657,35 @@ namespace sawRobotIO1394 {
         }
 
         // Configure Coupling
-        if (!osaXML1394ConfigureCoupling(xmlConfig, robotIndex, robot)) {
+        if (!osaXML1394ConfigureCouplingNode(robotNode, robot)) {
             return false;
         }
         return good;
     }
 
-    bool osaXML1394ConfigureCoupling(cmnXMLPath & xmlConfig,
-                                     const int robotIndex,
-                                     osaRobot1394Configuration & robot)
-    {
-        char path[64];
-        const char * context = "Config";
-        //The Coupling Value must be equal to 1 for this configuration to work.
-        int coupling = 0;
-        sprintf(path, "Robot[%i]/Coupling/@Value", robotIndex);
-        xmlConfig.GetXMLValue(context, path, coupling);
-        robot.HasActuatorToJointCoupling = (coupling == 1);
-
-        if (robot.HasActuatorToJointCoupling) {
-            bool parse_success = true;
-            parse_success &= osaXML1394ConfigureCouplingMatrix(xmlConfig, robotIndex, "ActuatorToJointPosition",
-                                                               robot.NumberOfJoints, robot.NumberOfActuators,
-                                                               robot.Coupling.ActuatorToJointPosition());
-
-            parse_success &= osaXML1394ConfigureCouplingMatrix(xmlConfig, robotIndex, "JointToActuatorPosition",
-                                                               robot.NumberOfActuators, robot.NumberOfJoints,
-                                                               robot.Coupling.JointToActuatorPosition());
-            if (robot.Coupling.JointToActuatorPosition().size() == 0) {
-                robot.Coupling.JointToActuatorPosition()
-                    .ForceAssign(robot.Coupling.ActuatorToJointPosition());
-                nmrInverse(robot.Coupling.JointToActuatorPosition());
-            }
-
-            parse_success &= osaXML1394ConfigureCouplingMatrix(xmlConfig, robotIndex, "ActuatorToJointTorque",
-                                                               robot.NumberOfJoints, robot.NumberOfActuators,
-                                                               robot.Coupling.ActuatorToJointEffort());
-            if (robot.Coupling.ActuatorToJointEffort().size() == 0) {
-                robot.Coupling.ActuatorToJointEffort()
-                    .ForceAssign(robot.Coupling.JointToActuatorPosition().Transpose());
-            }
-
-            parse_success &= osaXML1394ConfigureCouplingMatrix(xmlConfig, robotIndex, "JointToActuatorTorque",
-                                                               robot.NumberOfActuators, robot.NumberOfJoints,
-                                                               robot.Coupling.JointToActuatorEffort());
-            if (robot.Coupling.JointToActuatorEffort().size() == 0) {
-                robot.Coupling.JointToActuatorEffort()
-                    .ForceAssign(robot.Coupling.ActuatorToJointEffort());
-                nmrInverse(robot.Coupling.JointToActuatorEffort());
-            }
-
-            if (!parse_success) {
-                return false;
-            }
-
-            // make sure the coupling matrices make sense
-            vctDoubleMat product, identity;
-            identity.ForceAssign(vctDoubleMat::Eye(robot.NumberOfActuators));
-            product.SetSize(robot.NumberOfActuators, robot.NumberOfActuators);
-
-            product.ProductOf(robot.Coupling.ActuatorToJointPosition(),
-                              robot.Coupling.JointToActuatorPosition());
-
-            if (!product.AlmostEqual(identity, 0.001)) {
-                CMN_LOG_INIT_ERROR << "ConfigureCoupling: product of position coupling matrices not identity:"
-                                   << std::endl << product << std::endl;
-                return false;
-            }
-
-            product.ProductOf(robot.Coupling.ActuatorToJointEffort(),
-                              robot.Coupling.JointToActuatorEffort());
-            if (!product.AlmostEqual(identity, 0.001)) {
-                CMN_LOG_INIT_ERROR << "ConfigureCoupling: product of torque coupling matrices not identity:"
-                                   << std::endl << product << std::endl;
-                return false;
-            }
-        } // has actuator coupling
-        return true;
-    }
-
-    bool osaXML1394ConfigureCouplingMatrix(cmnXMLPath & xmlConfig,
-                                           const int robotIndex,
-                                           const char * couplingString,
-                                           int numRows,
-                                           int numCols,
-                                           vctDoubleMat & resultMatrix)
-    {
-        std::string context = "Config";
-
-        // Construct XPath for matrix
-        std::ostringstream matrixPath;
-        matrixPath << "Robot[" << robotIndex << "]/Coupling/" << couplingString;
-
-        // if it doesn't exist, parsing is fine, matrix is set to size 0, 0
-        if (!xmlConfig.Exists(context + '/'+ matrixPath.str())) {
-            resultMatrix.SetSize(0.0, 0.0, 0.0);
-            return true;
-        }
-
-        resultMatrix.SetSize(numRows, numCols, 0.0);
-        for (int i = 0; i < numRows; i++) {
-            // Construct XPath for matrix row
-            std::ostringstream rowPath;
-            rowPath << matrixPath.str() << "/Row[" << i + 1 << "]/@Val";
-
-            // Get the matrix row text
-            std::string rowAsString = "";
-            xmlConfig.GetXMLValue(context, rowPath.str(), rowAsString);
-
-            // Convert the text to a cisstVector row
-            std::stringstream rowAsStringStream;
-            rowAsStringStream.str(rowAsString);
-
-            vctDoubleVec row;
-            row.SetSize(numCols);
 
-            if (!row.FromStreamRaw(rowAsStringStream)) {
-                CMN_LOG_INIT_ERROR << "Row vector Assign failed on row " << i << ", path: " << rowPath.str() << std::endl;
-                return false;
-            }
-            resultMatrix.Row(i).Assign(row);
-        }
-        return true;
-    }
-
-    bool osaXML1394ConfigureDigitalInput(cmnXMLPath & xmlConfig,
-                                         const int inputIndex,
-                                         osaDigitalInput1394Configuration & digitalInput)
+    template <typename _node>
+    bool osaXML1394ConfigureDigitalInputNode(const _node & inputNode,
+                                             osaDigitalInput1394Configuration & digitalInput)
     {
-        // Digital Input Setup Stage
-        char path[64];
-        const char * context = "Config";
         bool tagsFound = true;
 
         //Check there is digital input entry. Return boolean result for success/fail.
-        sprintf(path,"DigitalIn[%i]/@Name", inputIndex);
-        tagsFound &= xmlConfig.GetXMLValue(context, path, digitalInput.Name);
-        sprintf(path,"DigitalIn[%i]/@BoardID", inputIndex);
-        tagsFound &= xmlConfig.GetXMLValue(context, path, digitalInput.BoardID);
-        sprintf(path,"DigitalIn[%i]/@BitID", inputIndex);
-        tagsFound &= xmlConfig.GetXMLValue(context, path, digitalInput.BitID);
+        tagsFound &= inputNode.Get("Name", digitalInput.Name);
+        tagsFound &= inputNode.Get("BoardID", digitalInput.BoardID);
+        tagsFound &= inputNode.Get("BitID", digitalInput.BitID);
 
         if (!tagsFound) {
-            CMN_LOG_INIT_ERROR << "Configuration for " << path << " failed. Stopping config." << std::endl;
+            CMN_LOG_INIT_ERROR << "Configuration for " << inputNode.AttributePath("BitID") << " failed. Stopping config." << std::endl;
             return false;
         }
 
         int pressed_value = 0;
-        sprintf(path, "DigitalIn[%i]/@Pressed", inputIndex);
-        xmlConfig.GetXMLValue(context, path, pressed_value);
+        inputNode.Get("Pressed", pressed_value);
         digitalInput.PressedValue = bool(pressed_value);
 
         std::string trigger_modes;
-        sprintf(path, "DigitalIn[%i]/@Trigger", inputIndex);
-        xmlConfig.GetXMLValue(context, path, trigger_modes);
+        inputNode.Get("Trigger", trigger_modes);
 
         digitalInput.TriggerWhenPressed = false;
         digitalInput.TriggerWhenReleased = false;
@@ -600,36 +708,31 @@ namespace sawRobotIO1394 {
         }
 
         double debounce = 0.0;
-        sprintf(path, "DigitalIn[%i]/@Debounce", inputIndex);
-        xmlConfig.GetXMLValue(context, path, debounce, 0.0);
+        inputNode.Get("Debounce", debounce);
         if (debounce < 0.0) {
             debounce = 0.0;
-            CMN_LOG_INIT_ERROR << "Configuration for " << path << " failed, you can't have a negative debounce value. Stopping config." << std::endl;
+            CMN_LOG_INIT_ERROR << "Configuration for " << inputNode.AttributePath("Debounce") << " failed, you can't have a negative debounce value. Stopping config." << std::endl;
             return false;
         }
         digitalInput.DebounceThreshold = debounce;
 
-        double debounceClick = 0.2 * debounce;
-        sprintf(path, "DigitalIn[%i]/@DebounceClick", inputIndex);
-        xmlConfig.GetXMLValue(context, path, debounceClick, 0.0);
+        double debounceClick = 0.0; // default if not found
+        inputNode.Get("DebounceClick", debounceClick);
         if ((debounceClick < 0.0) || (debounceClick > debounce)) {
             debounceClick = 0.2 * debounce;
-            CMN_LOG_INIT_ERROR << "Configuration for " << path << " failed, you can't have a negative debounce click value or a values greated than normal debounce. Stopping config." << std::endl;
+            CMN_LOG_INIT_ERROR << "Configuration for " << inputNode.AttributePath("DebounceClick") << " failed, you can't have a negative debounce click value or a values greated than normal debounce. Stopping config." << std::endl;
             return false;
         }
         digitalInput.DebounceThresholdClick = debounceClick;
 
-        return true;
+        return osaXML1394GetRateDivisor(inputNode, digitalInput.RateDivisor);
     }
 
 
-    bool osaXML1394ConfigureDigitalOutput(cmnXMLPath & xmlConfig,
-                                          const int outputIndex,
-                                          osaDigitalOutput1394Configuration & digitalOutput)
+    template <typename _node>
+    bool osaXML1394ConfigureDigitalOutputNode(const _node & outputNode,
+                                              osaDigitalOutput1394Configuration & digitalOutput)
     {
-        // Digital Input Setup Stage
-        char path[64];
-        const char * context = "Config";
         bool tagsFound = true;
 
         // defaults
@@ -638,54 +741,244 @@ namespace sawRobotIO1394 {
         digitalOutput.LowDuration = 0.0;
 
         // Check there is digital output entry. Return boolean result for success/fail.
-        sprintf(path,"DigitalOut[%i]/@Name", outputIndex);
-        tagsFound &= xmlConfig.GetXMLValue(context, path, digitalOutput.Name);
-        sprintf(path,"DigitalOut[%i]/@BoardID", outputIndex);
-        tagsFound &= xmlConfig.GetXMLValue(context, path, digitalOutput.BoardID);
-        sprintf(path,"DigitalOut[%i]/@BitID", outputIndex);
-        tagsFound &= xmlConfig.GetXMLValue(context, path, digitalOutput.BitID);
+        tagsFound &= outputNode.Get("Name", digitalOutput.Name);
+        tagsFound &= outputNode.Get("BoardID", digitalOutput.BoardID);
+        tagsFound &= outputNode.Get("BitID", digitalOutput.BitID);
 
         if (!tagsFound) {
-            CMN_LOG_INIT_ERROR << "Configuration for " << path << " failed. Stopping config." << std::endl;
+            CMN_LOG_INIT_ERROR << "Configuration for " << outputNode.AttributePath("BitID") << " failed. Stopping config." << std::endl;
             return false;
         }
 
         // look for high/low duration
-        sprintf(path,"DigitalOut[%i]/@HighDuration", outputIndex);
-        tagsFound = xmlConfig.GetXMLValue(context, path, digitalOutput.HighDuration);
-        sprintf(path,"DigitalOut[%i]/@LowDuration", outputIndex);
-        tagsFound = xmlConfig.GetXMLValue(context, path, digitalOutput.LowDuration);
+        outputNode.Get("HighDuration", digitalOutput.HighDuration);
+        outputNode.Get("LowDuration", digitalOutput.LowDuration);
 
         // look for PWM settings
-        sprintf(path,"DigitalOut[%i]/@Frequency", outputIndex);
-        tagsFound = xmlConfig.GetXMLValue(context, path, digitalOutput.PWMFrequency);
-        if (tagsFound) {
+        if (outputNode.Get("Frequency", digitalOutput.PWMFrequency)) {
             digitalOutput.IsPWM = true;
         }
-        return true;
+        return osaXML1394GetRateDivisor(outputNode, digitalOutput.RateDivisor);
     }
 
 
-    bool osaXML1394ConfigureDallasChip(cmnXMLPath & xmlConfig,
-                                       const int dallasIndex,
-                                       osaDallasChip1394Configuration & dallasChip)
+    template <typename _node>
+    bool osaXML1394ConfigureDallasChipNode(const _node & dallasNode,
+                                           osaDallasChip1394Configuration & dallasChip)
     {
-        // Digital Input Setup Stage
-        char path[64];
-        const char * context = "Config";
         bool tagsFound = true;
 
         // Check there is digital output entry. Return boolean result for success/fail.
-        sprintf(path,"DallasChip[%i]/@Name", dallasIndex);
-        tagsFound &= xmlConfig.GetXMLValue(context, path, dallasChip.Name);
-        sprintf(path,"DallasChip[%i]/@BoardID", dallasIndex);
-        tagsFound &= xmlConfig.GetXMLValue(context, path, dallasChip.BoardID);
+        tagsFound &= dallasNode.Get("Name", dallasChip.Name);
+        tagsFound &= dallasNode.Get("BoardID", dallasChip.BoardID);
 
         if (!tagsFound) {
-            CMN_LOG_INIT_ERROR << "Configuration for " << path << " failed. Stopping config." << std::endl;
+            CMN_LOG_INIT_ERROR << "Configuration for " << dallasNode.AttributePath("BoardID") << " failed. Stopping config." << std::endl;
+            return false;
+        }
+        return osaXML1394GetRateDivisor(dallasNode, dallasChip.RateDivisor);
+    }
+
+
+    template <typename _node>
+    bool osaXML1394ConfigurePortNode(const _node & configNode,
+                                     const std::string & filename,
+                                     osaPort1394Configuration & config)
+    {
+        // get an check version number
+        int version;
+        bool versionFound = osaXML1394GetNodeValue(configNode, "Version", version);
+        if (!versionFound) {
+            CMN_LOG_INIT_ERROR << "Configure: Config/Version is missing in file: "
+                               << filename << std::endl
+                               << "Make sure you generate your XML files with the latest config generator." << std::endl;
+            return false;
+        } else {
+            const int minimumVersion = 4; // backward compatibility
+            if (version < minimumVersion) {
+                CMN_LOG_INIT_ERROR << "Configure: Config/Version must be at least " << minimumVersion
+                                   << ", version found is " << version << std::endl
+                                   << "File: " << filename << std::endl
+                                   << "Make sure you generate your XML files with the latest config generator." << std::endl;
+                return false;
+            }
+            const int currentVersion = 4;
+            if (version > currentVersion) {
+                CMN_LOG_INIT_ERROR << "Configure: current Config/Version is " << currentVersion
+                                   << ", version found is " << version << ", you might want to upgrade your code" << std::endl
+                                   << "File: " << filename << std::endl
+                                   << "Make sure you generate your XML files with the latest config generator." << std::endl;
+            }
+        }
+
+        // Get the number of robot elements
+        const int numRobots = configNode.Count("Robot");
+
+        for (int i = 0; i < numRobots; i++) {
+            osaRobot1394Configuration robot;
+
+            // Store the robot in the config if it's succesfully parsed
+            if (osaXML1394ConfigureRobotNode(configNode.Child("Robot", i + 1), i + 1, robot)) {
+                config.Robots.push_back(robot);
+            } else {
+                CMN_LOG_INIT_WARNING << "ConfigurePort: failed to configure robot from file \""
+                                     << filename << "\"" << std::endl;
+                return false;
+            }
+        }
+
+        // Get the number of digital input elements
+        const int numDigitalInputs = configNode.Count("DigitalIn");
+
+        for (int i = 0; i < numDigitalInputs; i++) {
+            osaDigitalInput1394Configuration digitalInput;
+
+            // Store the digitalInput in the config if it's succesfully parsed
+            if (osaXML1394ConfigureDigitalInputNode(configNode.Child("DigitalIn", i + 1), digitalInput)) {
+                config.DigitalInputs.push_back(digitalInput);
+            } else {
+                CMN_LOG_INIT_WARNING << "ConfigurePort: failed to configure digital input from file \""
+                                     << filename << "\"" << std::endl;
+                return false;
+            }
+        }
+
+        // Get the number of digital output elements
+        const int numDigitalOutputs = configNode.Count("DigitalOut");
+
+        for (int i = 0; i < numDigitalOutputs; i++) {
+            osaDigitalOutput1394Configuration digitalOutput;
+
+            // Store the digitalOutput in the config if it's succesfully parsed
+            if (osaXML1394ConfigureDigitalOutputNode(configNode.Child("DigitalOut", i + 1), digitalOutput)) {
+                config.DigitalOutputs.push_back(digitalOutput);
+            } else {
+                CMN_LOG_INIT_WARNING << "ConfigurePort: failed to configure digital output from file \""
+                                     << filename << "\"" << std::endl;
+                return false;
+            }
+        }
+
+        // Get the number of Dallas chip elements
+        const int numDallasChips = configNode.Count("DallasChip");
+
+        for (int i = 0; i < numDallasChips; i++) {
+            osaDallasChip1394Configuration dallasChip;
+
+            // Store the dallasChip in the config if it's succesfully parsed
+            if (osaXML1394ConfigureDallasChipNode(configNode.Child("DallasChip", i + 1), dallasChip)) {
+                config.DallasChips.push_back(dallasChip);
+            } else {
+                CMN_LOG_INIT_WARNING << "ConfigurePort: failed to configure Dallas chip from file \""
+                                     << filename << "\"" << std::endl;
+                return false;
+            }
+        }
+
+        // Check to make sure something was found
+        if ((numRobots + numDigitalInputs + numDigitalOutputs + numDallasChips) == 0) {
+            CMN_LOG_INIT_ERROR << "osaXML1394ConfigurePort: file " << filename
+                               << " doesn't contain any Config/Robot, Config/DigitalIn, Config/DigitalOut or Config/DallasChip" << std::endl;
             return false;
         }
         return true;
     }
 
+
+    bool osaXML1394LoadPort(const std::string & filename, osaPort1394Configuration & config)
+    {
+#ifdef sawRobotIO1394_HAS_LIBXML2
+        // parse the whole document once and walk the tree
+        xmlDoc * document = xmlReadFile(filename.c_str(), 0, XML_PARSE_NONET);
+        if (!document) {
+            CMN_LOG_INIT_ERROR << "osaXML1394LoadPort: failed to parse XML file \""
+                               << filename << "\"" << std::endl;
+            return false;
+        }
+        xmlNode * root = xmlDocGetRootElement(document);
+        if (!root
+            || (xmlStrcmp(root->name, reinterpret_cast<const xmlChar *>("Config")) != 0)) {
+            CMN_LOG_INIT_ERROR << "osaXML1394LoadPort: root element must be <Config> in file \""
+                               << filename << "\"" << std::endl;
+            xmlFreeDoc(document);
+            return false;
+        }
+        const bool result = osaXML1394ConfigurePortNode(osaXML1394DOMNode(root), filename, config);
+        xmlFreeDoc(document);
+        return result;
+#else
+        cmnXMLPath xmlConfig;
+        xmlConfig.SetInputSource(filename);
+        return osaXML1394ConfigurePortNode(osaXML1394XPathNode(xmlConfig), filename, config);
+#endif
+    }
+
+    void osaXML1394ConfigurePort(const std::string & filename, osaPort1394Configuration & config)
+    {
+        if (!osaXML1394LoadPort(filename, config)) {
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    void osaXML1394ConfigurePortXPath(const std::string & filename, osaPort1394Configuration & config)
+    {
+        cmnXMLPath xmlConfig;
+        xmlConfig.SetInputSource(filename);
+        if (!osaXML1394ConfigurePortNode(osaXML1394XPathNode(xmlConfig), filename, config)) {
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    bool osaXML1394ConfigureRobot(cmnXMLPath & xmlConfig,
+                                  const int robotIndex,
+                                  osaRobot1394Configuration & robot)
+    {
+        const osaXML1394XPathNode configNode(xmlConfig);
+        return osaXML1394ConfigureRobotNode(configNode.Child("Robot", robotIndex), robotIndex, robot);
+    }
+
+    bool osaXML1394ConfigureCoupling(cmnXMLPath & xmlConfig,
+                                     const int robotIndex,
+                                     osaRobot1394Configuration & robot)
+    {
+        const osaXML1394XPathNode configNode(xmlConfig);
+        return osaXML1394ConfigureCouplingNode(configNode.Child("Robot", robotIndex), robot);
+    }
+
+    bool osaXML1394ConfigureCouplingMatrix(cmnXMLPath & xmlConfig,
+                                           const int robotIndex,
+                                           const char * couplingString,
+                                           int numRows,
+                                           int numCols,
+                                           vctDoubleMat & resultMatrix)
+    {
+        const osaXML1394XPathNode configNode(xmlConfig);
+        return osaXML1394ConfigureCouplingMatrixNode(configNode.Child("Robot", robotIndex).Child("Coupling"),
+                                                     couplingString, numRows, numCols, resultMatrix);
+    }
+
+    bool osaXML1394ConfigureDigitalInput(cmnXMLPath & xmlConfig,
+                                         const int inputIndex,
+                                         osaDigitalInput1394Configuration & digitalInput)
+    {
+        const osaXML1394XPathNode configNode(xmlConfig);
+        return osaXML1394ConfigureDigitalInputNode(configNode.Child("DigitalIn", inputIndex), digitalInput);
+    }
+
+    bool osaXML1394ConfigureDigitalOutput(cmnXMLPath & xmlConfig,
+                                          const int outputIndex,
+                                          osaDigitalOutput1394Configuration & digitalOutput)
+    {
+        const osaXML1394XPathNode configNode(xmlConfig);
+        return osaXML1394ConfigureDigitalOutputNode(configNode.Child("DigitalOut", outputIndex), digitalOutput);
+    }
+
+    bool osaXML1394ConfigureDallasChip(cmnXMLPath & xmlConfig,
+                                       const int dallasIndex,
+                                       osaDallasChip1394Configuration & dallasChip)
+    {
+        const osaXML1394XPathNode configNode(xmlConfig);
+        return osaXML1394ConfigureDallasChipNode(configNode.Child("DallasChip", dallasIndex), dallasChip);
+    }
+
 }
@@ -68,20 +68,60 @@ namespace sawRobotIO1394 {
 
         void PollState(void);
 
+        /*! Multi-rate scheduling, the device is only updated when
+          (cycle + phase) is a multiple of the rate divisor. */
+        inline bool IsScheduled(const size_t cycle) const {
+            return ((cycle + mRatePhase) % mRateDivisor) == 0;
+        }
+        inline size_t RateDivisor(void) const {
+            return mRateDivisor;
+        }
+        inline void SetRatePhase(const size_t phase) {
+            mRatePhase = phase;
+        }
+
         const osaDallasChip1394Configuration & Configuration(void) const;
         const std::string & Name(void) const;
         const std::string & ToolType(void) const;
         void TriggerRead(void);
 
+        /*! Maximum bus time spent per cycle on tool read, at least one
+          transaction is performed per cycle while a read is in
+          progress. */
+        void SetBusTimeBudget(const double budget);
+
+        /*! Forget all tool types cached by board. */
+        static void ClearToolTypeCache(void);
+
 
     protected:
         mtsInterfaceProvided * mInterface = nullptr;
         mtsFunctionWrite ToolTypeEvent;
         AmpIO * mBoard = nullptr;
         osaDallasChip1394Configuration mConfiguration;
+        size_t mRateDivisor = 1;     // updated every mRateDivisor cycles
+        size_t mRatePhase = 0;       // offset to spread devices across cycles
         std::string mName;
         mtsStdString mToolType = ToolTypeUndefined;
-        int mStatus = 0; // 0: nothing to do, 1: sent ctrl, waiting for status, 2: reading data
+
+        // tool read is split in small transactions, each state
+        // performs one transaction
+        typedef enum {
+            DALLAS_IDLE,           // nothing to do
+            DALLAS_CHECK_FIRMWARE, // read firmware version
+            DALLAS_CHECK_QLA,      // read status, check for bidirectional I/O
+            DALLAS_WRITE_CONTROL,  // request tool read
+            DALLAS_WAIT_STATUS,    // wait for chip data to be copied on FPGA
+            DALLAS_READ_BLOCK      // read data, one chunk at a time
+        } DallasState;
+        DallasState mState = DALLAS_IDLE;
+        bool Step(void);
+        void Fail(const std::string & message);
+        void SetToolType(const std::string & toolType);
+
+        double mBusTimeBudget;
+        size_t mBytesRead = 0;
+        unsigned int mBuffer[64]; // 256 bytes of tool data, quadlet aligned
     };
 
 } // namespace sawRobotIO1394
@@ -19,6 +19,10 @@ http://www.cisst.org/cisst/license.txt.
 #ifndef _mtsDigitalInput1394_h
 #define _mtsDigitalInput1394_h
 
+#include <atomic>
+#include <mutex>
+
+#include <cisstVector/vctDynamicMatrixTypes.h>
 #include <cisstParameterTypes/prmEventButton.h>
 #include <sawRobotIO1394/osaConfiguration1394.h>
 
@@ -29,8 +33,6 @@ http://www.cisst.org/cisst/license.txt.
 
 namespace sawRobotIO1394 {
 
-    class mtsDigitalInput1394Data;
-
     class mtsDigitalInput1394 {
     public:
         /*! Pointer on existing services.  This allows to use the class
@@ -62,9 +64,18 @@ namespace sawRobotIO1394 {
         void CheckState(void);
 
         void Configure(const osaDigitalInput1394Configuration & config);
-        void SetBoard(AmpIO * board);
 
-        void PollState(void);
+        /*! Multi-rate scheduling, the device is only updated when
+          (cycle + phase) is a multiple of the rate divisor. */
+        inline bool IsScheduled(const size_t cycle) const {
+            return ((cycle + mRatePhase) % mRateDivisor) == 0;
+        }
+        inline size_t RateDivisor(void) const {
+            return mRateDivisor;
+        }
+        inline void SetRatePhase(const size_t phase) {
+            mRatePhase = phase;
+        }
 
         const osaDigitalInput1394Configuration & Configuration(void) const;
 
@@ -72,11 +83,34 @@ namespace sawRobotIO1394 {
         const bool & Value(void) const;
         const bool & PreviousValue(void) const;
 
+        /*! Columns of the matrix returned by GetEdgeEvents, one row
+          per event.  Type is a prmEventButton::EventType.  Board time
+          is the estimated edge time in seconds based on the FPGA
+          timestamps, half a read period of uncertainty.  For
+          debounced inputs, the edge time is the time of the first
+          transition, not the time the value was accepted.  Host time
+          is the board time converted to osaGetTime. */
+        enum {EVENT_TYPE = 0, EVENT_BOARD_TIME, EVENT_HOST_TIME, EVENT_NUMBER_OF_COLUMNS};
+
+        /*! Events recorded since last call, oldest first.  Used by the
+          read command GetEdgeEvents, i.e. in the caller's thread.
+          Events are removed from the queue so if more than one client
+          uses this command, each client only gets some of the events.
+          The matrix is only resized if the number of events
+          changed. */
+        void GetEdgeEvents(vctDoubleMat & events) const;
+
     protected:
+        // board-wide engine updates values and debounce state directly
+        friend class mtsDigitalInputBank1394;
+        void Click(void);
+        void PushEdgeEvent(const prmEventButton::EventType type,
+                           const double boardTime, const double hostTime);
+
         mtsFunctionWrite Button;    // The event function for button, will return prmEventButton
-        AmpIO * mBoard;              // Board Assignment
-        mtsDigitalInput1394Data * mData; // Internal data using AmpIO types
         osaDigitalInput1394Configuration mConfiguration;
+        size_t mRateDivisor = 1;     // updated every mRateDivisor cycles
+        size_t mRatePhase = 0;       // offset to spread devices across cycles
         std::string mName;
         int mBitID;                  // Board assigned bitID for this Digital Input
         bool mPressedValue;          // Boolean Flag for Active High(true)/Active Low(false)
@@ -85,11 +119,9 @@ namespace sawRobotIO1394 {
         double mDebounceThreshold;   // 0, no debounce required otherwise time in seconds
         double mDebounceThresholdClick; // Quick transition, i.e. single click
 
-        // State data
+        // State data, updated by mtsDigitalInputBank1394
         bool mValue;                    // Current read value
-        bool mTransitionValue;          // For debouncing
         bool mPreviousValue;            // Saved value from the previous read
-        double mDebounceCounter;        // time in seconds with constant value
         mtsStateTable * mStateTable = nullptr;
 
         struct {
@@ -97,6 +129,21 @@ namespace sawRobotIO1394 {
             prmEventButton Released;
             prmEventButton Clicked;
         } mEventPayloads;
+
+        // edge events, new events are dropped when the queue is full.
+        // Single producer queue, pushed by the bank in the IO thread
+        // without lock.  Readers are serialized by mEdgeEventsMutex
+        struct EdgeEvent {
+            prmEventButton::EventType Type;
+            double BoardTime;
+            double HostTime;
+        };
+        enum {EDGE_EVENTS_SIZE = 64};
+        EdgeEvent mEdgeEvents[EDGE_EVENTS_SIZE];
+        std::atomic<size_t> mEdgeEventsHead;              // next event written
+        mutable std::atomic<size_t> mEdgeEventsTail;      // next event read
+        mutable std::atomic<size_t> mEdgeEventsOverflows;
+        mutable std::mutex mEdgeEventsMutex;
     };
 
 } // namespace sawRobotIO1394
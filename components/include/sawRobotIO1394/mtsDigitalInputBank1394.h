@@ -0,0 +1,106 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  Author(s):  Anton Deguet
+  Created on: 2021-07-12
+
+  (C) Copyright 2021 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#ifndef _mtsDigitalInputBank1394_h
+#define _mtsDigitalInputBank1394_h
+
+#include <cstddef>
+#include <sawRobotIO1394/sawRobotIO1394ForwardDeclarations.h>
+
+// Always include last
+#include <sawRobotIO1394/sawRobotIO1394Export.h>
+
+namespace sawRobotIO1394 {
+
+    /*! All digital inputs on one board.  The digital input word is
+      read once per cycle and the debounce state of all bits is stored
+      in bit masks so inputs that don't change cost almost nothing.
+      Values and events of each mtsDigitalInput1394 are only updated
+      for bits that changed. */
+    class CISST_EXPORT mtsDigitalInputBank1394 {
+    public:
+        enum {NUMBER_OF_BITS = 32};
+
+        mtsDigitalInputBank1394(AmpIO * board, const osaBoardClock1394 * clock);
+        ~mtsDigitalInputBank1394();
+
+        /*! Add an input, throws an exception if the bit is already
+          used by another input or if the input's rate divisor is not
+          the same as the other inputs on this board. */
+        void AddInput(mtsDigitalInput1394 * input);
+        void RemoveInput(mtsDigitalInput1394 * input);
+        bool Empty(void) const;
+
+        /*! Banks used by the IO thread are not modified at runtime,
+          a new bank is created instead.  Keep values and debounce
+          state of the inputs also used by the previous bank.  Doesn't
+          allocate memory. */
+        void CopyState(const mtsDigitalInputBank1394 & previous);
+
+        /*! Read digital input word and update all bits. */
+        void PollState(void);
+
+        /*! Update all bits with a digital input word read at a given
+          FPGA time (see osaBoardClock1394::Time), used by
+          PollState. */
+        void Update(const unsigned int bits, const double boardTime);
+
+        /*! Trigger events for inputs changed during last poll. */
+        void CheckState(void);
+
+        /*! All inputs on a board share the same rate divisor. */
+        inline bool IsScheduled(const size_t cycle) const {
+            return ((cycle + mRatePhase) % mRateDivisor) == 0;
+        }
+        inline size_t RateDivisor(void) const {
+            return mRateDivisor;
+        }
+        inline void SetRatePhase(const size_t phase) {
+            mRatePhase = phase;
+        }
+
+    protected:
+        void UpdateMasks(void);
+
+        AmpIO * mBoard;
+        const osaBoardClock1394 * mClock; // decoded timestamps, see mtsRobotIO1394
+        mtsDigitalInput1394 * mInputs[NUMBER_OF_BITS]; // indexed by bit, null if not used
+        size_t mRateDivisor = 1;
+        size_t mRatePhase = 0;
+
+        // configuration
+        unsigned int mUsedMask = 0x0;      // bits used by an input
+        unsigned int mPressedMask = 0x0;   // bits pressed when low
+        unsigned int mImmediateMask = 0x0; // bits without debounce
+
+        // state, one bit per input
+        unsigned int mValues = 0x0;        // current values, true if pressed
+        unsigned int mDebouncing = 0x0;    // bits waiting for a stable value
+        unsigned int mTransition = 0x0;    // value being debounced
+        unsigned int mChanged = 0x0;       // values changed during last poll
+        double mCounters[NUMBER_OF_BITS];  // time in seconds with constant value
+        double mEdgeTimes[NUMBER_OF_BITS]; // board time of transition being debounced
+
+        // FPGA time of the previous poll, host times of edges are
+        // provided by the board clock
+        double mBoardTime = 0.0;
+    };
+
+} // namespace sawRobotIO1394
+
+#endif // _mtsDigitalInputBank1394_h
@@ -66,22 +66,53 @@ namespace sawRobotIO1394 {
 
         void PollState(void);
 
+        /*! Multi-rate scheduling, the device is only updated when
+          (cycle + phase) is a multiple of the rate divisor. */
+        inline bool IsScheduled(const size_t cycle) const {
+            return ((cycle + mRatePhase) % mRateDivisor) == 0;
+        }
+        inline size_t RateDivisor(void) const {
+            return mRateDivisor;
+        }
+        inline void SetRatePhase(const size_t phase) {
+            mRatePhase = phase;
+        }
+
         const osaDigitalOutput1394Configuration & Configuration(void) const;
         const std::string & Name(void) const;
         const bool & Value(void) const;
         void SetValue(const bool & newValue);
         void SetPWMDutyCycle(const double & dutyCycle);
 
+        /*! Changes requested with SetValue are buffered.  Returns
+          false if there is nothing to write, otherwise the bit mask
+          and bits to write and clears the pending change.  Changes
+          for all outputs on a board are merged and sent with the
+          cyclic write. */
+        bool GetPendingWrite(unsigned int & mask, unsigned int & bits);
+
+        /*! PWM settings use separate registers, the last duty cycle
+          requested is written once per cycle.  The initial high/low
+          durations set by SetBoard are also written here so SetBoard
+          doesn't use the port, i.e. it can be called off the IO
+          thread. */
+        void WritePendingPWM(void);
+
 
     protected:
         mtsFunctionWrite Button;    // The event function for button, will return prmEventButton
         AmpIO * mBoard;              // Board Assignment
         mtsDigitalOutput1394Data * mData; // Internal data using AmpIO types
         osaDigitalOutput1394Configuration mConfiguration;
+        size_t mRateDivisor = 1;     // updated every mRateDivisor cycles
+        size_t mRatePhase = 0;       // offset to spread devices across cycles
         std::string mName;
         int mBitID;                  // Board assigned bitID for this Digital Output
         // State data
         bool mValue;                     // Current read value
+        bool mControlPending = false;    // high/low durations not written yet
+        bool mPWMPending = false;        // PWM duty cycle changed since last write
+        double mPWMDutyCycle = 0.0;
     };
 
 } // namespace sawRobotIO1394
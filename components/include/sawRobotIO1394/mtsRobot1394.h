@@ -87,6 +87,9 @@ namespace sawRobotIO1394 {
         void SetBoards(const std::vector<osaActuatorMapping> & actuatorBoards,
                        const std::vector<osaBrakeMapping> & brakeBoards);
 
+        /*! Set lowest/highest firmware versions for the boards used by
+          this robot, versions are indexed by board Id. */
+        void SetFirmwareVersions(const std::map<int, unsigned int> & firmwareVersions);
         void GetFirmwareRange(unsigned int & lowest, unsigned int & highest) const;
         /**}**/
 
@@ -100,6 +103,30 @@ namespace sawRobotIO1394 {
         void CheckState(void);
         /**}**/
 
+        /*! Multi-rate scheduling, the robot is only updated when
+          (cycle + phase) is a multiple of the rate divisor. */
+        inline bool IsScheduled(const size_t cycle) const {
+            return ((cycle + mRatePhase) % mRateDivisor) == 0;
+        }
+        inline size_t RateDivisor(void) const {
+            return mRateDivisor;
+        }
+        inline void SetRatePhase(const size_t phase) {
+            mRatePhase = phase;
+        }
+
+        /*! Rows of the matrices returned by GetActuatorVelocityEstimates
+          and GetVelocityEstimatorStatistics are osaVelocityEstimator1394
+          values.  Velocity estimates have one column per actuator.
+          Estimates of estimators not used by any actuator are 0.
+          Statistics columns are defined below, times are in seconds for
+          all actuators of the robot and the average is filtered over
+          about 1000 cycles.  Times are only measured when all
+          estimators are computed, see SetEstimateAllVelocities. */
+        enum {NUMBER_OF_VELOCITY_ESTIMATORS = 4};
+        enum {VELOCITY_STATISTICS_ACTUATORS = 0, VELOCITY_STATISTICS_AVERAGE_TIME,
+              VELOCITY_STATISTICS_MAXIMUM_TIME, VELOCITY_STATISTICS_NUMBER_OF_COLUMNS};
+
         /** \name Command Functions
          * These functions interact with the lower-level hardware when called to
          * change its state in some way. Note that these functions do not have
@@ -112,6 +139,9 @@ namespace sawRobotIO1394 {
         void WritePowerEnable(const bool & power);
         void WriteSafetyRelay(const bool & close);
         void SetWatchdogPeriod(const double & periodInSeconds);
+        /*! Used when the robot is removed at runtime, it is no
+          longer polled so an invalid state is published once. */
+        void Invalidate(void);
 
         void SetActuatorAmpEnable(const bool & enable);
         void SetActuatorAmpEnable(const vctBoolVec & enable);
@@ -127,6 +157,12 @@ namespace sawRobotIO1394 {
         //! Pots to encoder safety check
         void UsePotsForSafetyCheck(const bool & usePotsForSafetyCheck);
 
+        /*! Compute all software velocity estimators for all
+          actuators, not only the ones selected in the configuration.
+          Useful to compare estimators with
+          GetActuatorVelocityEstimates. */
+        void SetEstimateAllVelocities(const bool & all);
+
         //! Actuator Control
         void SetJointEffort(const vctDoubleVec & efforts);
         void SetActuatorEffort(const vctDoubleVec & efforts);
@@ -196,6 +232,8 @@ namespace sawRobotIO1394 {
         const vctDoubleVec & PotPosition(void) const;
         const vctDoubleVec & ActuatorTimeStamp(void) const;
         const vctDoubleVec & BrakeTimeStamp(void) const;
+        //! Host time (osaGetTime) of the read, drift corrected, see osaBoardClock1394
+        const vctDoubleVec & ActuatorSampleTime(void) const;
         const vctDoubleVec & ActuatorEncoderAcceleration(void) const;
         const vctDoubleVec & EncoderAcceleration(void) const;
         const prmStateJoint & ActuatorJointState(void) const;
@@ -229,6 +267,10 @@ namespace sawRobotIO1394 {
         //! Conversions for encoders
         void EncoderPositionToBits(const vctDoubleVec & pos, vctIntVec & bits) const;
         void EncoderBitsToPosition(const vctIntVec & bits, vctDoubleVec & pos) const;
+        /*! Raw FPGA velocity compensated for the FPGA edge delay using
+          the FPGA acceleration, without crossing zero.  Requires
+          firmware rev 6+ and AccelerationCompensatedVelocity in the
+          robot configuration, raw velocity is not read otherwise. */
         void EncoderBitsToVelocityPredicted(vctDoubleVec & vel) const;
 
         //! Conversions for actuator current commands and measurements
@@ -248,16 +290,24 @@ namespace sawRobotIO1394 {
 
     protected:
         void ClipActuatorEffort(vctDoubleVec & efforts);
+
+        //! Software velocity estimation, called by ConvertState
+        void EstimateVelocities(void);
+        void ResetVelocityEstimators(void);
+        void UpdateVelocityStatistics(const size_t estimator, const double time);
         void ClipActuatorCurrent(vctDoubleVec & currents);
         void ClipBrakeCurrent(vctDoubleVec & currents);
 
         //! Board Objects
         std::vector<osaActuatorMapping> mActuatorInfo;
         std::vector<osaBrakeMapping> mBrakeInfo;
-        std::map<int, AmpIO*> mUniqueBoards;
+        std::map<int, AmpIO*> mUniqueBoards; // indexed by board key, i.e. port index * MAX_BOARDS + board Id
 
         //! Robot Configuration
         osaRobot1394Configuration mConfiguration;
+        size_t mRateDivisor = 1;     // updated every mRateDivisor cycles
+        size_t mRatePhase = 0;       // offset to spread robots across cycles
+        bool mAccelerationCompensatedVelocity = false; // requested and firmware rev 6+
         std::string mName;
         size_t mNumberOfActuators;
         size_t mNumberOfJoints;
@@ -346,13 +396,14 @@ namespace sawRobotIO1394 {
             // mActuatorPreviousTimestampChange,
             // mVelocitySlopeToZero, // slope used to reduced velocity to zero when no encoder count change
             mBrakeTimestamp,
+            mActuatorSampleTime, // host time of board reads, see osaBoardClock1394
             mPotVoltage,
             mPotPosition,
 
             mEncoderVelocityPredictedCountsPerSec, // velocity based on FPGA velocity estimation, including prediction
-            // mEncoderVelocityDelay,            // assumed delay in velocity measurement (period/2)
-            // mEncoderVelocityPredicted,        // velocity based on FPGA measurement, combined with prediction based on acceleration (SI units)
-            // mEncoderVelocitySoftware,         // velocity based on backward difference of position (SI units)
+            mEncoderVelocityCountsPerSec, // raw FPGA velocity, only read if acceleration compensated
+            mEncoderVelocityDelay,        // FPGA edge delay, half encoder period + time since last edge
+            mEncoderVelocityCompensatedCountsPerSec, // raw velocity compensated for delay using acceleration (firmware rev 6)
             mEncoderAccelerationCountsPerSecSec, // acceleration based on FPGA measurement (firmware rev 6)
             mEncoderAcceleration,                // acceleration in SI units (firmware rev 6)
             mActuatorEncoderAcceleration,
@@ -371,6 +422,44 @@ namespace sawRobotIO1394 {
             mBrakeReleasedCurrent,
             mBrakeEngagedCurrent;
 
+        //! Pre-allocated temporaries so commands don't allocate memory in the IO loop
+        struct {
+            vctDoubleVec ActuatorEfforts;
+            vctDoubleVec ActuatorCurrents;
+            vctDoubleVec ActuatorPositions;
+            vctIntVec ActuatorBits;
+            vctIntVec BrakeBits;
+            // used once calibration is over
+            vctDoubleVec Potentiometers;
+            vctDoubleVec EncoderReference;
+            vctDoubleVec EncoderDelta;
+            mtsGenericObjectProxy<vctDoubleVec> PotentiometersSample;
+            prmStateJoint EncodersSample;
+        } mScratch;
+
+        //! Software velocity estimation, see osaVelocityEstimator1394
+        struct {
+            // ring buffers, one row per sample and one column per
+            // actuator, encoder counts and time in seconds
+            vctDoubleMat Positions;
+            vctDoubleMat Times;
+            size_t Head = 0;     // row of latest sample
+            size_t Samples = 0;  // valid rows
+            bool Reset = true;   // encoders preloaded, restart from latest sample
+            bool All = false;    // compute all estimators for all actuators
+            vctIntVec Estimator; // per actuator
+            vctIntVec Window;    // per actuator, least squares only
+            vctDoubleVec ObserverBandwidth; // rad/s
+            vctDoubleVec ObserverPosition;  // counts
+            vctDoubleVec ObserverVelocity;  // counts/s
+            // least squares sums, temporaries
+            vctDoubleVec SumWeights, SumTimes, SumPositions, SumTimes2, SumTimesPositions;
+            size_t NumberOfActuators[NUMBER_OF_VELOCITY_ESTIMATORS];
+            vctDoubleMat Estimates;  // counts/s, one row per estimator, one column per actuator
+            vctDoubleMat EstimatesSI;
+            vctDoubleMat Statistics; // one row per estimator, see VELOCITY_STATISTICS_
+        } mVelocity;
+
         size_t
             mCurrentSafetyViolationsCounter,
             mCurrentSafetyViolationsMaximum;
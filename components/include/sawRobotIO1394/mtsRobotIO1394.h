@@ -21,11 +21,20 @@ http://www.cisst.org/cisst/license.txt.
 
 #include <ostream>
 #include <iostream>
+#include <fstream>
 #include <vector>
+#include <atomic>
+#include <mutex>
 
+#include <cisstOSAbstraction/osaThread.h>
+#include <cisstOSAbstraction/osaThreadSignal.h>
+#include <cisstVector/vctDynamicMatrixTypes.h>
 #include <cisstMultiTask/mtsTaskPeriodic.h>
 #include <sawRobotIO1394/sawRobotIO1394ForwardDeclarations.h>
+#include <sawRobotIO1394/osaFlightRecorder1394.h>
 #include <sawRobotIO1394/sawRobotIO1394Export.h>
+#include <sawRobotIO1394/osaTimeHistogram1394.h>
+#include <sawRobotIO1394/osaBoardClock1394.h>
 
 class CISST_EXPORT mtsRobotIO1394 : public mtsTaskPeriodic {
 
@@ -35,23 +44,144 @@ public:
 
 protected:
 
-    std::ostream * mMessageStream; // Stream provided to the low level boards for messages, redirected to cmnLogger
-
-    BasePort * mPort;
+    std::ostream * mMessageStream = nullptr; // Stream provided to the low level boards for messages, redirected to cmnLogger
+
+    BasePort * mPort; // first port, kept for backward compatibility
+    std::vector<BasePort *> mPorts;
+
+    // one thread per port when using more than one port, the IO
+    // thread waits for all ports to be done (barrier)
+    typedef enum {PORT_IDLE, PORT_READ, PORT_WRITE, PORT_STOP} PortOperation;
+    struct PortWorker {
+        size_t Index;
+        BasePort * Port;
+        osaThread Thread;
+        osaThreadSignal Start;
+        osaThreadSignal Done;
+        PortOperation Operation;
+        int CPU; // negative to not set affinity
+        double StartTime;
+        double Duration;
+        bool Ok;
+        std::string Error;
+    };
+    std::vector<PortWorker *> mPortWorkers;
+    std::vector<int> mPortCPUs;
+    vctDoubleVec mPortReadTime;  // per port, last read
+    vctDoubleVec mPortReadStart; // per port, host time of last read request
+    vctDoubleVec mPortWriteTime; // per port, last write
+    PortOperation mPendingOperation = PORT_IDLE;
+
+    // write completes while the IO thread advances state tables and
+    // sleeps until next cycle
+    bool mSplitPhaseWrite = false;
+    sawRobotIO1394::osaTimeHistogram1394 mReadTimeHistogram;  // slowest port
+    sawRobotIO1394::osaTimeHistogram1394 mWriteTimeHistogram; // slowest port
+    sawRobotIO1394::osaTimeHistogram1394 mWriteWaitHistogram; // time spent waiting for split-phase write
+
+    // bus protocol, automatic mode benchmarks protocols in Startup
+    // and falls back to slower protocols if error rate increases
+    sawRobotIO1394::ProtocolType mProtocol = sawRobotIO1394::PROTOCOL_SEQ_RW;
+    bool mAutoProtocol = false;
+    vctDoubleMat mProtocolBenchmark; // one row per protocol, see BENCHMARK_ enum
+    size_t mTransferErrors = 0;  // failed ReadAllBoards/WriteAllBoards
+    size_t mCheckedCycles = 0;   // cycles since last error rate check
+    size_t mCheckedErrors = 0;   // errors at last error rate check
+
+    // last cycles kept in memory, dumped to file on overrun
+    sawRobotIO1394::osaFlightRecorder1394 * mFlightRecorder = nullptr;
+    double mFlightRecorderThreshold = 0.0;
+    double mFlightRecorderLastDump = 0.0;
+
+    // real-time setup of IO thread, applied in Startup
+    int mRealTimeCPU = -1;      // negative to not set affinity
+    int mRealTimePriority = 0;  // 0 to keep default scheduling, SCHED_FIFO otherwise
+    bool mRealTimeLockMemory = false;
+    std::string mRealTimeStatus = "not configured";
 
     double mWatchdogPeriod = sawRobotIO1394::WatchdogTimeout; // prefered watchdog period for all boards
     bool mSkipConfigurationCheck = false;
     std::string mSaveConfigurationJSON = "";
-
-    std::map<int, AmpIO*> mBoards;
-    typedef std::map<int, AmpIO*>::iterator board_iterator;
-    typedef std::map<int, AmpIO*>::const_iterator board_const_iterator;
+    std::string mConfigurationCacheDirectory = "";
+
+    // multi-rate scheduling, devices with a rate divisor greater than
+    // 1 are only updated on some cycles.  Phases are assigned round
+    // robin per divisor so devices with the same rate don't all run on
+    // the same cycle.  The cycle is advanced by PreRead, or by Read
+    // if Read is called without PreRead (e.g. data-plot)
+    size_t mCycle = 0;
+    bool mCycleStarted = false;
+    std::map<size_t, size_t> mRatePhaseCounters; // indexed by rate divisor
+
+    // digital output changes are merged per board and sent with the
+    // cyclic write
+    struct DigitalOutputBuffer {
+        unsigned int Mask = 0x0;
+        unsigned int Bits = 0x0;
+    };
+
+    // board inventory, firmware version and serial numbers are queried once per board
+    struct BoardInventory {
+        unsigned int FirmwareVersion = 0; // 0 until queried
+        std::string FPGASerialNumber;
+        std::string QLASerialNumber;
+    };
+
+    // per board read statistics, updated every cycle by the IO
+    // thread and copied periodically for the Diagnostics interface
+    struct BoardStatistics {
+        BoardStatistics(void):
+            ReadInterval(sawRobotIO1394::BoardReadIntervalBinWidth,
+                         sawRobotIO1394::BoardReadIntervalNumberOfBins)
+        {}
+        size_t Reads = 0;
+        size_t InvalidReads = 0;
+        size_t InvalidStreak = 0; // current consecutive invalid reads
+        size_t LongestInvalidStreak = 0;
+        size_t Retries = 0;        // re-reads while this board was invalid
+        size_t RecoveredReads = 0; // invalid reads fixed by a re-read
+        size_t UnretriedReads = 0; // invalid reads not retried, other boards on the port were valid
+        sawRobotIO1394::osaTimeHistogram1394 ReadInterval; // time between reads, measured by the FPGA
+    };
+
+    // everything known about a board, allocated once so devices can
+    // keep pointers to the clock while lists of boards are copied
+    struct BoardData {
+        BoardData(AmpIO * board): Board(board) {}
+        AmpIO * Board;
+        BoardInventory Inventory;
+        BoardStatistics Statistics;
+        sawRobotIO1394::osaBoardClock1394 Clock; // updated after each read
+        DigitalOutputBuffer DigitalOutputs;
+    };
+    std::map<int, BoardData*> mBoards; // indexed by port index * MAX_BOARDS + board Id
+    typedef std::map<int, BoardData*>::iterator board_iterator;
+    typedef std::map<int, BoardData*>::const_iterator board_const_iterator;
+
+    double mReadRetryShare = 0.25; // share of remaining cycle time used to re-read
+    double mCycleStartTime = 0.0;
+    mutable std::mutex mDiagnosticsMutex;
+    vctDoubleMat mBoardStatisticsSnapshot; // one row per board, see STATISTICS_ enum
+    vctIntMat mBoardReadIntervalSnapshot;  // one row per board
+    size_t mBoardStatisticsUpdates = 0;    // since last snapshot
+    std::ofstream mDiagnosticsLog;
+    // end of invalid read streaks, recorded by the IO thread in a
+    // ring buffer allocated by UseDiagnosticsLog and written to the
+    // log in Cleanup, oldest entries are overwritten
+    struct RecoveredStreak {
+        double Time;
+        int Board;
+        size_t InvalidStreak;
+    };
+    std::vector<RecoveredStreak> mRecoveredStreaks;
+    size_t mNumberOfRecoveredStreaks = 0; // total since Startup
 
     std::vector<sawRobotIO1394::mtsRobot1394*> mRobots;
     std::map<std::string, sawRobotIO1394::mtsRobot1394*> mRobotsByName;
 
     std::vector<sawRobotIO1394::mtsDigitalInput1394*> mDigitalInputs;
     std::map<std::string, sawRobotIO1394::mtsDigitalInput1394*> mDigitalInputsByName;
+    std::map<int, sawRobotIO1394::mtsDigitalInputBank1394*> mDigitalInputBanks; // indexed by board key
 
     std::vector<sawRobotIO1394::mtsDigitalOutput1394*> mDigitalOutputs;
     std::map<std::string, sawRobotIO1394::mtsDigitalOutput1394*> mDigitalOutputsByName;
@@ -59,6 +189,61 @@ protected:
     std::vector<sawRobotIO1394::mtsDallasChip1394*> mDallasChips;
     std::map<std::string, sawRobotIO1394::mtsDallasChip1394*> mDallasChipsByName;
 
+    std::vector<mtsStateTable *> mStagedStateTables; // used by devices added at runtime, advanced with main state table
+    std::vector<mtsInterfaceProvided *> mInterfaces; // queued commands processed by Run
+
+    // Devices added or removed while running.  Boards, devices,
+    // interfaces and state tables are created in the caller's thread
+    // on a copy of the lists used by the IO thread (mBoards, mRobots,
+    // ...).  At the beginning of a cycle, Run adds/removes boards to
+    // the ports and swaps the lists, without allocating memory.
+    struct DeviceLists {
+        std::map<int, BoardData*> Boards;
+        std::vector<sawRobotIO1394::mtsRobot1394*> Robots;
+        std::map<std::string, sawRobotIO1394::mtsRobot1394*> RobotsByName;
+        std::vector<sawRobotIO1394::mtsDigitalInput1394*> DigitalInputs;
+        std::map<std::string, sawRobotIO1394::mtsDigitalInput1394*> DigitalInputsByName;
+        std::map<int, sawRobotIO1394::mtsDigitalInputBank1394*> DigitalInputBanks;
+        std::vector<sawRobotIO1394::mtsDigitalOutput1394*> DigitalOutputs;
+        std::map<std::string, sawRobotIO1394::mtsDigitalOutput1394*> DigitalOutputsByName;
+        std::vector<sawRobotIO1394::mtsDallasChip1394*> DallasChips;
+        std::map<std::string, sawRobotIO1394::mtsDallasChip1394*> DallasChipsByName;
+        std::vector<mtsStateTable *> StateTables;
+        std::vector<mtsInterfaceProvided *> Interfaces;
+    };
+    struct StagedChanges {
+        DeviceLists Lists; // new lists, previous lists once swapped
+        std::map<int, BoardData*> AddedBoards;
+        std::map<int, BoardData*> RemovedBoards;
+        std::map<int, sawRobotIO1394::mtsDigitalInputBank1394*> AddedBanks;
+        std::map<int, sawRobotIO1394::mtsDigitalInputBank1394*> ReplacedBanks;
+        std::vector<sawRobotIO1394::mtsRobot1394*> AddedRobots;
+        std::vector<sawRobotIO1394::mtsRobot1394*> RemovedRobots;
+        std::vector<sawRobotIO1394::mtsDigitalInput1394*> AddedDigitalInputs;
+        std::vector<sawRobotIO1394::mtsDigitalInput1394*> RemovedDigitalInputs;
+        std::vector<sawRobotIO1394::mtsDigitalOutput1394*> AddedDigitalOutputs;
+        std::vector<sawRobotIO1394::mtsDigitalOutput1394*> RemovedDigitalOutputs;
+        std::vector<sawRobotIO1394::mtsDallasChip1394*> AddedDallasChips;
+        std::vector<sawRobotIO1394::mtsDallasChip1394*> RemovedDallasChips;
+        mtsStateTable * StateTable = nullptr; // used by added digital IOs and Dallas chips
+        std::vector<std::string> InterfaceNames; // created for this change
+    };
+    StagedChanges mStagedChanges; // one change at a time
+    std::atomic<bool> mStagedChangesPending; // set by caller's thread, cleared by Run once swapped
+    std::vector<std::string> mStagingErrors; // sent to robot interfaces by the IO thread
+    std::atomic<bool> mStagingErrorsPending;
+    mutable std::mutex mStagingMutex; // protects staged changes, errors and lists of devices
+    size_t mNumberOfStagedStateTables = 0; // protected by mStagingMutex
+    // removed devices and their boards are kept until the destructor.
+    // Their interfaces are not removed since other components might
+    // still be connected, commands are disabled and robots are
+    // published as invalid
+    std::vector<sawRobotIO1394::mtsRobot1394*> mRetiredRobots;
+    std::vector<sawRobotIO1394::mtsDigitalInput1394*> mRetiredDigitalInputs;
+    std::vector<sawRobotIO1394::mtsDigitalOutput1394*> mRetiredDigitalOutputs;
+    std::vector<sawRobotIO1394::mtsDallasChip1394*> mRetiredDallasChips;
+    std::vector<BoardData*> mRetiredBoards;
+
     // state tables for statistics
     mtsStateTable * mStateTableRead;
     mtsStateTable * mStateTableWrite;
@@ -68,16 +253,120 @@ public:
     // Constructor & Destructor
     mtsRobotIO1394(const std::string & name, const double periodInSeconds, const std::string & port);
     mtsRobotIO1394(const mtsTaskPeriodicConstructorArg & arg); // TODO: add port_num
+    /*! Use ports created by the caller, e.g. ports without hardware
+      for benchmarks.  The component takes ownership of the ports. */
+    mtsRobotIO1394(const std::string & name, const double periodInSeconds,
+                   const std::vector<BasePort *> & ports);
     virtual ~mtsRobotIO1394();
 
+    /*! Set protocol for all ports, exits on failure.  With
+      PROTOCOL_AUTO, all protocols supported by the boards are
+      benchmarked in Startup. */
     void SetProtocol(const sawRobotIO1394::ProtocolType & protocol);
+
+    /*! Write board read statistics to a file in Cleanup, i.e. end of
+      invalid read streaks and summary.  Only the last
+      numberOfStreaks ends of invalid read streaks are kept in
+      memory.  Must be called before Startup. */
+    void UseDiagnosticsLog(const std::string & filename,
+                           const size_t numberOfStreaks = 10000);
+
+    /*! Columns of the matrix returned by GetBoardStatistics, one row
+      per board.  Board is the board key (port index * MAX_BOARDS +
+      board Id), counters are since Startup.  Clock rate is host seconds
+      per FPGA second, see osaBoardClock1394. */
+    enum {STATISTICS_BOARD = 0, STATISTICS_READS, STATISTICS_INVALID_READS,
+          STATISTICS_INVALID_STREAK, STATISTICS_LONGEST_INVALID_STREAK,
+          STATISTICS_RETRIES, STATISTICS_RECOVERED_READS, STATISTICS_UNRETRIED_READS,
+          STATISTICS_CLOCK_RATE, STATISTICS_CLOCK_RESYNCHRONIZATIONS,
+          STATISTICS_NUMBER_OF_COLUMNS};
+
+    /*! When all board reads on a port are invalid, the port is read
+      again as long as the read is expected to end before share *
+      remaining cycle time, up to MaximumReadRetries.  Use 0 to
+      disable retries.  Only whole ports are retried: Amp1394's
+      BasePort reads all boards of a port at once (ReadAllBoards)
+      and there is no public API to read a single board into its
+      AmpIO buffer.  So an invalid board on a port with at least one
+      valid board is NOT retried, since a new read could replace the
+      valid data with an invalid read.  These reads are counted in
+      the STATISTICS_UNRETRIED_READS column.  Boards that stay invalid
+      are handled as usual, i.e. robots only use their own boards. */
+    void SetReadRetryBudget(const double share);
+
+    /*! Columns of the matrix returned by GetProtocolBenchmark, one row
+      per protocol.  Times are averages in seconds over all ports. */
+    enum {BENCHMARK_PROTOCOL = 0, BENCHMARK_SUPPORTED, BENCHMARK_READ_TIME,
+          BENCHMARK_WRITE_TIME, BENCHMARK_ERROR_RATE, BENCHMARK_NUMBER_OF_COLUMNS};
     void SetWatchdogPeriod(const double & periodInSeconds);
 
     void Init(const std::string & port);
+    void Init(const std::vector<BasePort *> & ports);
 
     void SkipConfigurationCheck(const bool skip); // must be called before Configure
-    void SaveConfigurationJSON(const std::string & filename); // must be called before Configure
+    /*! Save configuration files loaded by Configure as JSON, must be
+      called before Configure.  Board Ids are saved as found in the
+      source file and files for port index N > 0 are suffixed with
+      -portN, e.g. config-port1.json. */
+    void SaveConfigurationJSON(const std::string & filename);
+    void UseConfigurationCache(const std::string & directory); // must be called before Configure, empty to disable
     void Configure(const std::string & filename);
+    /*! Configure devices for a given port, i.e. index in the comma
+      separated list of ports provided to the constructor.  Boards are
+      identified internally by port index * MAX_BOARDS + board Id. */
+    void Configure(const std::string & filename, const size_t portIndex);
+    /*! Pin the thread used for a port to a CPU, only used with more
+      than one port.  Must be called before Startup.  Invalid CPU
+      indices are reported as errors and affinity is not set. */
+    void SetPortCPUAffinity(const size_t portIndex, const int cpu);
+    /*! Real-time setup for the IO thread, all applied in Startup
+      (Linux only).  Pin the thread to a CPU (negative to not set
+      affinity, invalid indices are reported as errors), use
+      SCHED_FIFO with the given priority (0 to keep default
+      scheduling) and lock all memory with mlockall, which also
+      prefaults heap (state tables, buffers) and stack.  The result
+      is available with the command GetRealTimeStatus. */
+    void SetRealTimeCPU(const int cpu);
+    void SetRealTimePriority(const int priority);
+    void SetRealTimeLockMemory(const bool lock);
+
+    /*! Keep timings, board validity and number of commands for the
+      last cycles in memory.  They are saved in a file
+      (filePrefix-N.csv) when a cycle takes more than threshold (0
+      for twice the period) or when the average period is
+      exceeded.  At most one dump every 10 seconds. */
+    void UseFlightRecorder(const std::string & filePrefix,
+                           const size_t numberOfCycles = 1000,
+                           const double threshold = 0.0);
+
+    /*! Don't wait for the write to complete at the end of Run, the
+      next Read will wait for it if needed.  This uses a thread even
+      for a single port.  Must be called before Startup. */
+    void UseSplitPhaseWrite(const bool splitPhase);
+
+    /*! Add robots, digital inputs/outputs and Dallas chips from a
+      configuration file while the component is running.  Parsing,
+      checks, boards, interfaces and state tables are handled in the
+      caller's thread, the IO thread swaps the lists of devices at
+      the beginning of the next cycle.  Firmware versions of new
+      boards come from the port's initial bus scan.  Unlike
+      Configure, errors are not fatal, the whole change is rejected
+      and an error is sent to all robot interfaces.  Only one change
+      at a time, waits for the previous change to be applied.  The
+      version without port index uses the first port. */
+    void StageConfiguration(const std::string & filename);
+    void StageConfiguration(const std::string & filename, const size_t portIndex);
+    /*! Same as StageConfiguration for the command
+      StagePortConfiguration, expects the file name and the port
+      index as a string. */
+    void StagePortConfiguration(const std::vector<std::string> & filenameAndPort);
+    /*! Remove a robot, digital input/output or Dallas chip by name
+      while the component is running.  Robots are powered off and
+      boards no longer used are removed from the port at the
+      beginning of the next cycle.  Interfaces are kept, see
+      mRetiredRobots, so the name can't be reused. */
+    void StageRemoval(const std::string & name);
+
     bool SetupRobot(sawRobotIO1394::mtsRobot1394 * robot);
     bool SetupDigitalInput(sawRobotIO1394::mtsDigitalInput1394 * digitalInput);
     bool SetupDigitalOutput(sawRobotIO1394::mtsDigitalOutput1394 * digitalOutput);
@@ -87,6 +376,7 @@ public:
     void AddDigitalOutput(sawRobotIO1394::mtsDigitalOutput1394 * digitalInput);
     void AddDallasChip(sawRobotIO1394::mtsDallasChip1394 * dallasChip);
 
+    void DiscoverBoards(const bool querySerialNumbers = true);
     bool CheckFirmwareVersions(void);
 
     void Startup(void);
@@ -107,6 +397,10 @@ public:
 
 protected:
     void GetNumberOfBoards(int & placeHolder) const;
+    void GetBoardIDs(vctIntVec & placeHolder) const;
+    void GetBoardFirmwareVersions(vctIntVec & placeHolder) const;
+    void GetBoardFPGASerialNumbers(std::vector<std::string> & placeHolder) const;
+    void GetBoardQLASerialNumbers(std::vector<std::string> & placeHolder) const;
     void GetNumberOfActuatorsPerRobot(vctIntVec & placeHolder) const;
     void GetNumberOfBrakesPerRobot(vctIntVec & placeHolder) const;
 
@@ -114,6 +408,72 @@ protected:
     void GetDigitalInputNames(std::vector<std::string> & names) const;
     void GetDigitalOutputNames(std::vector<std::string> & names) const;
 
+    bool LoadConfiguration(const std::string & filename,
+                           sawRobotIO1394::osaPort1394Configuration & config);
+    // add port offset to board Ids, false if port index is invalid
+    bool SetBoardKeys(sawRobotIO1394::osaPort1394Configuration & config,
+                      const size_t portIndex) const;
+    // creates board if needed, added to port when changes are applied
+    BoardData * Board(const int boardKey, StagedChanges & changes);
+    void AddRobot(sawRobotIO1394::mtsRobot1394 * robot, StagedChanges & changes);
+    void AddDigitalInput(sawRobotIO1394::mtsDigitalInput1394 * digitalInput, StagedChanges & changes);
+    void AddDigitalOutput(sawRobotIO1394::mtsDigitalOutput1394 * digitalOutput, StagedChanges & changes);
+    void AddDallasChip(sawRobotIO1394::mtsDallasChip1394 * dallasChip, StagedChanges & changes);
+    void RebuildDigitalInputBank(const int boardKey, StagedChanges & changes);
+    void RemoveUnusedBoards(StagedChanges & changes);
+    bool RemoveDevice(const std::string & name, StagedChanges & changes);
+    void DisableInterface(const std::string & name);
+    void CopyDeviceLists(DeviceLists & lists) const;
+    void SwapDeviceLists(DeviceLists & lists);
+    /*! All provided interfaces of the component.  Run processes
+      queued commands of these interfaces only, interfaces added
+      in another thread are used once the lists are swapped. */
+    void CollectInterfaces(std::vector<mtsInterfaceProvided *> & interfaces);
+    void ApplyStagedChanges(StagedChanges & changes); // IO thread, no allocation
+    void RetireStagedChanges(StagedChanges & changes); // once applied
+    void DiscardStagedChanges(StagedChanges & changes); // never applied
+    bool WaitForStagedChanges(std::unique_lock<std::mutex> & lock);
+    void RejectStagedChanges(const std::string & message);
+    void StartPortWorkers(void);
+    void StopPortWorkers(void);
+    void * PortWorkerLoop(PortWorker * worker);
+    void StartTransfer(const PortOperation operation);
+    void WaitTransfer(void);
+    void TransferAllPorts(const PortOperation operation);
+    void CompletePendingWrite(void);
+    void WriteDigitalOutputs(void);
+    void GetTimeHistogramBinWidth(double & placeHolder) const;
+    void GetProtocol(int & placeHolder) const;
+    void SetupRealTime(void);
+    void GetRealTimeStatus(std::string & placeHolder) const;
+    //! Heap allocations during IO cycles, always 0 unless compiled with allocation guard
+    void GetNumberOfCycleAllocations(int & placeHolder) const;
+    void GetBoardStatistics(vctDoubleMat & placeHolder) const;
+    void GetBoardReadIntervalHistograms(vctIntMat & placeHolder) const;
+    void GetBoardReadIntervalBinWidth(double & placeHolder) const;
+
+    /*! Timeline of IO, port and robot methods, see osaTrace1394.
+      Tracing is process wide so other components can add their own
+      events.  SaveTrace runs in the caller's thread. */
+    void SetTracing(const bool & enable);
+    void SaveTrace(const std::string & filename);
+    void UpdateBoardClocks(void);
+    void UpdateBoardStatistics(void);
+    void RetryInvalidReads(void);
+    void SnapshotBoardStatistics(void);
+    void LogBoardStatistics(void);
+    void GetProtocolBenchmark(vctDoubleMat & placeHolder) const;
+    bool SetPortsProtocol(const sawRobotIO1394::ProtocolType protocol);
+    void BenchmarkProtocols(void);
+    void CheckProtocolErrors(void);
+
+    /*! Save flight recorder, at most once every 10 seconds. */
+    void DumpFlightRecorder(const char * reason);
+    bool SetupRobotInterfaces(sawRobotIO1394::mtsRobot1394 * robot);
+    void ApplyStagedChanges(void);
+    bool BoardInUse(const int boardKey, const DeviceLists & lists) const;
+    size_t NextRatePhase(const size_t rateDivisor);
+
     void PreRead(void);
     void PostRead(void);
     void PreWrite(void);
@@ -0,0 +1,56 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  Author(s):  Anton Deguet
+  Created on: 2021-07-26
+
+  (C) Copyright 2021 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#ifndef _osaAllocationGuard1394_h
+#define _osaAllocationGuard1394_h
+
+#include <cstddef>
+#include <iostream>
+#include <sawRobotIO1394/sawRobotIO1394Export.h>
+
+namespace sawRobotIO1394 {
+
+    /*! Count heap allocations made by a thread between Begin and
+      End.  The guard is only compiled in with the CMake option
+      sawRobotIO1394_ALLOCATION_GUARD, which replaces the global
+      operator new for the whole process.  Otherwise Begin and End
+      do nothing and Count always returns 0.  In debug builds
+      (NDEBUG not defined), the stack of the first allocations is
+      also saved and can be printed with LogStackTraces. */
+    class CISST_EXPORT osaAllocationGuard1394
+    {
+    public:
+        enum {MAX_STACK_TRACES = 16, MAX_STACK_DEPTH = 32};
+
+        //! True if compiled with the allocation guard
+        static bool Available(void);
+
+        //! Count allocations of the current thread until End
+        static void Begin(void);
+        static void End(void);
+
+        //! Number of allocations in guarded sections, all threads
+        static size_t Count(void);
+
+        //! Print saved stack traces, if any
+        static void LogStackTraces(std::ostream & outputStream);
+    };
+
+} // namespace sawRobotIO1394
+
+#endif // _osaAllocationGuard1394_h
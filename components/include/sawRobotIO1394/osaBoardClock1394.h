@@ -0,0 +1,102 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  Author(s):  Anton Deguet
+  Created on: 2021-07-28
+
+  (C) Copyright 2021 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#ifndef _osaBoardClock1394_h
+#define _osaBoardClock1394_h
+
+#include <cstddef>
+#include <sawRobotIO1394/sawRobotIO1394ForwardDeclarations.h>
+#include <sawRobotIO1394/sawRobotIO1394Export.h>
+
+namespace sawRobotIO1394 {
+
+    /*! Clock of one board.  The board timestamp is the number of FPGA
+      clock ticks between the last two read requests.  Update is called
+      once per cycle after a valid read so the timestamp is decoded
+      once for all devices using the board.  The FPGA time is the sum
+      of timestamps since the first read, i.e. exact sample spacing.
+      The sample time is the FPGA time mapped on the host clock
+      (osaGetTime) using the start of each port read.  The mapping is
+      a tracking filter on offset and rate so host jitter is filtered
+      out and the FPGA clock drift is corrected.  Update doesn't
+      allocate memory and can be used in the IO loop. */
+    class CISST_EXPORT osaBoardClock1394
+    {
+    public:
+        inline static double TicksToSeconds(const unsigned int ticks) {
+            return ticks / BoardClockFrequency;
+        }
+
+        void Reset(void);
+
+        /*! Add a sample, ticks from the board timestamp and host
+          time of the read request. */
+        void Update(const unsigned int ticks, const double hostTime);
+
+        /*! Read was invalid.  The board might have received the read
+          request and restarted its timestamp, so the next timestamp
+          (e.g. read retry or next cycle) can't be trusted to cover
+          the time since the last valid read.  The next Update uses
+          the host time for the gap instead. */
+        inline void Invalidate(void) {
+            mGap = true;
+        }
+
+        //! Time between the last two reads, in seconds
+        inline double Elapsed(void) const {
+            return mElapsed;
+        }
+
+        //! FPGA time of the last read, in seconds since first read
+        inline double Time(void) const {
+            return mTime;
+        }
+
+        //! Host time of the last read, drift corrected
+        inline double SampleTime(void) const {
+            return mSampleTime;
+        }
+
+        //! Host time for a given FPGA time
+        inline double HostTime(const double time) const {
+            return mSampleTime + mRate * (time - mTime);
+        }
+
+        //! Host seconds per FPGA second
+        inline double Rate(void) const {
+            return mRate;
+        }
+
+        //! Number of times the host error was too large, e.g. stalled IO loop
+        inline size_t Resynchronizations(void) const {
+            return mResynchronizations;
+        }
+
+    protected:
+        size_t mNumberOfUpdates = 0;
+        size_t mResynchronizations = 0;
+        bool mGap = false;
+        double mElapsed = 0.0;
+        double mTime = 0.0;
+        double mSampleTime = 0.0;
+        double mRate = 1.0;
+    };
+
+} // namespace sawRobotIO1394
+
+#endif // _osaBoardClock1394_h
@@ -0,0 +1,49 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  Author(s):  Anton Deguet
+  Created on: 2021-06-25
+
+  (C) Copyright 2021 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#ifndef _osaCache1394_h
+#define _osaCache1394_h
+
+#include <sawRobotIO1394/osaConfiguration1394.h>
+#include <sawRobotIO1394/sawRobotIO1394Export.h>
+
+namespace sawRobotIO1394 {
+
+    /*! Hash of the content of a configuration file (64 bits FNV-1a,
+      as hexadecimal string).  Returns an empty string if the file
+      can't be read. */
+    std::string CISST_EXPORT osaCache1394FileHash(const std::string & filename);
+
+    /*! Load a configuration from a binary cache file.  The cache is
+      only used if it was created for a configuration file with the
+      same content (see osaCache1394FileHash) and by the same version
+      of sawRobotIO1394.  Returns false if the cache is missing or
+      out of date, in which case config is not modified. */
+    bool CISST_EXPORT osaCache1394LoadPort(const std::string & cacheFilename,
+                                           const std::string & sourceHash,
+                                           osaPort1394Configuration & config);
+
+    /*! Save a configuration, including coupling matrices computed
+      while parsing and analog brakes, to a binary cache file. */
+    bool CISST_EXPORT osaCache1394SavePort(const std::string & cacheFilename,
+                                           const std::string & sourceHash,
+                                           const osaPort1394Configuration & config);
+
+} // namespace sawRobotIO1394
+
+#endif // _osaCache1394_h
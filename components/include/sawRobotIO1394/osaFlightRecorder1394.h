@@ -0,0 +1,91 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  Author(s):  Anton Deguet
+  Created on: 2021-07-19
+
+  (C) Copyright 2021 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#ifndef _osaFlightRecorder1394_h
+#define _osaFlightRecorder1394_h
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cisstOSAbstraction/osaThread.h>
+#include <cisstOSAbstraction/osaThreadSignal.h>
+#include <sawRobotIO1394/sawRobotIO1394Export.h>
+
+namespace sawRobotIO1394 {
+
+    /*! Keep the last cycles in memory and dump them to a file when
+      something went wrong.  Record and Dump are called by the IO
+      thread and don't allocate memory, the file is written by a
+      separate thread.  Each dump is written in a temporary file
+      renamed once complete so readers never see a partial file. */
+    class CISST_EXPORT osaFlightRecorder1394
+    {
+    public:
+        struct Cycle {
+            double StartTime;       // osaGetTime at beginning of cycle
+            double ReadTime;        // read, including retries and conversions
+            double PostReadTime;    // checks and events
+            double CommandsTime;    // connected components and queued commands
+            double WriteTime;
+            double CycleTime;       // total
+            unsigned long long InvalidBoards; // one bit per board key
+            size_t NumberOfCommands; // queued commands processed, i.e. queue depth
+        };
+
+        osaFlightRecorder1394(const std::string & filePrefix,
+                              const size_t numberOfCycles);
+        ~osaFlightRecorder1394();
+
+        inline void Record(const Cycle & cycle) {
+            mCycles[mNext] = cycle;
+            mNext = (mNext + 1) % mCycles.size();
+            if (mCount < mCycles.size()) {
+                mCount++;
+            }
+        }
+
+        /*! Copy the cycles and wake up the writer thread.  Returns
+          false if a dump is already in progress.  Reason must be a
+          string literal. */
+        bool Dump(const char * reason);
+
+        inline size_t NumberOfDumps(void) const {
+            return mNumberOfDumps;
+        }
+
+    protected:
+        void * WriterLoop(int dummy);
+
+        std::string mFilePrefix;
+        std::vector<Cycle> mCycles;   // ring, written by IO thread
+        size_t mNext = 0;
+        size_t mCount = 0;
+        std::vector<Cycle> mSnapshot; // copy being written
+        size_t mSnapshotCount = 0;
+        const char * mReason = "";
+
+        osaThread mThread;
+        osaThreadSignal mSignal;
+        std::atomic<bool> mDumping;
+        std::atomic<bool> mRunning;
+        std::atomic<size_t> mNumberOfDumps;
+    };
+
+} // namespace sawRobotIO1394
+
+#endif // _osaFlightRecorder1394_h
@@ -0,0 +1,50 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  Author(s):  Anton Deguet
+  Created on: 2021-06-21
+
+  (C) Copyright 2021 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#ifndef _osaJSON1394_h
+#define _osaJSON1394_h
+
+#include <cisstCommon/cmnDataFunctionsJSON.h>
+#include <sawRobotIO1394/osaConfiguration1394.h>
+#include <sawRobotIO1394/sawRobotIO1394Export.h>
+
+namespace sawRobotIO1394 {
+
+    /*! Load the configuration from a JSON file.  The expected format
+      is the one generated by osaJSON1394SerializePort (e.g. using the
+      xml-to-json application).  All values are validated and errors
+      are reported with the file, line and column as well as the path
+      of the offending value (e.g. Robots[0].Actuators[2].BoardID).
+      Returns false on errors. */
+    bool CISST_EXPORT osaJSON1394LoadPort(const std::string & filename,
+                                          osaPort1394Configuration & config);
+
+    /*! Same as osaJSON1394LoadPort but exits on errors. */
+    void CISST_EXPORT osaJSON1394ConfigurePort(const std::string & filename,
+                                               osaPort1394Configuration & config);
+
+    /*! Serialize the configuration to JSON.  This adds the analog
+      brakes which are not serialized by
+      osaPort1394Configuration::SerializeTextJSON since they are
+      stored as pointers. */
+    void CISST_EXPORT osaJSON1394SerializePort(const osaPort1394Configuration & config,
+                                               Json::Value & jsonConfig);
+
+} // namespace sawRobotIO1394
+
+#endif // _osaJSON1394_h
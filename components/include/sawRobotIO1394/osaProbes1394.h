@@ -0,0 +1,56 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  Author(s):  Anton Deguet
+  Created on: 2021-07-22
+
+  (C) Copyright 2021 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#ifndef _osaProbes1394_h
+#define _osaProbes1394_h
+
+/*! Statically defined tracepoints (USDT/SDT) for the IO cycle and
+  safety events.  When sawRobotIO1394_HAS_SDT is defined, each probe
+  is a single nop in the library and can be enabled at runtime
+  without rebuilding, e.g.:
+
+    perf buildid-cache --add libsawRobotIO1394.so
+    perf record -e sdt_sawRobotIO1394:read_start -e sched:sched_switch ...
+    bpftrace -e 'usdt:libsawRobotIO1394.so:sawRobotIO1394:write_end { ... }'
+
+  The cycle probes (read_start, read_end, post_read_start, ...) have
+  the cycle number as argument, safety probes have the robot name and
+  the actuator or brake index when relevant.  Without
+  sawRobotIO1394_HAS_SDT, probes and their arguments are compiled
+  out. */
+
+#ifdef sawRobotIO1394_HAS_SDT
+
+#include <sys/sdt.h>
+
+#define SAW_ROBOTIO1394_PROBE(name) \
+    DTRACE_PROBE(sawRobotIO1394, name)
+#define SAW_ROBOTIO1394_PROBE1(name, arg1) \
+    DTRACE_PROBE1(sawRobotIO1394, name, arg1)
+#define SAW_ROBOTIO1394_PROBE2(name, arg1, arg2) \
+    DTRACE_PROBE2(sawRobotIO1394, name, arg1, arg2)
+
+#else
+
+#define SAW_ROBOTIO1394_PROBE(name)
+#define SAW_ROBOTIO1394_PROBE1(name, arg1)
+#define SAW_ROBOTIO1394_PROBE2(name, arg1, arg2)
+
+#endif // sawRobotIO1394_HAS_SDT
+
+#endif // _osaProbes1394_h
@@ -0,0 +1,75 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  Author(s):  Anton Deguet
+  Created on: 2021-07-06
+
+  (C) Copyright 2021 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#ifndef _osaTimeHistogram1394_h
+#define _osaTimeHistogram1394_h
+
+#include <iostream>
+#include <cisstCommon/cmnUnits.h>
+#include <cisstVector/vctDynamicVectorTypes.h>
+#include <sawRobotIO1394/sawRobotIO1394Export.h>
+
+namespace sawRobotIO1394 {
+
+    /*! Histogram of durations using bins of fixed width.  The last
+      bin counts all durations greater than the range.  Counts are
+      stored in a vector so they can be added to a state table.  Add
+      doesn't allocate memory and can be used in the IO loop. */
+    class CISST_EXPORT osaTimeHistogram1394
+    {
+    public:
+        osaTimeHistogram1394(const double binWidth = 0.02 * cmn_ms,
+                             const size_t numberOfBins = 50);
+
+        void SetBins(const double binWidth, const size_t numberOfBins);
+
+        inline void Add(const double duration) {
+            size_t bin = mOverflowBin;
+            if (duration < mRange) {
+                bin = (duration > 0.0) ? static_cast<size_t>(duration / mBinWidth) : 0;
+            }
+            mCounts.Element(bin)++;
+        }
+
+        void Reset(void);
+
+        inline double BinWidth(void) const {
+            return mBinWidth;
+        }
+
+        //! Counts per bin, last element is for durations out of range
+        inline vctIntVec & Counts(void) {
+            return mCounts;
+        }
+
+        inline const vctIntVec & Counts(void) const {
+            return mCounts;
+        }
+
+        void ToStream(std::ostream & outputStream) const;
+
+    protected:
+        double mBinWidth;
+        double mRange;
+        size_t mOverflowBin;
+        vctIntVec mCounts;
+    };
+
+} // namespace sawRobotIO1394
+
+#endif // _osaTimeHistogram1394_h
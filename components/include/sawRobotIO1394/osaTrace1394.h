@@ -0,0 +1,102 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  Author(s):  Anton Deguet
+  Created on: 2021-07-21
+
+  (C) Copyright 2021 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#ifndef _osaTrace1394_h
+#define _osaTrace1394_h
+
+#include <atomic>
+#include <string>
+#include <sawRobotIO1394/sawRobotIO1394Export.h>
+
+namespace sawRobotIO1394 {
+
+    /*! Timeline of begin/end events for all threads, saved in the
+      Chrome trace event JSON format (chrome://tracing or
+      ui.perfetto.dev).  Each thread writes in its own fixed size
+      ring buffer so Begin and End don't lock nor allocate memory,
+      except for the first event of a thread if SetThreadName wasn't
+      called.  Buffers are only allocated once tracing is enabled.
+      When a buffer is full, oldest events are overwritten.  Event
+      names must be string literals. */
+    class CISST_EXPORT osaTrace1394
+    {
+    public:
+        enum {BUFFER_SIZE = 131072}; // events per thread
+
+        /*! Enabling tracing allocates the buffers of all threads
+          already named. */
+        static void Enable(const bool enable);
+
+        static inline bool Enabled(void) {
+            return mEnabled.load(std::memory_order_acquire);
+        }
+
+        /*! Name used for the current thread in the timeline.  The
+          thread buffer is allocated here only if tracing is already
+          enabled. */
+        static void SetThreadName(const std::string & name);
+
+        static inline void Begin(const char * name) {
+            if (Enabled()) {
+                Add(name, 'B');
+            }
+        }
+
+        static inline void End(const char * name) {
+            if (Enabled()) {
+                Add(name, 'E');
+            }
+        }
+
+        /*! Begin on construction and end when going out of scope. */
+        class Scope {
+        public:
+            inline Scope(const char * name):
+                mName(name),
+                mActive(Enabled())
+            {
+                if (mActive) {
+                    Add(mName, 'B');
+                }
+            }
+            inline ~Scope() {
+                if (mActive) {
+                    Add(mName, 'E');
+                }
+            }
+        protected:
+            const char * mName;
+            bool mActive;
+        };
+
+        /*! Drop all events recorded so far. */
+        static void Clear(void);
+
+        /*! Save events of all threads.  Can be called from any thread
+          while tracing, events overwritten during the save are
+          skipped. */
+        static bool Save(const std::string & fileName);
+
+    protected:
+        static void Add(const char * name, const char phase);
+        static std::atomic<bool> mEnabled;
+    };
+
+} // namespace sawRobotIO1394
+
+#endif // _osaTrace1394_h
@@ -37,9 +37,22 @@ namespace sawRobotIO1394 {
           return true;
     }
 
+    /*! Load the configuration from an XML file.  When libxml2 is
+      available, the document is parsed once and each element is
+      visited once.  Otherwise this falls back on XPath queries, see
+      osaXML1394ConfigurePortXPath.  Returns false on errors. */
+    bool CISST_EXPORT osaXML1394LoadPort(const std::string & filename,
+                                         osaPort1394Configuration & config);
+
+    /*! Same as osaXML1394LoadPort but exits on errors. */
     void CISST_EXPORT osaXML1394ConfigurePort(const std::string & filename,
                                               osaPort1394Configuration & config);
 
+    /*! Load the configuration from an XML file using one cmnXMLPath
+      XPath query per value.  Slower, mostly kept for comparison. */
+    void CISST_EXPORT osaXML1394ConfigurePortXPath(const std::string & filename,
+                                                   osaPort1394Configuration & config);
+
     bool CISST_EXPORT osaXML1394ConfigureRobot(cmnXMLPath & xmlConfig,
                                                const int robotIndex,
                                                osaRobot1394Configuration & robot);
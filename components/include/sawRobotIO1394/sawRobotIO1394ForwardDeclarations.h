@@ -28,19 +28,44 @@ namespace sawRobotIO1394 {
 
     class mtsRobot1394;
     class mtsDigitalInput1394;
+    class mtsDigitalInputBank1394;
     class mtsDigitalOutput1394;
     class mtsDallasChip1394;
+    class osaPort1394Configuration;
+    class osaBoardClock1394;
 
-    //! Enum redefined from AmpIO/BasePort
-    typedef enum {PROTOCOL_SEQ_RW, PROTOCOL_SEQ_R_BC_W, PROTOCOL_BC_QRW} ProtocolType;
+    //! Enum redefined from AmpIO/BasePort, PROTOCOL_AUTO benchmarks
+    //! all protocols during Startup and uses the fastest reliable one
+    typedef enum {PROTOCOL_SEQ_RW, PROTOCOL_SEQ_R_BC_W, PROTOCOL_BC_QRW, PROTOCOL_AUTO} ProtocolType;
+
+    //! Protocol benchmark, number of cycles per protocol and maximum error rate
+    const size_t ProtocolBenchmarkCycles = 300;
+    const double ProtocolMaxErrorRate = 0.001;
+    //! Error rate is checked at runtime every ProtocolCheckCycles
+    const size_t ProtocolCheckCycles = 10000;
 
     const double WatchdogTimeout = 30.0 * cmn_ms;
 
     const double MaximumTimeToPower = 3.0 * cmn_s;
 
     const double TimingMaxRatio = 2.0;
+
+    //! Maximum number of port re-reads per cycle when a board read is invalid
+    const size_t MaximumReadRetries = 3;
+
+    //! Histogram of time between reads for each board
+    const double BoardReadIntervalBinWidth = 0.05 * cmn_ms;
+    const size_t BoardReadIntervalNumberOfBins = 60;
     const double TimeBetweenTimingWarnings = 60.0 * cmn_s;
 
+    //! FPGA clock used for board timestamps
+    const double BoardClockFrequency = 49.125e6;
+    //! Correlation of board clocks with host clock, bandwidth in Hz,
+    //! maximum error before re-synchronization and maximum drift
+    const double BoardClockBandwidth = 0.1;
+    const double BoardClockMaximumError = 5.0 * cmn_ms;
+    const double BoardClockMaximumDrift = 0.001;
+
     //! Temperature thresholds
     const double TemperatureWarningThreshold = 60.0;
     const double TemperatureErrorThreshold = 65.0;
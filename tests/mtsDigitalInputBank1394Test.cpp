@@ -0,0 +1,300 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  Author(s):  Anton Deguet
+  Created on: 2021-07-12
+
+  (C) Copyright 2021 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cisstCommon/cmnUnits.h>
+#include <cisstVector/vctDynamicMatrixTypes.h>
+#include <cisstMultiTask/mtsComponent.h>
+#include <cisstParameterTypes/prmEventButton.h>
+
+#include <sawRobotIO1394/mtsDigitalInput1394.h>
+#include <sawRobotIO1394/mtsDigitalInputBank1394.h>
+#include <sawRobotIO1394/osaBoardClock1394.h>
+
+#include "AmpIO.h"
+
+#include <exception>
+#include <string>
+#include <vector>
+
+using namespace sawRobotIO1394;
+
+namespace {
+
+    /*! Debounce and click detection of a single input, same logic
+      as the per-input polling used before all inputs of a board were
+      handled by mtsDigitalInputBank1394. */
+    class PerInputReference {
+    public:
+        PerInputReference(const osaDigitalInput1394Configuration & config):
+            mConfiguration(config),
+            mValue(!config.PressedValue)
+        {}
+
+        void Poll(const unsigned int bits, const double elapsed) {
+            mClicked = false;
+            mPreviousValue = mValue;
+            const bool value = (bits & (0x1u << mConfiguration.BitID))
+                ? (!mConfiguration.PressedValue) : (mConfiguration.PressedValue);
+            if (mConfiguration.DebounceThreshold == 0.0) {
+                mValue = value;
+                return;
+            }
+            if (mDebounceCounter == -1.0) {
+                if (value != mPreviousValue) {
+                    mDebounceCounter = 0.0;
+                    mTransitionValue = value;
+                }
+            } else {
+                if (mDebounceCounter < mConfiguration.DebounceThreshold) {
+                    if (value == mTransitionValue) {
+                        mDebounceCounter += elapsed;
+                    } else {
+                        if (!value && (mDebounceCounter > mConfiguration.DebounceThresholdClick)) {
+                            mClicked = true;
+                        }
+                        mDebounceCounter = -1.0;
+                    }
+                } else {
+                    mValue = value;
+                    mDebounceCounter = -1.0;
+                }
+            }
+        }
+
+        bool Value(void) const {
+            return mValue;
+        }
+
+        bool Clicked(void) const {
+            return mClicked;
+        }
+
+    protected:
+        osaDigitalInput1394Configuration mConfiguration;
+        bool mValue;
+        bool mPreviousValue = false;
+        bool mTransitionValue = false;
+        bool mClicked = false;
+        double mDebounceCounter = -1.0;
+    };
+
+    osaDigitalInput1394Configuration InputConfiguration(const int bit,
+                                                        const bool pressedValue,
+                                                        const double debounce,
+                                                        const double click,
+                                                        const int rateDivisor = 1)
+    {
+        osaDigitalInput1394Configuration config;
+        config.Name = "input" + std::to_string(bit);
+        config.BoardID = 0;
+        config.BitID = bit;
+        config.TriggerWhenPressed = true;
+        config.TriggerWhenReleased = true;
+        config.PressedValue = pressedValue;
+        config.DebounceThreshold = debounce;
+        config.DebounceThresholdClick = click;
+        config.RateDivisor = rateDivisor;
+        return config;
+    }
+
+    size_t NumberOfClicks(const vctDoubleMat & events)
+    {
+        size_t clicks = 0;
+        for (size_t row = 0; row < events.rows(); ++row) {
+            if (events.Element(row, mtsDigitalInput1394::EVENT_TYPE) == prmEventButton::CLICKED) {
+                ++clicks;
+            }
+        }
+        return clicks;
+    }
+}
+
+class mtsDigitalInputBank1394Test : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(mtsDigitalInputBank1394Test);
+    {
+        CPPUNIT_TEST(TestSameAsPerInput);
+        CPPUNIT_TEST(TestClick);
+        CPPUNIT_TEST(TestRateDivisors);
+    }
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp(void) {
+    }
+
+    void tearDown(void) {
+    }
+
+    /*! Bit mask debounce gives the same values and clicks as the per
+      input logic for random bouncing inputs. */
+    void TestSameAsPerInput(void);
+
+    /*! Short press and release is a click, long press is not. */
+    void TestClick(void);
+
+    /*! All inputs on a board must use the same rate divisor. */
+    void TestRateDivisors(void);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(mtsDigitalInputBank1394Test);
+
+void mtsDigitalInputBank1394Test::TestSameAsPerInput(void)
+{
+    mtsComponent owner("digitalInputs");
+    AmpIO board(0);
+    osaBoardClock1394 clock;
+    mtsDigitalInputBank1394 bank(&board, &clock);
+
+    // no debounce, debounce with and without click, both pressed values
+    std::vector<osaDigitalInput1394Configuration> configs;
+    configs.push_back(InputConfiguration(0, false, 0.0, 0.0));
+    configs.push_back(InputConfiguration(1, true, 0.0, 0.0));
+    configs.push_back(InputConfiguration(2, false, 5.0 * cmn_ms, 1.0 * cmn_ms));
+    configs.push_back(InputConfiguration(3, true, 5.0 * cmn_ms, 1.0 * cmn_ms));
+    configs.push_back(InputConfiguration(7, false, 20.0 * cmn_ms, 3.0 * cmn_ms));
+    configs.push_back(InputConfiguration(31, true, 20.0 * cmn_ms, 0.0));
+
+    std::vector<mtsDigitalInput1394 *> inputs;
+    std::vector<PerInputReference> references;
+    for (const auto & config : configs) {
+        inputs.push_back(new mtsDigitalInput1394(owner, config));
+        references.push_back(PerInputReference(config));
+        bank.AddInput(inputs.back());
+    }
+
+    // bits are stable for a random number of cycles, short periods
+    // bounce and produce clicks, long ones change the value
+    unsigned int random = 12345;
+    unsigned int bits = 0xFFFFFFFF;
+    std::vector<size_t> holds(32, 0);
+    double time = 0.0;
+    vctDoubleMat events;
+    size_t totalClicks = 0;
+    size_t totalChanges = 0;
+    for (size_t cycle = 0; cycle < 20000; ++cycle) {
+        for (size_t bit = 0; bit < 32; ++bit) {
+            if (holds[bit] == 0) {
+                random = random * 1103515245 + 12345;
+                holds[bit] = 1 + (random >> 16) % 40;
+                bits ^= (0x1u << bit);
+            }
+            --holds[bit];
+        }
+        // same elapsed time as the bank, rounding matters for thresholds
+        const double previousTime = time;
+        time += 1.0 * cmn_ms;
+        const double elapsed = time - previousTime;
+        bank.Update(bits, time);
+        for (size_t index = 0; index < inputs.size(); ++index) {
+            const bool previous = references[index].Value();
+            references[index].Poll(bits, elapsed);
+            CPPUNIT_ASSERT_EQUAL(references[index].Value(), inputs[index]->Value());
+            if (previous != references[index].Value()) {
+                ++totalChanges;
+            }
+            inputs[index]->GetEdgeEvents(events);
+            const size_t clicks = NumberOfClicks(events);
+            CPPUNIT_ASSERT_EQUAL(references[index].Clicked() ? size_t(1) : size_t(0), clicks);
+            totalClicks += clicks;
+        }
+    }
+    // make sure the sequence covers both cases
+    CPPUNIT_ASSERT(totalChanges > 100);
+    CPPUNIT_ASSERT(totalClicks > 10);
+
+    for (auto & input : inputs) {
+        bank.RemoveInput(input);
+        delete input;
+    }
+}
+
+void mtsDigitalInputBank1394Test::TestClick(void)
+{
+    mtsComponent owner("digitalInputs");
+    AmpIO board(0);
+    osaBoardClock1394 clock;
+    mtsDigitalInputBank1394 bank(&board, &clock);
+
+    // pressed when low, value is true when pressed
+    mtsDigitalInput1394 input(owner, InputConfiguration(4, true, 10.0 * cmn_ms, 2.0 * cmn_ms));
+    bank.AddInput(&input);
+    const unsigned int released = 0x1u << 4;
+    const unsigned int pressed = 0x0;
+
+    double time = 0.0;
+    vctDoubleMat events;
+    size_t clicks = 0;
+    auto hold = [&](const unsigned int bits, const size_t cycles) {
+        for (size_t cycle = 0; cycle < cycles; ++cycle) {
+            time += 1.0 * cmn_ms;
+            bank.Update(bits, time);
+            input.GetEdgeEvents(events);
+            clicks += NumberOfClicks(events);
+        }
+    };
+
+    // short press, value doesn't change, click
+    hold(released, 5);
+    hold(pressed, 5);
+    hold(released, 20);
+    CPPUNIT_ASSERT(!input.Value());
+    CPPUNIT_ASSERT_EQUAL(size_t(1), clicks);
+
+    // long press, value changes once debounced, no click
+    hold(pressed, 20);
+    CPPUNIT_ASSERT(input.Value());
+    hold(released, 20);
+    CPPUNIT_ASSERT(!input.Value());
+    CPPUNIT_ASSERT_EQUAL(size_t(1), clicks);
+
+    // bounce shorter than click threshold, no click
+    hold(pressed, 1);
+    hold(released, 20);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), clicks);
+
+    bank.RemoveInput(&input);
+}
+
+void mtsDigitalInputBank1394Test::TestRateDivisors(void)
+{
+    mtsComponent owner("digitalInputs");
+    AmpIO board(0);
+    osaBoardClock1394 clock;
+    mtsDigitalInputBank1394 bank(&board, &clock);
+
+    mtsDigitalInput1394 first(owner, InputConfiguration(0, false, 0.0, 0.0, 4));
+    mtsDigitalInput1394 second(owner, InputConfiguration(1, false, 0.0, 0.0, 4));
+    mtsDigitalInput1394 third(owner, InputConfiguration(2, false, 0.0, 0.0, 2));
+    bank.AddInput(&first);
+    bank.AddInput(&second);
+    CPPUNIT_ASSERT_EQUAL(size_t(4), bank.RateDivisor());
+    CPPUNIT_ASSERT_THROW(bank.AddInput(&third), std::exception);
+    CPPUNIT_ASSERT_EQUAL(size_t(4), bank.RateDivisor());
+
+    // divisor of remaining inputs once the others are removed
+    bank.RemoveInput(&first);
+    bank.RemoveInput(&second);
+    CPPUNIT_ASSERT(bank.Empty());
+    bank.AddInput(&third);
+    CPPUNIT_ASSERT_EQUAL(size_t(2), bank.RateDivisor());
+    bank.RemoveInput(&third);
+}
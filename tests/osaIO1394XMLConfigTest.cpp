@@ -35,6 +35,12 @@ http://www.cisst.org/cisst/license.txt.
 #include <sawRobotIO1394/mtsRobotIO1394.h>
 #include <sawRobotIO1394/mtsRobot1394.h>
 #include <sawRobotIO1394/osaXML1394.h>
+#include <sawRobotIO1394/osaJSON1394.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
 
 using namespace sawRobotIO1394;
 
@@ -47,6 +53,10 @@ protected:
     {
         //CPPUNIT_TEST(TestCoupling);
         CPPUNIT_TEST(TestConfigure);
+        CPPUNIT_TEST(TestConfigureXPath);
+        CPPUNIT_TEST(TestConfigureJSON);
+        CPPUNIT_TEST(TestConfigureJSONNoCoupling);
+        CPPUNIT_TEST(TestConfigureJSONErrors);
         // CPPUNIT_TEST(TestEncoder);
         // CPPUNIT_TEST(TestDriveAmps);
         // CPPUNIT_TEST(TestDriveNm);
@@ -66,6 +76,10 @@ public:
     /*! Test constructor */
     //void TestCoupling(void);
     void TestConfigure(void);
+    void TestConfigureXPath(void);
+    void TestConfigureJSON(void);
+    void TestConfigureJSONNoCoupling(void);
+    void TestConfigureJSONErrors(void);
     //    void TestEncoder(void);
     //    void TestDriveAmps(void);
     //    void TestDriveNm(void);
@@ -74,6 +88,49 @@ public:
 
 CPPUNIT_TEST_SUITE_REGISTRATION(osaIO1394XMLConfigTest);
 
+namespace {
+
+    /*! Write the document in a temporary file and load it, errors
+      logged by the loader are returned in log. */
+    bool LoadJSON(const std::string & filename, const std::string & document,
+                  sawRobotIO1394::osaPort1394Configuration & config, std::string & log)
+    {
+        std::ofstream jsonFile(filename.c_str());
+        jsonFile << document;
+        jsonFile.close();
+
+        std::stringstream logStream;
+        cmnLogger::AddChannel(logStream, CMN_LOG_ALLOW_ERRORS);
+        const bool result = sawRobotIO1394::osaJSON1394LoadPort(filename, config);
+        cmnLogger::RemoveChannel(logStream);
+        std::remove(filename.c_str());
+        log = logStream.str();
+        return result;
+    }
+
+    /*! Location reported for the value starting at offset. */
+    std::string Location(const std::string & filename, const std::string & document,
+                         const size_t offset)
+    {
+        CPPUNIT_ASSERT(offset != std::string::npos);
+        const size_t lineStart = document.rfind('\n', offset);
+        const size_t line = std::count(document.begin(), document.begin() + offset, '\n') + 1;
+        const size_t column = (lineStart == std::string::npos) ? (offset + 1) : (offset - lineStart);
+        std::ostringstream location;
+        location << filename << ':' << line << ':' << column;
+        return location.str();
+    }
+
+    Json::Value LoadFixture(const std::string & filename)
+    {
+        std::ifstream jsonFile(filename.c_str());
+        Json::Value jsonConfig;
+        Json::Reader reader;
+        CPPUNIT_ASSERT(reader.parse(jsonFile, jsonConfig));
+        return jsonConfig;
+    }
+}
+
 void osaIO1394XMLConfigTest::TestConfigure(void)
 {
     std::string xml_path = cmn_path.Find("sawRobotIO1394TestBoard.xml");
@@ -113,6 +170,182 @@ void osaIO1394XMLConfigTest::TestConfigure(void)
 }
 
 
+void osaIO1394XMLConfigTest::TestConfigureXPath(void)
+{
+    std::string xml_path = cmn_path.Find("sawRobotIO1394TestBoard.xml");
+
+    CPPUNIT_ASSERT(xml_path.length() > 0);
+
+    // single pass and XPath loaders should produce the same configuration
+    sawRobotIO1394::osaPort1394Configuration config, configXPath;
+    sawRobotIO1394::osaXML1394ConfigurePort(xml_path, config);
+    sawRobotIO1394::osaXML1394ConfigurePortXPath(xml_path, configXPath);
+
+    std::stringstream result, resultXPath;
+    config.ToStream(result);
+    configXPath.ToStream(resultXPath);
+    CPPUNIT_ASSERT_EQUAL(resultXPath.str(), result.str());
+
+    CPPUNIT_ASSERT(configXPath.Robots.size() == 1);
+    sawRobotIO1394::osaRobot1394Configuration & robot = config.Robots[0];
+    sawRobotIO1394::osaRobot1394Configuration & robotXPath = configXPath.Robots[0];
+    CPPUNIT_ASSERT_EQUAL(robotXPath.NumberOfBrakes, robot.NumberOfBrakes);
+    for (size_t index = 0; index < robot.Actuators.size(); ++index) {
+        CPPUNIT_ASSERT_EQUAL(robotXPath.Actuators[index].Brake == 0,
+                             robot.Actuators[index].Brake == 0);
+    }
+    CPPUNIT_ASSERT(robot.Coupling.JointToActuatorEffort().AlmostEqual(robotXPath.Coupling.JointToActuatorEffort()));
+}
+
+
+void osaIO1394XMLConfigTest::TestConfigureJSON(void)
+{
+    std::string xml_path = cmn_path.Find("sawRobotIO1394TestBoard.xml");
+
+    CPPUNIT_ASSERT(xml_path.length() > 0);
+
+    // convert XML to JSON and load JSON, both should be the same
+    sawRobotIO1394::osaPort1394Configuration config, configJSON;
+    sawRobotIO1394::osaXML1394ConfigurePort(xml_path, config);
+
+    // temporary file in build tree, removed once loaded
+    const std::string json_path = std::string(sawRobotIO1394Tests_BINARY_DIR) + "/sawRobotIO1394TestBoard.json";
+    Json::Value jsonConfig;
+    sawRobotIO1394::osaJSON1394SerializePort(config, jsonConfig);
+    std::ofstream jsonFile(json_path.c_str());
+    Json::StyledWriter writer;
+    jsonFile << writer.write(jsonConfig);
+    jsonFile.close();
+
+    CPPUNIT_ASSERT(sawRobotIO1394::osaJSON1394LoadPort(json_path, configJSON));
+    std::remove(json_path.c_str());
+
+    std::stringstream result, resultJSON;
+    config.ToStream(result);
+    configJSON.ToStream(resultJSON);
+    CPPUNIT_ASSERT_EQUAL(result.str(), resultJSON.str());
+
+    CPPUNIT_ASSERT(configJSON.Robots.size() == 1);
+    sawRobotIO1394::osaRobot1394Configuration & robot = config.Robots[0];
+    sawRobotIO1394::osaRobot1394Configuration & robotJSON = configJSON.Robots[0];
+    CPPUNIT_ASSERT_EQUAL(robot.NumberOfBrakes, robotJSON.NumberOfBrakes);
+    for (size_t index = 0; index < robot.Actuators.size(); ++index) {
+        CPPUNIT_ASSERT_EQUAL(robot.Actuators[index].Brake == 0,
+                             robotJSON.Actuators[index].Brake == 0);
+    }
+}
+
+
+void osaIO1394XMLConfigTest::TestConfigureJSONNoCoupling(void)
+{
+    std::string json_path = cmn_path.Find("sawRobotIO1394TestBoardNoCoupling.json");
+
+    CPPUNIT_ASSERT(json_path.length() > 0);
+
+    sawRobotIO1394::osaPort1394Configuration config;
+    CPPUNIT_ASSERT(sawRobotIO1394::osaJSON1394LoadPort(json_path, config));
+
+    CPPUNIT_ASSERT(config.Robots.size() == 1);
+    CPPUNIT_ASSERT(config.DigitalInputs.size() == 1);
+    CPPUNIT_ASSERT(config.DigitalOutputs.size() == 1);
+    CPPUNIT_ASSERT(config.DallasChips.size() == 0);
+
+    sawRobotIO1394::osaRobot1394Configuration & robot = config.Robots[0];
+    CPPUNIT_ASSERT(robot.Name == "Robot");
+    CPPUNIT_ASSERT(robot.NumberOfActuators == 2);
+    CPPUNIT_ASSERT(robot.NumberOfJoints == 2);
+    CPPUNIT_ASSERT(robot.HasActuatorToJointCoupling == false);
+    CPPUNIT_ASSERT(robot.PotLocation == osaPot1394Location::POTENTIOMETER_ON_JOINTS);
+    CPPUNIT_ASSERT(robot.PotTolerances.size() == 2);
+    CPPUNIT_ASSERT(robot.Actuators[0].JointType == PRM_JOINT_REVOLUTE);
+    CPPUNIT_ASSERT(robot.Actuators[1].JointType == PRM_JOINT_PRISMATIC);
+    CPPUNIT_ASSERT(robot.Actuators[0].Encoder.VelocityEstimator == osaVelocityEstimator1394::VELOCITY_LEAST_SQUARES);
+    CPPUNIT_ASSERT(robot.Actuators[0].Encoder.VelocityWindow == 16);
+    CPPUNIT_ASSERT(robot.NumberOfBrakes == 1);
+    CPPUNIT_ASSERT(robot.Actuators[0].Brake == 0);
+    CPPUNIT_ASSERT(robot.Actuators[1].Brake != 0);
+    CPPUNIT_ASSERT(robot.Actuators[1].Brake->AxisID == 2);
+
+    // serialize and load again, both should be the same
+    const std::string copy_path = std::string(sawRobotIO1394Tests_BINARY_DIR) + "/sawRobotIO1394TestBoardNoCouplingCopy.json";
+    Json::Value jsonConfig;
+    sawRobotIO1394::osaJSON1394SerializePort(config, jsonConfig);
+    Json::StyledWriter writer;
+    sawRobotIO1394::osaPort1394Configuration configCopy;
+    std::string log;
+    CPPUNIT_ASSERT(LoadJSON(copy_path, writer.write(jsonConfig), configCopy, log));
+
+    std::stringstream result, resultCopy;
+    config.ToStream(result);
+    configCopy.ToStream(resultCopy);
+    CPPUNIT_ASSERT_EQUAL(result.str(), resultCopy.str());
+}
+
+
+void osaIO1394XMLConfigTest::TestConfigureJSONErrors(void)
+{
+    const std::string json_path = std::string(sawRobotIO1394Tests_BINARY_DIR) + "/sawRobotIO1394Errors.json";
+    sawRobotIO1394::osaPort1394Configuration config;
+    std::string log;
+
+    // syntax error
+    CPPUNIT_ASSERT(!LoadJSON(json_path, "{\n  \"DigitalInputs\": [\n}\n", config, log));
+    CPPUNIT_ASSERT(log.find("failed to parse") != std::string::npos);
+
+    // empty configuration
+    config = sawRobotIO1394::osaPort1394Configuration();
+    CPPUNIT_ASSERT(!LoadJSON(json_path, "{\n}\n", config, log));
+    CPPUNIT_ASSERT(log.find(json_path + ":1:1: <root>: doesn't contain any") != std::string::npos);
+
+    // values out of range, wrong types and missing members, all
+    // reported with the location of the offending value
+    std::string document =
+        "{\n"
+        "  \"DigitalInputs\": [\n"
+        "    {\"Name\": \"input\", \"BoardID\": 16, \"BitID\": 0},\n"
+        "    {\"Name\": \"fast\", \"BoardID\": 0, \"BitID\": 1, \"DebounceThreshold\": \"fast\"}\n"
+        "  ],\n"
+        "  \"DigitalOutputs\": [\n"
+        "    {\"BoardID\": 0, \"BitID\": 2, \"RateDivisor\": 0}\n"
+        "  ]\n"
+        "}\n";
+    config = sawRobotIO1394::osaPort1394Configuration();
+    CPPUNIT_ASSERT(!LoadJSON(json_path, document, config, log));
+    CPPUNIT_ASSERT(log.find(Location(json_path, document, document.find("16"))
+                            + ": DigitalInputs[0].BoardID: must be between 0 and 15, found 16") != std::string::npos);
+    CPPUNIT_ASSERT(log.find(Location(json_path, document, document.find("\"fast\"}"))
+                            + ": DigitalInputs[1].DebounceThreshold: must be a number") != std::string::npos);
+    CPPUNIT_ASSERT(log.find(Location(json_path, document, document.find("{\"BoardID\": 0"))
+                            + ": DigitalOutputs[0]: \"Name\" is required but not found") != std::string::npos);
+    CPPUNIT_ASSERT(log.find(Location(json_path, document, document.find("0}", document.find("RateDivisor")))
+                            + ": DigitalOutputs[0].RateDivisor: must be 1 or greater") != std::string::npos);
+    CPPUNIT_ASSERT(log.find("found 4 error(s)") != std::string::npos);
+
+    // coupling with wrong size and number of brakes not matching
+    // actuators, starting from the valid fixture
+    std::string fixture_path = cmn_path.Find("sawRobotIO1394TestBoardNoCoupling.json");
+    CPPUNIT_ASSERT(fixture_path.length() > 0);
+    Json::Value jsonConfig = LoadFixture(fixture_path);
+    jsonConfig["Robots"][0]["HasActuatorToJointCoupling"] = true;
+    jsonConfig["Robots"][0]["NumberOfBrakes"] = 2;
+    Json::Value row(Json::arrayValue);
+    row.append(1.0);
+    row.append(0.0);
+    jsonConfig["Robots"][0]["Coupling"]["ActuatorToJointPosition"].append(row);
+    Json::StyledWriter writer;
+    document = writer.write(jsonConfig);
+    config = sawRobotIO1394::osaPort1394Configuration();
+    CPPUNIT_ASSERT(!LoadJSON(json_path, document, config, log));
+    CPPUNIT_ASSERT(log.find(Location(json_path, document,
+                                     document.find('[', document.find("\"ActuatorToJointPosition\"")))
+                            + ": Robots[0].Coupling.ActuatorToJointPosition: must have 2 rows, found 1") != std::string::npos);
+    CPPUNIT_ASSERT(log.find(Location(json_path, document,
+                                     document.find('2', document.find("\"NumberOfBrakes\"")))
+                            + ": Robots[0].NumberOfBrakes: found 1 actuator(s) with a Brake") != std::string::npos);
+    CPPUNIT_ASSERT(log.find("found 2 error(s)") != std::string::npos);
+}
+
+
 #if 0
 void osaIO1394XMLConfigTest::TestCoupling(void)
 {